@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <mnist.h>
+#include <fast_rand.h>
+#include <fast_rand_seed.h>
+#include <logging.h>
+#include <timer.h>
+
+#include "synth.h"
+#include "report.h"
+
+static const char* TAG = "lime-tm-bench";
+
+#define N_INPUT          64
+#define MIN_SAMPLE_NS    50000
+#define MAX_BATCH        (1u << 24)
+#define IMG_ROWS         28
+#define IMG_COLS         28
+
+typedef struct {
+    Tsetlin* model;       // read-only benchmarks
+    Tsetlin* trained;     // benchmarks that update states
+    uint8_t* inputs;      // N_INPUT booleanized inputs
+    uint8_t* img;         // grayscale image for booleanization
+    int32_t* votes;
+
+    double literals_per_clause;
+    double literals_per_model;
+
+    volatile uint32_t sink;
+} bench_ctx_t;
+
+typedef struct {
+    const char* name;
+    void (*run)(bench_ctx_t* ctx, uint32_t n);
+    double (*literals)(const bench_ctx_t* ctx);   // per op, NULL if not meaningful
+} bench_t;
+
+static const uint8_t* input_at(const bench_ctx_t* ctx, uint32_t i) {
+    return ctx->inputs + (size_t)(i % N_INPUT) * ctx->model->n_feature;
+}
+
+static ClauseCompressed* clause_at(Tsetlin* model, uint32_t i) {
+    return model->clauses_compressed[i % model->n_clause];
+}
+
+static void run_clause_evaluate(bench_ctx_t* ctx, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+        sum += clause_evaluate(clause_at(ctx->model, i), (uint8_t*)input_at(ctx, i), ctx->model->n_state, ctx->model->n_feature);
+    ctx->sink += sum;
+}
+
+static void run_clause_update_type_I(bench_ctx_t* ctx, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+        sum += clause_update_type_I(clause_at(ctx->trained, i), (uint8_t*)input_at(ctx, i), (int8_t)(i & 1),
+                                    ctx->trained->n_state, ctx->trained->n_feature, 7.5f);
+    ctx->sink += sum;
+}
+
+static void run_clause_update_type_II(bench_ctx_t* ctx, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+        sum += clause_update_type_II(clause_at(ctx->trained, i), (uint8_t*)input_at(ctx, i),
+                                     ctx->trained->n_state, ctx->trained->n_feature);
+    ctx->sink += sum;
+}
+
+static void run_tsetlin_evaluate(bench_ctx_t* ctx, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t predicted;
+        tsetlin_evaluate(ctx->model, (uint8_t*)input_at(ctx, i), ctx->votes, &predicted);
+        sum += predicted;
+    }
+    ctx->sink += sum;
+}
+
+static void run_tsetlin_step(bench_ctx_t* ctx, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++)
+        tsetlin_step(ctx->trained, (uint8_t*)input_at(ctx, i), (int8_t)(i % ctx->trained->n_class), 10, 7.5f);
+}
+
+static void run_pcg32_fast(bench_ctx_t* ctx, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+        sum += pcg32_fast();
+    ctx->sink += sum;
+}
+
+static void run_xorshift128p_fast(bench_ctx_t* ctx, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+        sum += xorshift128p_fast();
+    ctx->sink += sum;
+}
+
+static void run_random_float_01(bench_ctx_t* ctx, uint32_t n) {
+    float sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+        sum += random_float_01();
+    ctx->sink += (uint32_t)sum;
+}
+
+static void run_booleanize_n_bit(bench_ctx_t* ctx, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t* bits = mnist_booleanize_img_n_bit(ctx->img, IMG_ROWS, IMG_COLS, 8);
+        ctx->sink += bits ? bits[i % (IMG_ROWS * IMG_COLS * 8)] : 0;
+        free(bits);
+    }
+}
+
+static void run_booleanize_threshold(bench_ctx_t* ctx, uint32_t n) {
+    uint8_t img[IMG_ROWS * IMG_COLS];
+    for (uint32_t i = 0; i < n; i++) {
+        memcpy(img, ctx->img, sizeof(img));
+        mnist_booleanize_img(img, sizeof(img), 75);
+        ctx->sink += img[i % sizeof(img)];
+    }
+}
+
+static double literals_clause(const bench_ctx_t* ctx) {
+    return ctx->literals_per_clause;
+}
+
+static double literals_model(const bench_ctx_t* ctx) {
+    return ctx->literals_per_model;
+}
+
+static double literals_n_bit(const bench_ctx_t* ctx) {
+    (void)ctx;
+    return IMG_ROWS * IMG_COLS * 8;
+}
+
+static double literals_threshold(const bench_ctx_t* ctx) {
+    (void)ctx;
+    return IMG_ROWS * IMG_COLS;
+}
+
+static const bench_t BENCHES[] = {
+    { "clause_evaluate",       run_clause_evaluate,       literals_clause },
+    { "clause_update_type_I",  run_clause_update_type_I,  literals_clause },
+    { "clause_update_type_II", run_clause_update_type_II, literals_clause },
+    { "tsetlin_evaluate",      run_tsetlin_evaluate,      literals_model },
+    { "tsetlin_step",          run_tsetlin_step,          NULL },
+    { "pcg32_fast",            run_pcg32_fast,            NULL },
+    { "xorshift128p_fast",     run_xorshift128p_fast,     NULL },
+    { "random_float_01",       run_random_float_01,       NULL },
+    { "booleanize_n_bit",      run_booleanize_n_bit,      literals_n_bit },
+    { "booleanize_threshold",  run_booleanize_threshold,  literals_threshold },
+};
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, uint32_t n, double p) {
+    uint32_t i = (uint32_t)(p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+// Warm up, pick a batch that takes at least MIN_SAMPLE_NS, then time
+// n_sample batches and report per-op percentiles
+static void measure(const bench_t* b, bench_ctx_t* ctx, uint32_t n_warmup, uint32_t n_sample, double* ns, report_result_t* r) {
+    b->run(ctx, n_warmup);
+
+    uint32_t batch = 1;
+    for (;;) {
+        uint64_t start = perf_now_ns();
+        b->run(ctx, batch);
+        if (perf_now_ns() - start >= MIN_SAMPLE_NS || batch >= MAX_BATCH)
+            break;
+        batch *= 2;
+    }
+
+    for (uint32_t s = 0; s < n_sample; s++) {
+        uint64_t start = perf_now_ns();
+        b->run(ctx, batch);
+        ns[s] = (double)(perf_now_ns() - start) / batch;
+    }
+    qsort(ns, n_sample, sizeof(double), compare_double);
+
+    memset(r, 0, sizeof(*r));
+    strncpy(r->name, b->name, sizeof(r->name) - 1);
+    r->min_ns = ns[0];
+    r->p50_ns = percentile(ns, n_sample, 0.50);
+    r->p90_ns = percentile(ns, n_sample, 0.90);
+    r->p99_ns = percentile(ns, n_sample, 0.99);
+    if (b->literals && r->p50_ns > 0)
+        r->literals_per_s = b->literals(ctx) / r->p50_ns * 1e9;
+
+    printf("%-22s %10.1f %10.1f %10.1f %10.1f", b->name, r->min_ns, r->p50_ns, r->p90_ns, r->p99_ns);
+    if (r->literals_per_s > 0)
+        printf(" %12.3g\n", r->literals_per_s);
+    else
+        printf(" %12s\n", "-");
+}
+
+static double count_literals(const Tsetlin* model, size_t n) {
+    double total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += model->clauses_compressed[i]->n_pos_literal + model->clauses_compressed[i]->n_neg_literal;
+    return total;
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [options] [name-filter]\n", prog);
+    printf("  --classes N    n_class of the synthetic model (10)\n");
+    printf("  --features N   n_feature (6272)\n");
+    printf("  --clauses N    n_clause per class (200)\n");
+    printf("  --states N     n_state (100)\n");
+    printf("  --density F    literals stored per clause and polarity, as a fraction of n_feature (0.01)\n");
+    printf("  --include F    fraction of stored literals that are included (0.5)\n");
+    printf("  --sparsity F   fraction of input features set (0.5)\n");
+    printf("  --samples N    timed batches per benchmark (101)\n");
+    printf("  --warmup N     untimed ops before measuring (1000)\n");
+    printf("  --seed N       model and input seed (1)\n");
+    printf("  --json PATH    write the results and machine details as JSON\n");
+    printf("  --baseline P   compare p50 against a report written by --json and exit\n");
+    printf("                 with 2 if any benchmark got slower than the tolerance\n");
+    printf("  --tolerance F  allowed slowdown against the baseline (0.10)\n");
+    printf("literals/s counts the literals stored in what one op visits, so it is\n");
+    printf("an upper bound for kernels that stop at the first false literal.\n");
+}
+
+int main(int argc, char** argv) {
+    synth_model_config_t cfg;
+    synth_model_defaults(&cfg);
+
+    float sparsity = 0.5f;
+    uint32_t n_sample = 101;
+    uint32_t n_warmup = 1000;
+    const char* filter = NULL;
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+    double tolerance = 0.10;
+
+    for (int arg = 1; arg < argc; arg++) {
+        const char* opt = argv[arg];
+        const char* val = (arg + 1 < argc) ? argv[arg + 1] : NULL;
+
+        if (strncmp(opt, "--", 2) != 0) {
+            filter = opt;
+            continue;
+        }
+        if (!val) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (strcmp(opt, "--classes") == 0)       cfg.n_class = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--features") == 0) cfg.n_feature = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--clauses") == 0)  cfg.n_clause = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--states") == 0)   cfg.n_state = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--density") == 0)  cfg.density = (float)strtod(val, NULL);
+        else if (strcmp(opt, "--include") == 0)  cfg.include = (float)strtod(val, NULL);
+        else if (strcmp(opt, "--sparsity") == 0) sparsity = (float)strtod(val, NULL);
+        else if (strcmp(opt, "--samples") == 0)  n_sample = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--warmup") == 0)   n_warmup = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--seed") == 0)     cfg.seed = strtoull(val, NULL, 10);
+        else if (strcmp(opt, "--json") == 0)     json_path = val;
+        else if (strcmp(opt, "--baseline") == 0) baseline_path = val;
+        else if (strcmp(opt, "--tolerance") == 0) tolerance = strtod(val, NULL);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+        arg++;
+    }
+    if (n_sample == 0)
+        n_sample = 1;
+
+    // Load the baseline first, a bad path should not cost a whole run
+    report_t* baseline = NULL;
+    if (baseline_path) {
+        baseline = (report_t*)malloc(sizeof(report_t));
+        if (!baseline || report_load(baseline, baseline_path) != 0) {
+            free(baseline);
+            return 1;
+        }
+    }
+
+    report_t* report = (report_t*)calloc(1, sizeof(report_t));
+    if (!report) {
+        LOGE(TAG, "Failed to allocate memory");
+        free(baseline);
+        return 1;
+    }
+    report_machine_info(&report->machine);
+    report->cfg = cfg;
+    report->sparsity = sparsity;
+    report->n_sample = n_sample;
+    report->n_warmup = n_warmup;
+
+    bench_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.model = synth_model(&cfg);
+    ctx.trained = synth_model(&cfg);
+    if (!ctx.model || !ctx.trained) {
+        LOGE(TAG, "Failed to build the synthetic model");
+        tsetlin_free(ctx.model);
+        tsetlin_free(ctx.trained);
+        free(report);
+        free(baseline);
+        return 1;
+    }
+
+    ctx.inputs = (uint8_t*)malloc((size_t)N_INPUT * cfg.n_feature);
+    ctx.img = (uint8_t*)malloc(IMG_ROWS * IMG_COLS);
+    ctx.votes = (int32_t*)malloc(sizeof(int32_t) * cfg.n_class);
+    double* ns = (double*)malloc(sizeof(double) * n_sample);
+    if (!ctx.inputs || !ctx.img || !ctx.votes || !ns) {
+        LOGE(TAG, "Failed to allocate memory");
+        return 1;
+    }
+
+    uint64_t state = cfg.seed * 2 + 1;
+    for (uint32_t i = 0; i < N_INPUT; i++)
+        synth_input(ctx.inputs + (size_t)i * cfg.n_feature, cfg.n_feature, sparsity, &state);
+    for (uint32_t k = 0; k < IMG_ROWS * IMG_COLS; k++)
+        ctx.img[k] = (uint8_t)pcg32_fast_r(&state);
+
+    size_t n_total = (size_t)cfg.n_class * cfg.n_clause;
+    ctx.literals_per_model = count_literals(ctx.model, n_total);
+    ctx.literals_per_clause = count_literals(ctx.model, cfg.n_clause) / cfg.n_clause;
+
+    pcg32_seed(cfg.seed);
+    xorshift128p_seed(cfg.seed);
+
+    printf("model: %lu classes, %lu features, %lu clauses, %lu states, density %.3f, include %.2f, input sparsity %.2f\n",
+           (unsigned long)cfg.n_class, (unsigned long)cfg.n_feature, (unsigned long)cfg.n_clause,
+           (unsigned long)cfg.n_state, cfg.density, cfg.include, sparsity);
+    printf("%lu samples per benchmark after %lu warm-up ops\n\n", (unsigned long)n_sample, (unsigned long)n_warmup);
+    printf("%-22s %10s %10s %10s %10s %12s\n", "benchmark", "min ns/op", "p50 ns/op", "p90 ns/op", "p99 ns/op", "literals/s");
+
+    for (size_t b = 0; b < sizeof(BENCHES) / sizeof(BENCHES[0]); b++) {
+        if (filter && !strstr(BENCHES[b].name, filter))
+            continue;
+        if (report->n_result < REPORT_MAX_RESULT)
+            measure(&BENCHES[b], &ctx, n_warmup, n_sample, ns, &report->results[report->n_result++]);
+    }
+
+    int ret = 0;
+    if (json_path && report_save(report, json_path) != 0) {
+        LOGE(TAG, "Failed to save %s", json_path);
+        ret = 1;
+    }
+
+    if (baseline) {
+        int n_regression = report_compare(baseline, report, tolerance);
+        if (n_regression < 0) {
+            ret = 1;
+        } else if (n_regression > 0) {
+            LOGE(TAG, "%d benchmark(s) slower than the baseline", n_regression);
+            ret = 2;
+        }
+    }
+
+    tsetlin_free(ctx.model);
+    tsetlin_free(ctx.trained);
+    free(ctx.inputs);
+    free(ctx.img);
+    free(ctx.votes);
+    free(ns);
+    free(report);
+    free(baseline);
+
+    return ret;
+}
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <logging.h>
+
+#include "report.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <sys/utsname.h>
+#endif
+
+static const char* TAG = "report";
+
+static void copy_str(char* dst, const char* src) {
+    strncpy(dst, src, REPORT_STR_SIZE - 1);
+    dst[REPORT_STR_SIZE - 1] = '\0';
+}
+
+static void append_str(char* dst, const char* src) {
+    size_t len = strlen(dst);
+    strncat(dst, src, REPORT_STR_SIZE - 1 - len);
+}
+
+// First "model name" in /proc/cpuinfo, where there is one
+static void cpu_name(char* out) {
+    copy_str(out, "unknown");
+
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (!f)
+        return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char* colon = strchr(line, ':');
+        if (strncmp(line, "model name", 10) != 0 || !colon)
+            continue;
+
+        colon++;
+        while (*colon == ' ' || *colon == '\t')
+            colon++;
+        colon[strcspn(colon, "\r\n")] = '\0';
+        copy_str(out, colon);
+        break;
+    }
+    fclose(f);
+}
+
+void report_machine_info(report_machine_t* machine) {
+    memset(machine, 0, sizeof(*machine));
+
+#ifdef _WIN32
+    DWORD size = REPORT_STR_SIZE;
+    if (!GetComputerNameA(machine->host, &size))
+        copy_str(machine->host, "unknown");
+    copy_str(machine->os, "Windows");
+
+    SYSTEM_INFO info;
+    GetNativeSystemInfo(&info);
+    machine->n_cpu = (uint32_t)info.dwNumberOfProcessors;
+    switch (info.wProcessorArchitecture) {
+        case PROCESSOR_ARCHITECTURE_AMD64: copy_str(machine->arch, "x86_64"); break;
+        case PROCESSOR_ARCHITECTURE_ARM64: copy_str(machine->arch, "arm64"); break;
+        case PROCESSOR_ARCHITECTURE_INTEL: copy_str(machine->arch, "x86"); break;
+        default:                           copy_str(machine->arch, "unknown"); break;
+    }
+#else
+    if (gethostname(machine->host, REPORT_STR_SIZE - 1) != 0)
+        copy_str(machine->host, "unknown");
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        copy_str(machine->os, uts.sysname);
+        append_str(machine->os, " ");
+        append_str(machine->os, uts.release);
+        copy_str(machine->arch, uts.machine);
+    } else {
+        copy_str(machine->os, "unknown");
+        copy_str(machine->arch, "unknown");
+    }
+
+    long n_cpu = sysconf(_SC_NPROCESSORS_ONLN);
+    machine->n_cpu = n_cpu > 0 ? (uint32_t)n_cpu : 0;
+#endif
+
+    cpu_name(machine->cpu);
+
+#if defined(__clang__)
+    snprintf(machine->compiler, REPORT_STR_SIZE, "clang %s", __clang_version__);
+#elif defined(__GNUC__)
+    snprintf(machine->compiler, REPORT_STR_SIZE, "gcc %s", __VERSION__);
+#elif defined(_MSC_VER)
+    snprintf(machine->compiler, REPORT_STR_SIZE, "msvc %d", _MSC_FULL_VER);
+#else
+    copy_str(machine->compiler, "unknown");
+#endif
+
+    time_t now = time(NULL);
+    struct tm* utc = gmtime(&now);
+    if (!utc || strftime(machine->date, REPORT_STR_SIZE, "%Y-%m-%dT%H:%M:%SZ", utc) == 0)
+        copy_str(machine->date, "unknown");
+}
+
+static void write_str(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+int report_save(const report_t* report, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    const report_machine_t* m = &report->machine;
+    fprintf(f, "{\n  \"machine\": {\n");
+    fprintf(f, "    \"host\": ");     write_str(f, m->host);     fprintf(f, ",\n");
+    fprintf(f, "    \"os\": ");       write_str(f, m->os);       fprintf(f, ",\n");
+    fprintf(f, "    \"arch\": ");     write_str(f, m->arch);     fprintf(f, ",\n");
+    fprintf(f, "    \"cpu\": ");      write_str(f, m->cpu);      fprintf(f, ",\n");
+    fprintf(f, "    \"n_cpu\": %lu,\n", (unsigned long)m->n_cpu);
+    fprintf(f, "    \"compiler\": "); write_str(f, m->compiler); fprintf(f, ",\n");
+    fprintf(f, "    \"date\": ");     write_str(f, m->date);     fprintf(f, "\n  },\n");
+
+    const synth_model_config_t* cfg = &report->cfg;
+    fprintf(f, "  \"config\": {\n");
+    fprintf(f, "    \"n_class\": %lu,\n", (unsigned long)cfg->n_class);
+    fprintf(f, "    \"n_feature\": %lu,\n", (unsigned long)cfg->n_feature);
+    fprintf(f, "    \"n_clause\": %lu,\n", (unsigned long)cfg->n_clause);
+    fprintf(f, "    \"n_state\": %lu,\n", (unsigned long)cfg->n_state);
+    fprintf(f, "    \"density\": %.9g,\n", cfg->density);
+    fprintf(f, "    \"include\": %.9g,\n", cfg->include);
+    fprintf(f, "    \"sparsity\": %.9g,\n", report->sparsity);
+    fprintf(f, "    \"samples\": %lu,\n", (unsigned long)report->n_sample);
+    fprintf(f, "    \"warmup\": %lu,\n", (unsigned long)report->n_warmup);
+    fprintf(f, "    \"seed\": %llu\n  },\n", (unsigned long long)cfg->seed);
+
+    fprintf(f, "  \"benchmarks\": [");
+    for (uint32_t i = 0; i < report->n_result; i++) {
+        const report_result_t* r = &report->results[i];
+        fprintf(f, "%s\n    { \"name\": ", i ? "," : "");
+        write_str(f, r->name);
+        fprintf(f, ", \"min_ns\": %.6g, \"p50_ns\": %.6g, \"p90_ns\": %.6g, \"p99_ns\": %.6g, \"literals_per_s\": %.6g }",
+                r->min_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->literals_per_s);
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    return (ferror(f) == 0 && fclose(f) == 0) ? 0 : -1;
+}
+
+// Value of "key" between begin and end, NULL if absent
+static const char* find_value(const char* begin, const char* end, const char* key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+
+    const char* p = strstr(begin, pattern);
+    if (!p || p >= end)
+        return NULL;
+
+    p += strlen(pattern);
+    while (*p == ' ')
+        p++;
+    return p;
+}
+
+static void read_str(const char* begin, const char* end, const char* key, char* out) {
+    out[0] = '\0';
+
+    const char* p = find_value(begin, end, key);
+    if (!p || *p != '"')
+        return;
+
+    size_t n = 0;
+    for (p++; *p && *p != '"' && n < REPORT_STR_SIZE - 1; p++) {
+        if (*p == '\\' && p[1])
+            p++;
+        out[n++] = *p;
+    }
+    out[n] = '\0';
+}
+
+static double read_num(const char* begin, const char* end, const char* key) {
+    const char* p = find_value(begin, end, key);
+    return p ? strtod(p, NULL) : 0;
+}
+
+int report_load(report_t* report, const char* path) {
+    memset(report, 0, sizeof(*report));
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char* text = (char*)malloc(size > 0 ? (size_t)size + 1 : 1);
+    if (!text) {
+        LOGE(TAG, "Failed to allocate memory");
+        fclose(f);
+        return -1;
+    }
+    size_t n_read = size > 0 ? fread(text, 1, (size_t)size, f) : 0;
+    text[n_read] = '\0';
+    fclose(f);
+
+    const char* machine = strstr(text, "\"machine\":");
+    const char* config = strstr(text, "\"config\":");
+    const char* bench = strstr(text, "\"benchmarks\":");
+    if (!machine || !config || !bench || machine > config || config > bench) {
+        LOGE(TAG, "%s is not a benchmark report", path);
+        free(text);
+        return -1;
+    }
+
+    report_machine_t* m = &report->machine;
+    read_str(machine, config, "host", m->host);
+    read_str(machine, config, "os", m->os);
+    read_str(machine, config, "arch", m->arch);
+    read_str(machine, config, "cpu", m->cpu);
+    read_str(machine, config, "compiler", m->compiler);
+    read_str(machine, config, "date", m->date);
+    m->n_cpu = (uint32_t)read_num(machine, config, "n_cpu");
+
+    synth_model_config_t* cfg = &report->cfg;
+    cfg->n_class = (uint32_t)read_num(config, bench, "n_class");
+    cfg->n_feature = (uint32_t)read_num(config, bench, "n_feature");
+    cfg->n_clause = (uint32_t)read_num(config, bench, "n_clause");
+    cfg->n_state = (uint32_t)read_num(config, bench, "n_state");
+    cfg->density = (float)read_num(config, bench, "density");
+    cfg->include = (float)read_num(config, bench, "include");
+    report->sparsity = (float)read_num(config, bench, "sparsity");
+    report->n_sample = (uint32_t)read_num(config, bench, "samples");
+    report->n_warmup = (uint32_t)read_num(config, bench, "warmup");
+
+    const char* seed = find_value(config, bench, "seed");
+    cfg->seed = seed ? strtoull(seed, NULL, 10) : 0;
+
+    // One object per benchmark, none of them nested
+    const char* p = bench;
+    while (report->n_result < REPORT_MAX_RESULT && (p = strchr(p, '{')) != NULL) {
+        const char* close = strchr(p, '}');
+        if (!close)
+            break;
+
+        report_result_t* r = &report->results[report->n_result++];
+        read_str(p, close, "name", r->name);
+        r->min_ns = read_num(p, close, "min_ns");
+        r->p50_ns = read_num(p, close, "p50_ns");
+        r->p90_ns = read_num(p, close, "p90_ns");
+        r->p99_ns = read_num(p, close, "p99_ns");
+        r->literals_per_s = read_num(p, close, "literals_per_s");
+        p = close + 1;
+    }
+
+    free(text);
+    return 0;
+}
+
+static const report_result_t* find_result(const report_t* report, const char* name) {
+    for (uint32_t i = 0; i < report->n_result; i++) {
+        if (strcmp(report->results[i].name, name) == 0)
+            return &report->results[i];
+    }
+    return NULL;
+}
+
+// Text round trip of the floats, compare as written
+static int same_float(float a, float b) {
+    char x[32], y[32];
+    snprintf(x, sizeof(x), "%.6g", a);
+    snprintf(y, sizeof(y), "%.6g", b);
+    return strcmp(x, y) == 0;
+}
+
+int report_compare(const report_t* base, const report_t* current, double tolerance) {
+    const synth_model_config_t* a = &base->cfg;
+    const synth_model_config_t* b = &current->cfg;
+    if (a->n_class != b->n_class || a->n_feature != b->n_feature || a->n_clause != b->n_clause ||
+        a->n_state != b->n_state || a->seed != b->seed || !same_float(a->density, b->density) ||
+        !same_float(a->include, b->include) || !same_float(base->sparsity, current->sparsity)) {
+        LOGE(TAG, "Baseline was run on a different model or inputs, rerun with the same options");
+        return -1;
+    }
+
+    if (strcmp(base->machine.cpu, current->machine.cpu) != 0 || strcmp(base->machine.compiler, current->machine.compiler) != 0)
+        LOGW(TAG, "Baseline is from %s, %s", base->machine.cpu, base->machine.compiler);
+
+    printf("\n%-22s %10s %10s %8s  (baseline %s, tolerance %.0f%%)\n", "benchmark", "base p50", "p50", "change",
+           base->machine.date, tolerance * 100);
+
+    int n_regression = 0;
+    for (uint32_t i = 0; i < current->n_result; i++) {
+        const report_result_t* r = &current->results[i];
+        const report_result_t* old = find_result(base, r->name);
+        if (!old || old->p50_ns <= 0) {
+            printf("%-22s %10s %10.1f %8s\n", r->name, "-", r->p50_ns, "new");
+            continue;
+        }
+
+        double change = r->p50_ns / old->p50_ns - 1;
+        int slower = change > tolerance;
+        n_regression += slower;
+        printf("%-22s %10.1f %10.1f %+7.1f%%%s\n", r->name, old->p50_ns, r->p50_ns, change * 100,
+               slower ? "  REGRESSION" : (change < -tolerance ? "  faster" : ""));
+    }
+
+    return n_regression;
+}
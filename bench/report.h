@@ -0,0 +1,65 @@
+#ifndef _REPORT_H_
+#define _REPORT_H_
+
+#include <stdint.h>
+
+#include "synth.h"
+
+// Benchmark results as JSON, for storing a baseline and checking later
+// runs against it.
+//
+// {
+//   "machine": { "host": ..., "os": ..., "arch": ..., "cpu": ..., "n_cpu": ..., "compiler": ..., "date": ... },
+//   "config": { "n_class": ..., ..., "seed": ... },
+//   "benchmarks": [ { "name": ..., "min_ns": ..., "p50_ns": ..., ... }, ... ]
+// }
+//
+// Only the files written here are read back, the reader is not a
+// general JSON parser.
+
+#define REPORT_MAX_RESULT  32
+#define REPORT_STR_SIZE    128
+
+typedef struct {
+    char host[REPORT_STR_SIZE];
+    char os[REPORT_STR_SIZE];
+    char arch[REPORT_STR_SIZE];
+    char cpu[REPORT_STR_SIZE];
+    char compiler[REPORT_STR_SIZE];
+    char date[REPORT_STR_SIZE];
+    uint32_t n_cpu;
+} report_machine_t;
+
+typedef struct {
+    char name[REPORT_STR_SIZE];
+    double min_ns;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double literals_per_s;   // 0 if not meaningful
+} report_result_t;
+
+typedef struct {
+    report_machine_t machine;
+
+    synth_model_config_t cfg;
+    float sparsity;
+    uint32_t n_sample;
+    uint32_t n_warmup;
+
+    uint32_t n_result;
+    report_result_t results[REPORT_MAX_RESULT];
+} report_t;
+
+// Describe the machine and compiler running this binary
+void report_machine_info(report_machine_t* machine);
+
+int report_save(const report_t* report, const char* path);
+int report_load(report_t* report, const char* path);
+
+// Print the p50 of every benchmark in both reports side by side. Returns
+// the number of benchmarks more than tolerance (0.1 = 10%) slower than
+// the baseline, or -1 if the two were run on different models or inputs.
+int report_compare(const report_t* base, const report_t* current, double tolerance);
+
+#endif // _REPORT_H_
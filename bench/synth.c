@@ -0,0 +1,139 @@
+#include "synth.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fast_rand.h>
+#include <logging.h>
+
+static const char* TAG = "synth";
+
+static uint32_t next_below(uint64_t* state, uint32_t n) {
+    return n ? pcg32_fast_r(state) % n : 0;
+}
+
+static float next_float(uint64_t* state) {
+    return (float)pcg32_fast_r(state) / (float)FAST_RAND_MAX;
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// n sorted, distinct positions below n_feature, returns how many
+static size_t pick_positions(uint32_t* out, size_t n, uint32_t n_feature, uint64_t* state) {
+    for (size_t k = 0; k < n; k++)
+        out[k] = next_below(state, n_feature);
+    qsort(out, n, sizeof(uint32_t), compare_u32);
+
+    size_t m = 0;
+    for (size_t k = 0; k < n; k++) {
+        if (m == 0 || out[k] != out[m - 1])
+            out[m++] = out[k];
+    }
+    return m;
+}
+
+void synth_model_defaults(synth_model_config_t* cfg) {
+    cfg->n_class = 10;
+    cfg->n_feature = 6272;
+    cfg->n_clause = 200;
+    cfg->n_state = 100;
+    cfg->density = 0.01f;
+    cfg->include = 0.5f;
+    cfg->seed = 1;
+}
+
+Tsetlin* synth_model(const synth_model_config_t* cfg) {
+    size_t n_total = (size_t)cfg->n_class * cfg->n_clause;
+    size_t n_literal = (size_t)(cfg->density * cfg->n_feature + 0.5f);
+    if (n_literal > cfg->n_feature)
+        n_literal = cfg->n_feature;
+
+    if (n_total == 0 || cfg->n_feature == 0 || cfg->n_state < 2) {
+        LOGE(TAG, "Invalid model shape");
+        return NULL;
+    }
+
+    // Everything in one arena so that tsetlin_free() releases it
+    size_t capacity = sizeof(Tsetlin) + n_total * (sizeof(ClauseCompressed*) + sizeof(ClauseCompressed) + 64) +
+                      n_total * n_literal * 4 * sizeof(uint32_t);
+    tsetlin_arena_t* arena = tsetlin_arena_create(capacity);
+    if (!arena) {
+        LOGE(TAG, "Failed to allocate %lu bytes", (unsigned long)capacity);
+        return NULL;
+    }
+
+    Tsetlin* model = (Tsetlin*)tsetlin_arena_alloc(arena, sizeof(Tsetlin));
+    ClauseCompressed** clauses = (ClauseCompressed**)tsetlin_arena_alloc(arena, n_total * sizeof(ClauseCompressed*));
+    if (!model || !clauses) {
+        tsetlin_arena_destroy(arena);
+        return NULL;
+    }
+
+    tsetlin__init(model);
+    model->n_class = cfg->n_class;
+    model->n_feature = cfg->n_feature;
+    model->n_clause = cfg->n_clause;
+    model->n_state = cfg->n_state;
+    model->model_type = MODEL_TYPE__COMPRESSED;
+    model->n_clauses_compressed = n_total;
+    model->clauses_compressed = clauses;
+
+    uint64_t state = cfg->seed * 2 + 1;
+    uint32_t half = cfg->n_state / 2;
+
+    for (size_t i = 0; i < n_total; i++) {
+        ClauseCompressed* clause = (ClauseCompressed*)tsetlin_arena_alloc(arena, sizeof(ClauseCompressed));
+        uint32_t* position = (uint32_t*)tsetlin_arena_alloc(arena, 2 * n_literal * sizeof(uint32_t) + 1);
+        uint32_t* data = (uint32_t*)tsetlin_arena_alloc(arena, 2 * n_literal * sizeof(uint32_t) + 1);
+        if (!clause || !position || !data) {
+            LOGE(TAG, "Failed to allocate clause %lu", (unsigned long)i);
+            tsetlin_arena_destroy(arena);
+            return NULL;
+        }
+
+        clause_compressed__init(clause);
+        size_t n_pos = pick_positions(position, n_literal, cfg->n_feature, &state);
+        size_t n_neg = pick_positions(position + n_pos, n_literal, cfg->n_feature, &state);
+
+        // Included states above half, excluded ones at or below it
+        for (size_t k = 0; k < n_pos + n_neg; k++) {
+            if (next_float(&state) < cfg->include)
+                data[k] = half + 1 + next_below(&state, cfg->n_state - half);
+            else
+                data[k] = 1 + next_below(&state, half);
+        }
+
+        clause->n_pos_literal = (uint32_t)n_pos;
+        clause->n_neg_literal = (uint32_t)n_neg;
+        clause->n_state = cfg->n_state;
+        clause->n_position = n_pos + n_neg;
+        clause->position = position;
+        clause->n_data = n_pos + n_neg;
+        clause->data = data;
+        clauses[i] = clause;
+    }
+
+    return model;
+}
+
+void synth_input(uint8_t* x, uint32_t n_feature, float density, uint64_t* state) {
+    for (uint32_t k = 0; k < n_feature; k++)
+        x[k] = next_float(state) < density;
+}
+
+void synth_plant(uint8_t* x, const Tsetlin* model, uint32_t c, uint64_t* state) {
+    uint32_t n_pair = model->n_clause / 2;
+    if (n_pair == 0 || c >= model->n_class)
+        return;
+
+    uint32_t j = next_below(state, n_pair) * 2;
+    const ClauseCompressed* clause = model->clauses_compressed[(size_t)c * model->n_clause + j];
+
+    for (size_t k = 0; k < clause->n_pos_literal + clause->n_neg_literal; k++) {
+        if (clause->data[k] > model->n_state / 2)
+            x[clause->position[k]] = (k < clause->n_pos_literal);
+    }
+}
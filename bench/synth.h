@@ -0,0 +1,37 @@
+#ifndef _SYNTH_H_
+#define _SYNTH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.h>
+
+// Shape of a synthetic model. Every clause stores density * n_feature
+// literals of each polarity at random positions, and about include of
+// them have a state above n_state / 2.
+typedef struct {
+    uint32_t n_class;
+    uint32_t n_feature;
+    uint32_t n_clause;
+    uint32_t n_state;
+
+    float density;
+    float include;
+
+    uint64_t seed;
+} synth_model_config_t;
+
+// MNIST-like shape: 10 classes, 6272 features, 200 clauses, 100 states
+void synth_model_defaults(synth_model_config_t* cfg);
+
+// Same config and seed, same model. Free with tsetlin_free().
+Tsetlin* synth_model(const synth_model_config_t* cfg);
+
+// Random booleanized input with about density of the features set
+void synth_input(uint8_t* x, uint32_t n_feature, float density, uint64_t* state);
+
+// Make a random positive clause of class c fire on x, so that inputs
+// lean towards c instead of leaving almost every clause silent
+void synth_plant(uint8_t* x, const Tsetlin* model, uint32_t c, uint64_t* state);
+
+#endif // _SYNTH_H_
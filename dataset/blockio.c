@@ -0,0 +1,138 @@
+#include "blockio.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memstat.h>
+#include <file64.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(blockio);
+#endif
+
+#if !defined(_WIN32) && !defined(__ZEPHYR__) && !defined(ESP_PLATFORM) && !defined(__RTTHREAD__)
+    #define BLOCKIO_HAS_THROTTLE 1
+    #include <time.h>
+#endif
+
+static const char* TAG = "blockio";
+
+int blockio_open(blockio_t* io, const char* path, size_t block_size) {
+    memset(io, 0, sizeof(blockio_t));
+
+    io->f = fopen(path, "rb");
+    if (!io->f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    // Our reads are already block sized, stdio buffering would only
+    // split them up again and add a copy
+    setvbuf(io->f, NULL, _IONBF, 0);
+
+    io->block_size = block_size ? block_size : BLOCKIO_DEFAULT_BLOCK_SIZE;
+    for (int i = 0; i < 2; i++) {
+        io->buf[i] = (uint8_t*)perf_malloc(io->block_size, PERF_MEM_DATASET);
+        io->base[i] = -1;
+        io->fill[i] = 0;
+    }
+
+    if (!io->buf[0] || !io->buf[1]) {
+        LOGE(TAG, "Failed to allocate 2 x %lu bytes of memory", (unsigned long)io->block_size);
+        blockio_close(io);
+        return -1;
+    }
+
+    return 0;
+}
+
+void blockio_close(blockio_t* io) {
+    if (io->f)
+        fclose(io->f);
+    perf_free(io->buf[0]);
+    perf_free(io->buf[1]);
+
+    io->f = NULL;
+    io->buf[0] = NULL;
+    io->buf[1] = NULL;
+}
+
+static void blockio_throttle(blockio_t* io, size_t n) {
+#if defined(BLOCKIO_HAS_THROTTLE)
+    uint64_t us = io->latency_us;
+    if (io->bytes_per_sec)
+        us += (uint64_t)n * 1000000 / io->bytes_per_sec;
+
+    if (us) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)(us / 1000000);
+        ts.tv_nsec = (long)(us % 1000000) * 1000;
+        nanosleep(&ts, NULL);
+    }
+#else
+    (void)io;
+    (void)n;
+#endif
+}
+
+// Make the block containing offset resident, returns its buffer slot
+static int blockio_load(blockio_t* io, int64_t offset) {
+    int64_t base = offset - offset % (int64_t)io->block_size;
+    int slot = (int)((base / (int64_t)io->block_size) & 1);
+
+    if (io->base[slot] == base)
+        return slot;
+
+    io->base[slot] = -1;
+    if (file_seek64(io->f, base, SEEK_SET) != 0) {
+        LOGE(TAG, "Failed to seek to %lld", (long long)base);
+        return -1;
+    }
+
+    io->fill[slot] = fread(io->buf[slot], 1, io->block_size, io->f);
+    io->base[slot] = base;
+
+    io->n_reads++;
+    io->n_bytes += io->fill[slot];
+    blockio_throttle(io, io->fill[slot]);
+
+    return slot;
+}
+
+int blockio_seek(blockio_t* io, int64_t offset) {
+    if (offset < 0)
+        return -1;
+
+    io->pos = offset;
+    return 0;
+}
+
+size_t blockio_read(blockio_t* io, void* out, size_t size) {
+    uint8_t* dst = (uint8_t*)out;
+    size_t done = 0;
+
+    while (done < size) {
+        int slot = blockio_load(io, io->pos);
+        if (slot < 0)
+            break;
+
+        size_t offset = (size_t)(io->pos - io->base[slot]);
+        if (offset >= io->fill[slot])
+            break; // end of file
+
+        size_t n = io->fill[slot] - offset;
+        if (n > size - done)
+            n = size - done;
+
+        memcpy(dst + done, io->buf[slot] + offset, n);
+        done += n;
+        io->pos += (int64_t)n;
+    }
+
+    return done;
+}
+
+void blockio_set_throttle(blockio_t* io, uint32_t latency_us, uint32_t bytes_per_sec) {
+    io->latency_us = latency_us;
+    io->bytes_per_sec = bytes_per_sec;
+}
@@ -0,0 +1,45 @@
+#ifndef _BLOCKIO_H_
+#define _BLOCKIO_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <logging.h>
+
+// Matches allocation_unit_size of the FAT mount on the ESP-IDF port
+#define BLOCKIO_DEFAULT_BLOCK_SIZE (16 * 1024)
+
+// Block-aligned reader for SD card / FAT datasets.
+// The file is only ever read in whole, block-aligned chunks, so one
+// 16 KB transaction serves ~20 MNIST images instead of one each.
+// Block k lives in buffer (k & 1): a record straddling two blocks is
+// served from both without re-reading either.
+typedef struct {
+    FILE* f;
+    size_t block_size;
+
+    uint8_t* buf[2];
+    int64_t base[2];
+    size_t fill[2];
+
+    int64_t pos;
+
+    // Host testing: sleep per block read to mimic a slow card
+    uint32_t latency_us;
+    uint32_t bytes_per_sec;
+
+    uint32_t n_reads;
+    uint64_t n_bytes;
+} blockio_t;
+
+int blockio_open(blockio_t* io, const char* path, size_t block_size);
+void blockio_close(blockio_t* io);
+
+int blockio_seek(blockio_t* io, int64_t offset);
+size_t blockio_read(blockio_t* io, void* out, size_t size);
+
+// Only takes effect on POSIX hosts
+void blockio_set_throttle(blockio_t* io, uint32_t latency_us, uint32_t bytes_per_sec);
+
+#endif // _BLOCKIO_H_
@@ -0,0 +1,280 @@
+#include "dataset.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memstat.h>
+
+#include <fast_rand.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(dataset);
+#endif
+
+#if !defined(_WIN32) && !defined(__ZEPHYR__) && !defined(ESP_PLATFORM) && !defined(__RTTHREAD__)
+    #define DATASET_HAS_MMAP 1
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+static const char* TAG = "dataset";
+
+#define DATASET_MAGIC   0x5344544C  // "LTDS"
+// Version 2 widened the labels from int8_t to uint16_t
+#define DATASET_VERSION 2
+#define DATASET_HEADER  64
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_sample;
+    uint32_t n_feature;
+    uint32_t stride;
+} dataset_header_t;
+
+// Header, then the labels, which stay aligned right after it, then the rows
+static void dataset_layout(dataset_t* ds, uint8_t* base) {
+    ds->y = (uint16_t*)(base + DATASET_HEADER);
+    ds->X = base + DATASET_HEADER + (size_t)ds->n_sample * sizeof(uint16_t);
+}
+
+dataset_t* dataset_create(uint32_t n_sample, uint32_t n_feature) {
+    dataset_t* ds = (dataset_t*)perf_malloc(sizeof(dataset_t), PERF_MEM_DATASET);
+    if (!ds) {
+        LOGE(TAG, "Failed to allocate dataset");
+        return NULL;
+    }
+
+    ds->n_sample = n_sample;
+    ds->n_feature = n_feature;
+    ds->stride = (n_feature + 7) / 8;
+    ds->mapped = 0;
+
+    // Same layout as the cache file, so saving is a single write
+    ds->size = DATASET_HEADER + (size_t)n_sample * ds->stride + (size_t)n_sample * sizeof(uint16_t);
+    ds->base = perf_calloc(1, ds->size, PERF_MEM_DATASET);
+    if (!ds->base) {
+        LOGE(TAG, "Failed to allocate %lu bytes for %lu samples", (unsigned long)ds->size, (unsigned long)n_sample);
+        perf_free(ds);
+        return NULL;
+    }
+
+    dataset_header_t* header = (dataset_header_t*)ds->base;
+    header->magic = DATASET_MAGIC;
+    header->version = DATASET_VERSION;
+    header->n_sample = n_sample;
+    header->n_feature = n_feature;
+    header->stride = ds->stride;
+
+    dataset_layout(ds, (uint8_t*)ds->base);
+    return ds;
+}
+
+void dataset_free(dataset_t* ds) {
+    if (!ds)
+        return;
+
+#if defined(DATASET_HAS_MMAP)
+    if (ds->mapped) {
+        munmap(ds->base, ds->size);
+        perf_free(ds);
+        return;
+    }
+#endif
+
+    perf_free(ds->base);
+    perf_free(ds);
+}
+
+void dataset_set(dataset_t* ds, uint32_t idx, const uint8_t* x_bool, uint16_t y) {
+    uint8_t* row = ds->X + (size_t)idx * ds->stride;
+    memset(row, 0, ds->stride);
+
+    for (uint32_t i = 0; i < ds->n_feature; i++) {
+        row[i >> 3] |= (uint8_t)((x_bool[i] & 1) << (i & 7));
+    }
+    ds->y[idx] = y;
+}
+
+void dataset_get(const dataset_t* ds, uint32_t idx, uint8_t* out_bool) {
+    const uint8_t* row = ds->X + (size_t)idx * ds->stride;
+
+    uint32_t i = 0;
+    for (; i + 8 <= ds->n_feature; i += 8) {
+        uint8_t b = row[i >> 3];
+        out_bool[i + 0] = (b >> 0) & 1;
+        out_bool[i + 1] = (b >> 1) & 1;
+        out_bool[i + 2] = (b >> 2) & 1;
+        out_bool[i + 3] = (b >> 3) & 1;
+        out_bool[i + 4] = (b >> 4) & 1;
+        out_bool[i + 5] = (b >> 5) & 1;
+        out_bool[i + 6] = (b >> 6) & 1;
+        out_bool[i + 7] = (b >> 7) & 1;
+    }
+    for (; i < ds->n_feature; i++) {
+        out_bool[i] = (row[i >> 3] >> (i & 7)) & 1;
+    }
+}
+
+int dataset_save(const dataset_t* ds, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    if (fwrite(ds->base, 1, ds->size, f) != ds->size) {
+        LOGE(TAG, "Failed to write %lu bytes to %s", (unsigned long)ds->size, path);
+        fclose(f);
+        return -1;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+dataset_t* dataset_map(const char* path) {
+    dataset_t* ds = (dataset_t*)perf_malloc(sizeof(dataset_t), PERF_MEM_DATASET);
+    if (!ds) {
+        LOGE(TAG, "Failed to allocate dataset");
+        return NULL;
+    }
+
+#if defined(DATASET_HAS_MMAP)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perf_free(ds);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < DATASET_HEADER) {
+        close(fd);
+        perf_free(ds);
+        return NULL;
+    }
+
+    ds->size = (size_t)st.st_size;
+    ds->base = mmap(NULL, ds->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (ds->base == MAP_FAILED) {
+        LOGE(TAG, "Failed to mmap file %s", path);
+        perf_free(ds);
+        return NULL;
+    }
+    ds->mapped = 1;
+#else
+    // No mmap on this platform, read the cache file in one go instead
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perf_free(ds);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    ds->size = (size_t)size;
+    ds->base = (size > DATASET_HEADER) ? perf_malloc(ds->size, PERF_MEM_DATASET) : NULL;
+    if (!ds->base || fread(ds->base, 1, ds->size, f) != ds->size) {
+        LOGE(TAG, "Failed to read file %s", path);
+        perf_free(ds->base);
+        perf_free(ds);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    ds->mapped = 0;
+#endif
+
+    const dataset_header_t* header = (const dataset_header_t*)ds->base;
+    size_t expected = DATASET_HEADER + (size_t)header->n_sample * header->stride + (size_t)header->n_sample * sizeof(uint16_t);
+    if (header->magic == DATASET_MAGIC && header->version != DATASET_VERSION) {
+        LOGW(TAG, "Dataset cache file %s has version %lu, expected %d", path, (unsigned long)header->version, DATASET_VERSION);
+        dataset_free(ds);
+        return NULL;
+    }
+    if (header->magic != DATASET_MAGIC ||
+        header->stride != (header->n_feature + 7) / 8 || ds->size < expected) {
+        LOGE(TAG, "Invalid dataset cache file %s", path);
+        dataset_free(ds);
+        return NULL;
+    }
+
+    ds->n_sample = header->n_sample;
+    ds->n_feature = header->n_feature;
+    ds->stride = header->stride;
+    dataset_layout(ds, (uint8_t*)ds->base);
+
+    return ds;
+}
+
+void dataset_shuffle(uint32_t* perm, uint32_t n, uint64_t seed) {
+    // The MCG behind pcg32 needs an odd state
+    uint64_t state = (seed << 1) | 1;
+
+    for (uint32_t i = 0; i < n; i++) {
+        perm[i] = i;
+    }
+
+    // Fisher-Yates, bounded with a multiply instead of a modulo
+    for (uint32_t i = n; i > 1; i--) {
+        uint32_t j = (uint32_t)(((uint64_t)pcg32_fast_r(&state) * i) >> 32);
+        uint32_t tmp = perm[i - 1];
+        perm[i - 1] = perm[j];
+        perm[j] = tmp;
+    }
+}
+
+int dataset_iter_init(dataset_iter_t* it, const dataset_t* ds, uint64_t seed, uint32_t shard, uint32_t n_shard) {
+    if (n_shard == 0 || shard >= n_shard) {
+        LOGE(TAG, "Invalid shard %lu of %lu", (unsigned long)shard, (unsigned long)n_shard);
+        return -1;
+    }
+
+    it->perm = (uint32_t*)perf_malloc(sizeof(uint32_t) * ds->n_sample, PERF_MEM_DATASET);
+    if (!it->perm) {
+        LOGE(TAG, "Failed to allocate memory for permutation");
+        return -1;
+    }
+
+    it->ds = ds;
+    it->seed = seed;
+    it->shard = shard;
+    it->n_shard = n_shard;
+
+    it->begin = (uint32_t)((uint64_t)ds->n_sample * shard / n_shard);
+    it->end = (uint32_t)((uint64_t)ds->n_sample * (shard + 1) / n_shard);
+
+    dataset_iter_epoch(it, 0);
+    return 0;
+}
+
+void dataset_iter_epoch(dataset_iter_t* it, uint32_t epoch) {
+    dataset_shuffle(it->perm, it->ds->n_sample, it->seed + epoch * 0x9E3779B97F4A7C15ull);
+    it->pos = it->begin;
+}
+
+int dataset_iter_next(dataset_iter_t* it, uint8_t* out_bool, uint16_t* out_label) {
+    if (it->pos >= it->end)
+        return 0;
+
+    uint32_t idx = it->perm[it->pos++];
+    dataset_get(it->ds, idx, out_bool);
+    *out_label = it->ds->y[idx];
+
+    return 1;
+}
+
+uint32_t dataset_iter_size(const dataset_iter_t* it) {
+    return it->end - it->begin;
+}
+
+void dataset_iter_free(dataset_iter_t* it) {
+    perf_free(it->perm);
+    it->perm = NULL;
+}
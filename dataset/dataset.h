@@ -0,0 +1,65 @@
+#ifndef _DATASET_H_
+#define _DATASET_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <logging.h>
+
+// Class labels are stored as uint16_t
+#define DATASET_MAX_LABEL UINT16_MAX
+
+// Booleanized samples kept resident in memory, one bit per literal.
+// Rows are `stride` bytes wide so a sample can be unpacked without
+// touching its neighbours.
+typedef struct {
+    uint32_t n_sample;
+    uint32_t n_feature;
+    uint32_t stride;
+
+    uint8_t* X;
+    uint16_t* y;
+
+    // Backing storage: either one malloc'd block or an mmap'd cache file
+    void* base;
+    size_t size;
+    uint8_t mapped;
+} dataset_t;
+
+// Per-epoch shuffled iterator over a dataset.
+// Every worker builds the same permutation from (seed, epoch) and only
+// walks its own contiguous slice of it, so shards never overlap.
+typedef struct {
+    const dataset_t* ds;
+    uint32_t* perm;
+
+    uint64_t seed;
+    uint32_t shard;
+    uint32_t n_shard;
+
+    uint32_t begin;
+    uint32_t end;
+    uint32_t pos;
+} dataset_iter_t;
+
+dataset_t* dataset_create(uint32_t n_sample, uint32_t n_feature);
+void dataset_free(dataset_t* ds);
+
+void dataset_set(dataset_t* ds, uint32_t idx, const uint8_t* x_bool, uint16_t y);
+void dataset_get(const dataset_t* ds, uint32_t idx, uint8_t* out_bool);
+
+// Cache file of the packed set, so later runs can map it instead of
+// booleanizing the raw dataset again.
+int dataset_save(const dataset_t* ds, const char* path);
+dataset_t* dataset_map(const char* path);
+
+void dataset_shuffle(uint32_t* perm, uint32_t n, uint64_t seed);
+
+int dataset_iter_init(dataset_iter_t* it, const dataset_t* ds, uint64_t seed, uint32_t shard, uint32_t n_shard);
+void dataset_iter_epoch(dataset_iter_t* it, uint32_t epoch);
+int dataset_iter_next(dataset_iter_t* it, uint8_t* out_bool, uint16_t* out_label);
+uint32_t dataset_iter_size(const dataset_iter_t* it);
+void dataset_iter_free(dataset_iter_t* it);
+
+#endif // _DATASET_H_
@@ -0,0 +1,344 @@
+#include "encoder.h"
+
+#include <math.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <memstat.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(encoder);
+#endif
+
+static const char* TAG = "encoder";
+
+#define ENCODER_MAGIC   0x4E45544C  // "LTEN"
+#define ENCODER_VERSION 1
+
+static void encoder_free_sketch(encoder_t* enc) {
+    perf_free(enc->lo);
+    perf_free(enc->width);
+    perf_free(enc->counts);
+    perf_free(enc->seen);
+
+    enc->lo = NULL;
+    enc->width = NULL;
+    enc->counts = NULL;
+    enc->seen = NULL;
+}
+
+static encoder_t* encoder_alloc(uint32_t n_feature, uint32_t n_bits) {
+    if (n_bits == 0 || n_bits > 255) {
+        LOGE(TAG, "Unsupported number of bits %lu", (unsigned long)n_bits);
+        return NULL;
+    }
+
+    encoder_t* enc = (encoder_t*)perf_calloc(1, sizeof(encoder_t), PERF_MEM_DATASET);
+    if (!enc) {
+        LOGE(TAG, "Failed to allocate encoder");
+        return NULL;
+    }
+
+    enc->n_feature = n_feature;
+    enc->n_bits = n_bits;
+    enc->thresholds = (float*)perf_malloc(sizeof(float) * n_feature * n_bits, PERF_MEM_DATASET);
+    if (!enc->thresholds) {
+        LOGE(TAG, "Failed to allocate memory for thresholds");
+        perf_free(enc);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < (size_t)n_feature * n_bits; i++) {
+        enc->thresholds[i] = FLT_MAX;
+    }
+
+    return enc;
+}
+
+encoder_t* encoder_create(uint32_t n_feature, uint32_t n_bits, uint32_t n_bins) {
+    encoder_t* enc = encoder_alloc(n_feature, n_bits);
+    if (!enc)
+        return NULL;
+
+    // Bins are merged pairwise, keep their number a power of two
+    uint32_t bins = 2;
+    while (bins < n_bins && bins < (1u << 16)) {
+        bins <<= 1;
+    }
+    enc->n_bins = bins;
+
+    enc->lo = (float*)perf_malloc(sizeof(float) * n_feature, PERF_MEM_SCRATCH);
+    enc->width = (float*)perf_malloc(sizeof(float) * n_feature, PERF_MEM_SCRATCH);
+    enc->counts = (uint32_t*)perf_calloc((size_t)n_feature * bins, sizeof(uint32_t), PERF_MEM_SCRATCH);
+    enc->seen = (uint8_t*)perf_calloc(n_feature, sizeof(uint8_t), PERF_MEM_SCRATCH);
+
+    if (!enc->lo || !enc->width || !enc->counts || !enc->seen) {
+        LOGE(TAG, "Failed to allocate memory for %lu x %lu sketch bins", (unsigned long)n_feature, (unsigned long)bins);
+        encoder_free(enc);
+        return NULL;
+    }
+
+    return enc;
+}
+
+void encoder_free(encoder_t* enc) {
+    if (!enc)
+        return;
+
+    encoder_free_sketch(enc);
+    perf_free(enc->thresholds);
+    perf_free(enc->lut);
+    perf_free(enc->pattern);
+    perf_free(enc);
+}
+
+static void sketch_add(encoder_t* enc, uint32_t f, float v) {
+    if (!isfinite(v))
+        return;
+
+    const uint32_t n = enc->n_bins;
+    uint32_t* c = enc->counts + (size_t)f * n;
+
+    if (!enc->seen[f]) {
+        // Start narrow around the first value and let the range grow
+        float mag = fabsf(v) > 1.0f ? fabsf(v) : 1.0f;
+        enc->width[f] = mag / 1024.0f;
+        enc->lo[f] = v - enc->width[f] * (n / 2);
+        enc->seen[f] = 1;
+    }
+
+    // Value above the range: merge bin pairs into the lower half
+    while (v >= enc->lo[f] + enc->width[f] * n) {
+        for (uint32_t i = 0; i < n / 2; i++) {
+            c[i] = c[2 * i] + c[2 * i + 1];
+        }
+        memset(c + n / 2, 0, sizeof(uint32_t) * (n / 2));
+        enc->width[f] *= 2.0f;
+    }
+
+    // Value below the range: merge bin pairs into the upper half
+    while (v < enc->lo[f]) {
+        for (uint32_t i = n / 2; i-- > 0; ) {
+            c[n / 2 + i] = c[2 * i] + c[2 * i + 1];
+        }
+        memset(c, 0, sizeof(uint32_t) * (n / 2));
+        enc->lo[f] -= enc->width[f] * n;
+        enc->width[f] *= 2.0f;
+    }
+
+    uint32_t bin = (uint32_t)((v - enc->lo[f]) / enc->width[f]);
+    if (bin >= n)
+        bin = n - 1;
+
+    c[bin]++;
+}
+
+void encoder_fit_update(encoder_t* enc, const float* x) {
+    for (uint32_t f = 0; f < enc->n_feature; f++) {
+        sketch_add(enc, f, x[f]);
+    }
+}
+
+void encoder_fit_update_u8(encoder_t* enc, const uint8_t* x) {
+    for (uint32_t f = 0; f < enc->n_feature; f++) {
+        sketch_add(enc, f, (float)x[f]);
+    }
+}
+
+int encoder_fit_idx(encoder_t* enc, idx_file_t* idx) {
+    if (idx->item_elems != enc->n_feature) {
+        LOGE(TAG, "IDX items have %lu elements, encoder expects %lu", (unsigned long)idx->item_elems, (unsigned long)enc->n_feature);
+        return -1;
+    }
+
+    float* x = (float*)perf_malloc(sizeof(float) * enc->n_feature, PERF_MEM_SCRATCH);
+    if (!x || idx_stream_begin(idx, 256) != 0) {
+        LOGE(TAG, "Failed to allocate memory");
+        perf_free(x);
+        return -1;
+    }
+
+    uint32_t count;
+    const uint8_t* chunk;
+    while ((chunk = (const uint8_t*)idx_stream_next(idx, &count)) != NULL) {
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t* item = chunk + (size_t)i * idx->item_size;
+            if (idx->dtype == IDX_UINT8) {
+                encoder_fit_update_u8(enc, item);
+            } else {
+                idx_to_f32(idx->dtype, item, enc->n_feature, x);
+                encoder_fit_update(enc, x);
+            }
+        }
+    }
+
+    perf_free(x);
+
+    // idx_stream_next() also returns NULL on a read error
+    if (idx->cursor != idx->n_item) {
+        LOGE(TAG, "Fitted %lu of %lu items", (unsigned long)idx->cursor, (unsigned long)idx->n_item);
+        return -1;
+    }
+    return 0;
+}
+
+int encoder_fit_end(encoder_t* enc) {
+    if (!enc->counts) {
+        LOGE(TAG, "Encoder has already been fitted");
+        return -1;
+    }
+
+    const uint32_t n = enc->n_bins;
+    for (uint32_t f = 0; f < enc->n_feature; f++) {
+        if (!enc->seen[f])
+            continue;
+
+        const uint32_t* c = enc->counts + (size_t)f * n;
+        float* t = enc->thresholds + (size_t)f * enc->n_bits;
+
+        uint64_t total = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            total += c[i];
+        }
+
+        // Place thresholds on bin edges, each one splitting what is left
+        // above the previous threshold evenly among the remaining bits.
+        // A point mass (e.g. MNIST background) then costs a single bit
+        // instead of several identical ones.
+        uint64_t prev = 0, cum = 0;
+        uint32_t k = 0;
+        for (uint32_t i = 0; i < n && k < enc->n_bits; i++) {
+            cum += c[i];
+            if (cum == total)
+                break;
+
+            uint64_t step = (total - prev) / (enc->n_bits - k + 1);
+            if (cum > prev && cum - prev >= step) {
+                t[k++] = enc->lo[f] + enc->width[f] * (float)(i + 1);
+                prev = cum;
+            }
+        }
+    }
+
+    encoder_free_sketch(enc);
+    return 0;
+}
+
+int encoder_build_lut(encoder_t* enc) {
+    perf_free(enc->lut);
+    perf_free(enc->pattern);
+
+    enc->lut = (uint8_t*)perf_malloc((size_t)enc->n_feature * 256, PERF_MEM_DATASET);
+    enc->pattern = (uint8_t*)perf_malloc(2 * enc->n_bits, PERF_MEM_DATASET);
+    if (!enc->lut || !enc->pattern) {
+        LOGE(TAG, "Failed to allocate memory for lookup table");
+        perf_free(enc->lut);
+        perf_free(enc->pattern);
+        enc->lut = NULL;
+        enc->pattern = NULL;
+        return -1;
+    }
+
+    // n_bits ones followed by n_bits zeros: the thermometer code of level l
+    // is the n_bits bytes starting at pattern + n_bits - l
+    memset(enc->pattern, 1, enc->n_bits);
+    memset(enc->pattern + enc->n_bits, 0, enc->n_bits);
+
+    for (uint32_t f = 0; f < enc->n_feature; f++) {
+        const float* t = enc->thresholds + (size_t)f * enc->n_bits;
+        for (uint32_t v = 0; v < 256; v++) {
+            uint8_t level = 0;
+            for (uint32_t k = 0; k < enc->n_bits; k++) {
+                level += ((float)v > t[k]);
+            }
+            enc->lut[(size_t)f * 256 + v] = level;
+        }
+    }
+
+    return 0;
+}
+
+void encoder_encode(const encoder_t* enc, const float* x, uint8_t* out_bits) {
+    for (uint32_t f = 0; f < enc->n_feature; f++) {
+        const float* t = enc->thresholds + (size_t)f * enc->n_bits;
+        for (uint32_t k = 0; k < enc->n_bits; k++) {
+            out_bits[k] = (uint8_t)(x[f] > t[k]);
+        }
+        out_bits += enc->n_bits;
+    }
+}
+
+void encoder_encode_u8(const encoder_t* enc, const uint8_t* x, uint8_t* out_bits) {
+    if (!enc->lut) {
+        for (uint32_t f = 0; f < enc->n_feature; f++) {
+            const float* t = enc->thresholds + (size_t)f * enc->n_bits;
+            for (uint32_t k = 0; k < enc->n_bits; k++) {
+                out_bits[k] = (uint8_t)((float)x[f] > t[k]);
+            }
+            out_bits += enc->n_bits;
+        }
+        return;
+    }
+
+    for (uint32_t f = 0; f < enc->n_feature; f++) {
+        uint8_t level = enc->lut[(size_t)f * 256 + x[f]];
+        memcpy(out_bits, enc->pattern + enc->n_bits - level, enc->n_bits);
+        out_bits += enc->n_bits;
+    }
+}
+
+int encoder_save(const encoder_t* enc, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    uint32_t header[4] = { ENCODER_MAGIC, ENCODER_VERSION, enc->n_feature, enc->n_bits };
+    size_t n = (size_t)enc->n_feature * enc->n_bits;
+
+    if (fwrite(header, sizeof(uint32_t), 4, f) != 4 ||
+        fwrite(enc->thresholds, sizeof(float), n, f) != n) {
+        LOGE(TAG, "Failed to write file %s", path);
+        fclose(f);
+        return -1;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+encoder_t* encoder_load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return NULL;
+    }
+
+    uint32_t header[4];
+    if (fread(header, sizeof(uint32_t), 4, f) != 4 ||
+        header[0] != ENCODER_MAGIC || header[1] != ENCODER_VERSION) {
+        LOGE(TAG, "Invalid encoder file %s", path);
+        fclose(f);
+        return NULL;
+    }
+
+    encoder_t* enc = encoder_alloc(header[2], header[3]);
+    if (!enc) {
+        fclose(f);
+        return NULL;
+    }
+
+    size_t n = (size_t)enc->n_feature * enc->n_bits;
+    if (fread(enc->thresholds, sizeof(float), n, f) != n) {
+        LOGE(TAG, "Failed to read thresholds from %s", path);
+        encoder_free(enc);
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    return enc;
+}
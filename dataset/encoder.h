@@ -0,0 +1,51 @@
+#ifndef _ENCODER_H_
+#define _ENCODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <logging.h>
+#include "idx.h"
+
+// Thermometer encoder with per-feature quantile thresholds.
+// Bit k of a feature is set when x > thresholds[k], so every feature
+// becomes n_bits literals regardless of the input scale.
+typedef struct {
+    uint32_t n_feature;
+    uint32_t n_bits;
+    uint32_t n_bins;
+
+    // n_feature * n_bits, ascending per feature, FLT_MAX for unused bits
+    float* thresholds;
+
+    // Streaming sketch, only alive between create and encoder_fit_end():
+    // per feature n_bins equal-width bins over [lo, lo + width * n_bins),
+    // the width doubles (adjacent bins merge) when a value falls outside.
+    float* lo;
+    float* width;
+    uint32_t* counts;
+    uint8_t* seen;
+
+    // Branch-free encoding of 8-bit inputs, see encoder_build_lut()
+    uint8_t* lut;
+    uint8_t* pattern;
+} encoder_t;
+
+encoder_t* encoder_create(uint32_t n_feature, uint32_t n_bits, uint32_t n_bins);
+void encoder_free(encoder_t* enc);
+
+void encoder_fit_update(encoder_t* enc, const float* x);
+void encoder_fit_update_u8(encoder_t* enc, const uint8_t* x);
+int encoder_fit_idx(encoder_t* enc, idx_file_t* idx);
+int encoder_fit_end(encoder_t* enc);
+
+int encoder_build_lut(encoder_t* enc);
+
+// out_bits holds n_feature * n_bits bytes, one literal per byte
+void encoder_encode(const encoder_t* enc, const float* x, uint8_t* out_bits);
+void encoder_encode_u8(const encoder_t* enc, const uint8_t* x, uint8_t* out_bits);
+
+int encoder_save(const encoder_t* enc, const char* path);
+encoder_t* encoder_load(const char* path);
+
+#endif // _ENCODER_H_
@@ -0,0 +1,223 @@
+#include "idx.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memstat.h>
+#include <file64.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(idx);
+#endif
+
+static const char* TAG = "idx";
+
+static uint32_t read_u32_be(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) |
+           ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8)  |
+           (uint32_t)p[3];
+}
+
+static int is_little_endian(void) {
+    const uint16_t one = 1;
+    return *(const uint8_t*)&one == 1;
+}
+
+// IDX payloads are big-endian, swap in place on little-endian hosts
+static void idx_to_host(void* data, size_t count, size_t elem_size) {
+    if (elem_size == 1 || !is_little_endian())
+        return;
+
+    uint8_t* p = (uint8_t*)data;
+    for (size_t i = 0; i < count; i++, p += elem_size) {
+        for (size_t lo = 0, hi = elem_size - 1; lo < hi; lo++, hi--) {
+            uint8_t tmp = p[lo];
+            p[lo] = p[hi];
+            p[hi] = tmp;
+        }
+    }
+}
+
+size_t idx_dtype_size(uint8_t dtype) {
+    switch (dtype) {
+        case IDX_UINT8:
+        case IDX_INT8:
+            return 1;
+        case IDX_INT16:
+            return 2;
+        case IDX_INT32:
+        case IDX_FLOAT32:
+            return 4;
+        case IDX_FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+int idx_open(idx_file_t* idx, const char* path) {
+    memset(idx, 0, sizeof(idx_file_t));
+
+    idx->f = fopen(path, "rb");
+    if (!idx->f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    uint8_t magic[4];
+    if (fread(magic, 1, 4, idx->f) != 4) {
+        LOGE(TAG, "Failed to read header from file %s", path);
+        idx_close(idx);
+        return -1;
+    }
+
+    idx->dtype = magic[2];
+    idx->rank = magic[3];
+    idx->elem_size = idx_dtype_size(idx->dtype);
+
+    if (magic[0] != 0 || magic[1] != 0 || idx->elem_size == 0 ||
+        idx->rank == 0 || idx->rank > IDX_MAX_RANK) {
+        LOGE(TAG, "Invalid magic number in file %s", path);
+        idx_close(idx);
+        return -1;
+    }
+
+    uint8_t dims[4 * IDX_MAX_RANK];
+    if (fread(dims, 4, idx->rank, idx->f) != idx->rank) {
+        LOGE(TAG, "Failed to read header from file %s", path);
+        idx_close(idx);
+        return -1;
+    }
+
+    idx->item_elems = 1;
+    for (uint8_t i = 0; i < idx->rank; i++) {
+        idx->dims[i] = read_u32_be(&dims[4 * i]);
+        if (i > 0)
+            idx->item_elems *= idx->dims[i];
+    }
+
+    idx->n_item = idx->dims[0];
+    idx->item_size = idx->item_elems * idx->elem_size;
+    idx->data_offset = 4 + 4 * (long)idx->rank;
+
+    return 0;
+}
+
+void idx_close(idx_file_t* idx) {
+    if (idx->f)
+        fclose(idx->f);
+    perf_free(idx->chunk);
+
+    idx->f = NULL;
+    idx->chunk = NULL;
+}
+
+int idx_read(idx_file_t* idx, uint32_t first, uint32_t count, void* out) {
+    if ((uint64_t)first + count > idx->n_item) {
+        LOGE(TAG, "Items %lu..%lu out of range (%lu)", (unsigned long)first, (unsigned long)(first + count), (unsigned long)idx->n_item);
+        return -1;
+    }
+
+    int64_t offset = (int64_t)idx->data_offset + (int64_t)first * (int64_t)idx->item_size;
+    if (file_seek64(idx->f, offset, SEEK_SET) != 0) {
+        LOGE(TAG, "Failed to seek to item %lu", (unsigned long)first);
+        return -1;
+    }
+
+    if (fread(out, idx->item_size, count, idx->f) != count) {
+        LOGE(TAG, "Failed to read %lu items", (unsigned long)count);
+        return -1;
+    }
+
+    idx_to_host(out, count * idx->item_elems, idx->elem_size);
+    return 0;
+}
+
+void idx_to_f32(uint8_t dtype, const void* src, size_t count, float* out) {
+    switch (dtype) {
+        case IDX_UINT8:
+            for (size_t i = 0; i < count; i++) out[i] = (float)((const uint8_t*)src)[i];
+            break;
+        case IDX_INT8:
+            for (size_t i = 0; i < count; i++) out[i] = (float)((const int8_t*)src)[i];
+            break;
+        case IDX_INT16:
+            for (size_t i = 0; i < count; i++) out[i] = (float)((const int16_t*)src)[i];
+            break;
+        case IDX_INT32:
+            for (size_t i = 0; i < count; i++) out[i] = (float)((const int32_t*)src)[i];
+            break;
+        case IDX_FLOAT32:
+            memmove(out, src, count * sizeof(float));
+            break;
+        case IDX_FLOAT64:
+            for (size_t i = 0; i < count; i++) out[i] = (float)((const double*)src)[i];
+            break;
+    }
+}
+
+int idx_read_f32(idx_file_t* idx, uint32_t first, uint32_t count, float* out) {
+    // Narrower dtypes are read into the tail of the output buffer and
+    // widened front to back; float64 needs its own scratch.
+    size_t n = (size_t)count * idx->item_elems;
+
+    if (idx->elem_size > sizeof(float)) {
+        void* tmp = perf_malloc(n * idx->elem_size, PERF_MEM_SCRATCH);
+        if (!tmp) {
+            LOGE(TAG, "Failed to allocate memory");
+            return -1;
+        }
+        int ret = idx_read(idx, first, count, tmp);
+        if (ret == 0)
+            idx_to_f32(idx->dtype, tmp, n, out);
+        perf_free(tmp);
+        return ret;
+    }
+
+    uint8_t* raw = (uint8_t*)out + n * (sizeof(float) - idx->elem_size);
+    if (idx_read(idx, first, count, raw) != 0)
+        return -1;
+
+    idx_to_f32(idx->dtype, raw, n, out);
+    return 0;
+}
+
+int idx_stream_begin(idx_file_t* idx, uint32_t chunk_items) {
+    if (chunk_items == 0)
+        chunk_items = 1;
+
+    perf_free(idx->chunk);
+    idx->chunk = (uint8_t*)perf_malloc(idx->item_size * chunk_items, PERF_MEM_DATASET);
+    if (!idx->chunk) {
+        LOGE(TAG, "Failed to allocate %lu bytes of memory", (unsigned long)(idx->item_size * chunk_items));
+        return -1;
+    }
+
+    idx->chunk_items = chunk_items;
+    idx->cursor = 0;
+    fseek(idx->f, idx->data_offset, SEEK_SET);
+
+    return 0;
+}
+
+const void* idx_stream_next(idx_file_t* idx, uint32_t* out_count) {
+    uint32_t count = idx->n_item - idx->cursor;
+    if (count > idx->chunk_items)
+        count = idx->chunk_items;
+
+    *out_count = 0;
+    if (count == 0)
+        return NULL;
+
+    if (fread(idx->chunk, idx->item_size, count, idx->f) != count) {
+        LOGE(TAG, "Failed to read %lu items", (unsigned long)count);
+        return NULL;
+    }
+
+    idx_to_host(idx->chunk, count * idx->item_elems, idx->elem_size);
+    idx->cursor += count;
+
+    *out_count = count;
+    return idx->chunk;
+}
@@ -0,0 +1,58 @@
+#ifndef _IDX_H_
+#define _IDX_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <logging.h>
+
+// IDX tensor files (MNIST, Fashion-MNIST, KMNIST, EMNIST, ...)
+// Header: 0x00 0x00 <dtype> <rank>, then <rank> big-endian uint32 dims.
+#define IDX_UINT8   0x08
+#define IDX_INT8    0x09
+#define IDX_INT16   0x0B
+#define IDX_INT32   0x0C
+#define IDX_FLOAT32 0x0D
+#define IDX_FLOAT64 0x0E
+
+#define IDX_MAX_RANK 8
+
+typedef struct {
+    FILE* f;
+
+    uint8_t dtype;
+    uint8_t rank;
+    uint32_t dims[IDX_MAX_RANK];
+
+    // dims[0] items of dims[1] x ... x dims[rank - 1] elements each
+    uint32_t n_item;
+    size_t item_elems;
+    size_t elem_size;
+    size_t item_size;
+    long data_offset;
+
+    // Streaming state, see idx_stream_begin()
+    uint8_t* chunk;
+    uint32_t chunk_items;
+    uint32_t cursor;
+} idx_file_t;
+
+int idx_open(idx_file_t* idx, const char* path);
+void idx_close(idx_file_t* idx);
+
+size_t idx_dtype_size(uint8_t dtype);
+
+// Random access, elements are returned in host byte order
+int idx_read(idx_file_t* idx, uint32_t first, uint32_t count, void* out);
+int idx_read_f32(idx_file_t* idx, uint32_t first, uint32_t count, float* out);
+
+// Chunked sequential access for files larger than RAM: only chunk_items
+// items are ever buffered. idx_stream_next() returns NULL at the end.
+int idx_stream_begin(idx_file_t* idx, uint32_t chunk_items);
+const void* idx_stream_next(idx_file_t* idx, uint32_t* out_count);
+
+// Convert count elements of the given dtype (host byte order) to float
+void idx_to_f32(uint8_t dtype, const void* src, size_t count, float* out);
+
+#endif // _IDX_H_
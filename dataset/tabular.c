@@ -0,0 +1,500 @@
+#include "tabular.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file64.h>
+#include <memstat.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define TABULAR_HAS_SSE2 1
+#endif
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tabular);
+#endif
+
+static const char* TAG = "tabular";
+
+#define ONES  0x0101010101010101ull
+#define HIGHS 0x8080808080808080ull
+
+// Index of the first byte equal to c1 or c2, n if there is none.
+// 16 bytes per step with SSE2, 8 bytes per step elsewhere (SWAR).
+static size_t scan_for(const uint8_t* p, size_t n, uint8_t c1, uint8_t c2) {
+    size_t i = 0;
+
+#if defined(TABULAR_HAS_SSE2)
+    const __m128i v1 = _mm_set1_epi8((char)c1);
+    const __m128i v2 = _mm_set1_epi8((char)c2);
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, v1), _mm_cmpeq_epi8(x, v2)));
+        if (mask) {
+            while (!(mask & 1)) {
+                mask >>= 1;
+                i++;
+            }
+            return i;
+        }
+    }
+#endif
+
+    const uint64_t k1 = ONES * c1;
+    const uint64_t k2 = ONES * c2;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+
+        uint64_t x1 = w ^ k1;
+        uint64_t x2 = w ^ k2;
+        if (((x1 - ONES) & ~x1 & HIGHS) | ((x2 - ONES) & ~x2 & HIGHS))
+            break;
+    }
+
+    for (; i < n; i++) {
+        if (p[i] == c1 || p[i] == c2)
+            return i;
+    }
+    return n;
+}
+
+static const double pow10_table[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int is_space(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int is_digit(uint8_t c) {
+    return (uint8_t)(c - '0') < 10;
+}
+
+// Decimal text to an integer mantissa and a power of ten, scaled once at
+// the end. Up to 19 significant digits are kept, the rest only shift
+// the exponent. Anything that is not a plain number reads as NAN.
+static float parse_number(const uint8_t* p, const uint8_t* end) {
+    while (p < end && is_space(*p)) p++;
+    while (end > p && is_space(end[-1])) end--;
+
+    if (p == end)
+        return NAN;
+
+    int neg = 0;
+    if (*p == '-' || *p == '+') {
+        neg = (*p == '-');
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exp10 = 0;
+    int any = 0;
+
+    for (; p < end && is_digit(*p); p++, any = 1) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += (mantissa != 0);
+        } else {
+            exp10++;
+        }
+    }
+
+    if (p < end && *p == '.') {
+        for (p++; p < end && is_digit(*p); p++, any = 1) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += (mantissa != 0);
+                exp10--;
+            }
+        }
+    }
+
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        int exp_neg = 0;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exp_neg = (*p == '-');
+            p++;
+        }
+
+        int e = 0;
+        for (; p < end && is_digit(*p); p++) {
+            if (e < 10000)
+                e = e * 10 + (*p - '0');
+        }
+        exp10 += exp_neg ? -e : e;
+    }
+
+    if (!any || p != end)
+        return NAN;
+
+    double v = (double)mantissa;
+    if (exp10 < 0) {
+        v = (exp10 >= -22) ? v / pow10_table[-exp10] : v * pow(10.0, exp10);
+    } else if (exp10 > 0) {
+        v = (exp10 <= 22) ? v * pow10_table[exp10] : v * pow(10.0, exp10);
+    }
+
+    return (float)(neg ? -v : v);
+}
+
+static int tabular_fill(tabular_reader_t* r) {
+    size_t tail = r->len - r->pos;
+    if (tail == r->cap) {
+        LOGE(TAG, "Record %lu does not fit in a %lu byte block", (unsigned long)r->n_record, (unsigned long)r->cap);
+        return -1;
+    }
+
+    memmove(r->buf, r->buf + r->pos, tail);
+    r->len = tail;
+    r->pos = 0;
+
+    size_t want = r->cap - r->len;
+    size_t got = fread(r->buf + r->len, 1, want, r->f);
+    r->len += got;
+    if (got < want)
+        r->eof = 1;
+
+    return 0;
+}
+
+// Next non-empty line without its terminator, 0 at the end of the file
+static int tabular_next_line(tabular_reader_t* r, const uint8_t** out_line, size_t* out_len) {
+    for (;;) {
+        size_t n = scan_for(r->buf + r->pos, r->len - r->pos, '\n', '\n');
+
+        if (r->pos + n < r->len || (r->eof && n > 0)) {
+            const uint8_t* line = r->buf + r->pos;
+            r->pos += (r->pos + n < r->len) ? n + 1 : n;
+
+            while (n > 0 && line[n - 1] == '\r') n--;
+            if (n == 0)
+                continue;
+
+            *out_line = line;
+            *out_len = n;
+            return 1;
+        }
+
+        if (r->eof)
+            return 0;
+
+        if (tabular_fill(r) != 0)
+            return -1;
+    }
+}
+
+static int tabular_parse_csv(tabular_reader_t* r, const uint8_t* line, size_t len, float* out_row) {
+    uint32_t col = 0;
+    size_t i = 0;
+
+    for (;;) {
+        size_t n = scan_for(line + i, len - i, (uint8_t)r->delim, (uint8_t)r->delim);
+        if (col < r->n_col)
+            out_row[col] = parse_number(line + i, line + i + n);
+        col++;
+
+        if (i + n >= len)
+            break;
+        i += n + 1;
+    }
+
+    if (col != r->n_col) {
+        LOGE(TAG, "Record %lu has %lu columns, expected %lu", (unsigned long)r->n_record, (unsigned long)col, (unsigned long)r->n_col);
+        return -1;
+    }
+    return 0;
+}
+
+static int tabular_parse_binary(tabular_reader_t* r, const uint8_t* record, float* out_row) {
+    const uint16_t one = 1;
+    int swap = (*(const uint8_t*)&one == 1) == (r->big_endian != 0);
+
+    for (uint32_t c = 0; c < r->n_col; c++) {
+        size_t size = idx_dtype_size(r->types[c]);
+        uint8_t field[8];
+
+        for (size_t b = 0; b < size; b++) {
+            field[b] = swap ? record[size - 1 - b] : record[b];
+        }
+        idx_to_f32(r->types[c], field, 1, &out_row[c]);
+
+        record += size;
+    }
+    return 0;
+}
+
+static int tabular_start(tabular_reader_t* r) {
+    fseek(r->f, 0, SEEK_SET);
+    r->len = 0;
+    r->pos = 0;
+    r->eof = 0;
+    r->n_record = 0;
+
+    if (!r->binary && r->skip_header) {
+        const uint8_t* line;
+        size_t len;
+        if (tabular_next_line(r, &line, &len) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int tabular_open(tabular_reader_t* r, const char* path, size_t block_size) {
+    memset(r, 0, sizeof(tabular_reader_t));
+
+    r->f = fopen(path, "rb");
+    if (!r->f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    r->cap = block_size ? block_size : TABULAR_DEFAULT_BLOCK_SIZE;
+    r->buf = (uint8_t*)perf_malloc(r->cap, PERF_MEM_DATASET);
+    if (!r->buf) {
+        LOGE(TAG, "Failed to allocate %lu bytes of memory", (unsigned long)r->cap);
+        fclose(r->f);
+        r->f = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int tabular_open_csv(tabular_reader_t* r, const char* path, char delim, uint32_t n_col, int skip_header, size_t block_size) {
+    if (tabular_open(r, path, block_size) != 0)
+        return -1;
+
+    r->delim = delim;
+    r->skip_header = (uint8_t)(skip_header != 0);
+    r->n_col = n_col;
+
+    if (tabular_start(r) != 0) {
+        tabular_close(r);
+        return -1;
+    }
+
+    if (r->n_col == 0) {
+        // Peek at the first data line, it stays in the buffer
+        const uint8_t* line;
+        size_t len;
+        if (tabular_next_line(r, &line, &len) != 1) {
+            LOGE(TAG, "No records in file %s", path);
+            tabular_close(r);
+            return -1;
+        }
+
+        r->n_col = 1;
+        for (size_t i = 0; i < len; i++) {
+            r->n_col += (line[i] == (uint8_t)delim);
+        }
+        r->pos = (size_t)(line - r->buf);
+    }
+
+    return 0;
+}
+
+int tabular_open_binary(tabular_reader_t* r, const char* path, const uint8_t* types, uint32_t n_col, int big_endian, size_t block_size) {
+    if (tabular_open(r, path, block_size) != 0)
+        return -1;
+
+    r->binary = 1;
+    r->big_endian = (uint8_t)(big_endian != 0);
+    r->n_col = n_col;
+
+    r->types = (uint8_t*)perf_malloc(n_col, PERF_MEM_DATASET);
+    if (!r->types) {
+        LOGE(TAG, "Failed to allocate memory");
+        tabular_close(r);
+        return -1;
+    }
+
+    for (uint32_t c = 0; c < n_col; c++) {
+        size_t size = idx_dtype_size(types[c]);
+        if (size == 0) {
+            LOGE(TAG, "Unsupported field type 0x%02x in column %lu", types[c], (unsigned long)c);
+            tabular_close(r);
+            return -1;
+        }
+        r->types[c] = types[c];
+        r->record_size += size;
+    }
+
+    return tabular_start(r);
+}
+
+void tabular_close(tabular_reader_t* r) {
+    if (r->f)
+        fclose(r->f);
+    perf_free(r->buf);
+    perf_free(r->types);
+
+    r->f = NULL;
+    r->buf = NULL;
+    r->types = NULL;
+}
+
+int tabular_next(tabular_reader_t* r, float* out_row) {
+    if (r->binary) {
+        while (r->len - r->pos < r->record_size) {
+            if (r->eof) {
+                if (r->len != r->pos) {
+                    LOGE(TAG, "Truncated record %lu", (unsigned long)r->n_record);
+                    return -1;
+                }
+                return 0;
+            }
+            if (tabular_fill(r) != 0)
+                return -1;
+        }
+
+        tabular_parse_binary(r, r->buf + r->pos, out_row);
+        r->pos += r->record_size;
+        r->n_record++;
+        return 1;
+    }
+
+    const uint8_t* line;
+    size_t len;
+    int ret = tabular_next_line(r, &line, &len);
+    if (ret != 1)
+        return ret;
+
+    if (tabular_parse_csv(r, line, len, out_row) != 0)
+        return -1;
+
+    r->n_record++;
+    return 1;
+}
+
+int tabular_rewind(tabular_reader_t* r) {
+    return tabular_start(r);
+}
+
+int64_t tabular_count(tabular_reader_t* r) {
+    if (tabular_rewind(r) != 0)
+        return -1;
+
+    int64_t count = 0;
+    if (r->binary) {
+        int64_t size = (file_seek64(r->f, 0, SEEK_END) == 0) ? file_tell64(r->f) : -1;
+        count = (size < 0) ? -1 : size / (int64_t)r->record_size;
+    } else {
+        const uint8_t* line;
+        size_t len;
+        int ret;
+        while ((ret = tabular_next_line(r, &line, &len)) == 1) {
+            count++;
+        }
+        if (ret < 0)
+            count = -1;
+    }
+
+    if (tabular_rewind(r) != 0)
+        return -1;
+    return count;
+}
+
+// Copy every column but the label into the feature vector
+static void tabular_split(const float* row, uint32_t n_col, uint32_t label_col, float* features) {
+    for (uint32_t c = 0, k = 0; c < n_col; c++) {
+        if (c != label_col)
+            features[k++] = row[c];
+    }
+}
+
+// Labels are class indices that fit the uint16_t of dataset_t; a NaN or
+// out-of-range float cannot be converted
+static int tabular_label(float value, uint16_t* out_label) {
+    if (!(value >= 0.0f && value <= (float)DATASET_MAX_LABEL) || value != floorf(value))
+        return -1;
+
+    *out_label = (uint16_t)value;
+    return 0;
+}
+
+static uint32_t tabular_n_feature(const tabular_reader_t* r, uint32_t label_col) {
+    return (label_col < r->n_col) ? r->n_col - 1 : r->n_col;
+}
+
+int64_t tabular_fit_encoder(tabular_reader_t* r, encoder_t* enc, uint32_t label_col) {
+    if (enc->n_feature != tabular_n_feature(r, label_col)) {
+        LOGE(TAG, "Encoder expects %lu features, records have %lu", (unsigned long)enc->n_feature, (unsigned long)tabular_n_feature(r, label_col));
+        return -1;
+    }
+
+    float* row = (float*)perf_malloc(sizeof(float) * r->n_col, PERF_MEM_SCRATCH);
+    float* features = (float*)perf_malloc(sizeof(float) * r->n_col, PERF_MEM_SCRATCH);
+    if (!row || !features || tabular_rewind(r) != 0) {
+        perf_free(row);
+        perf_free(features);
+        return -1;
+    }
+
+    int64_t count = 0;
+    int ret;
+    while ((ret = tabular_next(r, row)) == 1) {
+        tabular_split(row, r->n_col, label_col, features);
+        encoder_fit_update(enc, features);
+        count++;
+    }
+
+    perf_free(row);
+    perf_free(features);
+    return (ret < 0) ? -1 : count;
+}
+
+dataset_t* tabular_load_dataset(tabular_reader_t* r, const encoder_t* enc, uint32_t label_col) {
+    if (enc->n_feature != tabular_n_feature(r, label_col)) {
+        LOGE(TAG, "Encoder expects %lu features, records have %lu", (unsigned long)enc->n_feature, (unsigned long)tabular_n_feature(r, label_col));
+        return NULL;
+    }
+
+    int64_t count = tabular_count(r);
+    if (count <= 0 || count > UINT32_MAX) {
+        LOGE(TAG, "Invalid number of records %ld", (long)count);
+        return NULL;
+    }
+
+    dataset_t* ds = dataset_create((uint32_t)count, enc->n_feature * enc->n_bits);
+    float* row = (float*)perf_malloc(sizeof(float) * r->n_col, PERF_MEM_SCRATCH);
+    float* features = (float*)perf_malloc(sizeof(float) * r->n_col, PERF_MEM_SCRATCH);
+    uint8_t* bits = (uint8_t*)perf_malloc((size_t)enc->n_feature * enc->n_bits, PERF_MEM_SCRATCH);
+    if (!ds || !row || !features || !bits) {
+        LOGE(TAG, "Failed to allocate memory");
+        dataset_free(ds);
+        ds = NULL;
+        count = 0;
+    }
+
+    for (uint32_t i = 0; i < (uint32_t)count; i++) {
+        if (tabular_next(r, row) != 1) {
+            LOGE(TAG, "Failed to read record %lu", (unsigned long)i);
+            dataset_free(ds);
+            ds = NULL;
+            break;
+        }
+
+        tabular_split(row, r->n_col, label_col, features);
+        encoder_encode(enc, features, bits);
+
+        uint16_t label = 0;
+        if (label_col < r->n_col && tabular_label(row[label_col], &label) != 0) {
+            LOGE(TAG, "Invalid label in record %lu", (unsigned long)i);
+            dataset_free(ds);
+            ds = NULL;
+            break;
+        }
+        dataset_set(ds, i, bits, label);
+    }
+
+    perf_free(row);
+    perf_free(features);
+    perf_free(bits);
+    return ds;
+}
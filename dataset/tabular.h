@@ -0,0 +1,61 @@
+#ifndef _TABULAR_H_
+#define _TABULAR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <logging.h>
+#include "dataset.h"
+#include "encoder.h"
+
+#define TABULAR_DEFAULT_BLOCK_SIZE (256 * 1024)
+#define TABULAR_NO_LABEL UINT32_MAX
+
+// Streaming reader for numeric CSV and fixed-width binary records.
+// Only one block of block_size bytes is ever buffered, so memory stays
+// bounded whatever the size of the file. A record must fit in a block.
+typedef struct {
+    FILE* f;
+
+    uint8_t* buf;
+    size_t cap;
+    size_t len;
+    size_t pos;
+    uint8_t eof;
+
+    uint8_t binary;
+
+    // CSV
+    char delim;
+    uint8_t skip_header;
+
+    // Binary records, one IDX dtype code per column
+    uint8_t* types;
+    uint8_t big_endian;
+    size_t record_size;
+
+    uint32_t n_col;
+    uint64_t n_record;
+} tabular_reader_t;
+
+// n_col == 0 infers the column count from the first data line.
+// Quoted fields are not supported, empty fields read as NAN.
+int tabular_open_csv(tabular_reader_t* r, const char* path, char delim, uint32_t n_col, int skip_header, size_t block_size);
+int tabular_open_binary(tabular_reader_t* r, const char* path, const uint8_t* types, uint32_t n_col, int big_endian, size_t block_size);
+void tabular_close(tabular_reader_t* r);
+
+// Returns 1 with n_col values in out_row, 0 at the end, -1 on a malformed record
+int tabular_next(tabular_reader_t* r, float* out_row);
+int tabular_rewind(tabular_reader_t* r);
+int64_t tabular_count(tabular_reader_t* r);
+
+// One pass over the file to fit the encoder on every column but label_col
+int64_t tabular_fit_encoder(tabular_reader_t* r, encoder_t* enc, uint32_t label_col);
+
+// Encode every record straight into a packed dataset, label_col holds the
+// class. Fails on a label that is not a whole number from 0 to
+// DATASET_MAX_LABEL.
+dataset_t* tabular_load_dataset(tabular_reader_t* r, const encoder_t* enc, uint32_t label_col);
+
+#endif // _TABULAR_H_
@@ -1,5 +1,7 @@
 #include "mnist.h"
 
+#include <memstat.h>
+
 #if defined(__ZEPHYR__)
     LOG_MODULE_REGISTER(mnist);
 #endif
@@ -13,15 +15,8 @@ static inline float norm_cdf(float x) {
     return 0.5f * (1.0f + erff(x / 1.41421356237f)); // sqrt(2)
 }
 
-static uint32_t read_u32_be(const uint8_t *p) {
-    return ((uint32_t)p[0] << 24) |
-           ((uint32_t)p[1] << 16) |
-           ((uint32_t)p[2] << 8)  |
-           (uint32_t)p[3];
-}
-
 static float* mnist_int_to_float(uint8_t *src, int rows, int cols) {
-    float *dst = malloc(rows * cols * sizeof(float));
+    float *dst = perf_malloc(rows * cols * sizeof(float), PERF_MEM_SCRATCH);
 
     for (int i = 0; i < rows; i++) {
         for (int j = 0; j < cols; j++) {
@@ -90,7 +85,7 @@ uint8_t* mnist_booleanize_img_n_bit(
     misst_normalize_img(float_img, rows, cols);
 
     uint8_t* bool_img = mnist_booleanize_features(float_img, rows, cols, num_bits);
-    free(float_img);
+    perf_free(float_img);
 
     return bool_img;
 }
@@ -102,34 +97,23 @@ void mnist_booleanize_img(uint8_t* img, uint32_t size, uint8_t threshold) {
 }
 
 uint32_t mnist_image_info(const char* path, int* out_rows, int* out_cols) {
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        LOGE(TAG, "Failed to open file %s", path);
+    // Any 8-bit image set in IDX format (MNIST, Fashion-MNIST, KMNIST, EMNIST)
+    idx_file_t idx;
+    if (idx_open(&idx, path) != 0) {
         return 0;
     }
 
-    uint8_t header[16];
-    if (fread(header, 1, 16, f) != 16) { 
-        fclose(f);
-        LOGE(TAG, "Failed to read header from file %s", path);
-        return 0;
-    }
-
-    uint32_t magic      = read_u32_be(&header[0]);
-    uint32_t num_images = read_u32_be(&header[4]);
-    uint32_t rows       = read_u32_be(&header[8]);
-    uint32_t cols       = read_u32_be(&header[12]);
-
-    if (magic != 0x00000803) { 
-        fclose(f);
-        LOGE(TAG, "Invalid magic number in file %s", path);
+    if (idx.dtype != IDX_UINT8 || idx.rank != 3) {
+        LOGE(TAG, "Expected 8-bit images of rank 3 in file %s (dtype 0x%02x, rank %d)", path, idx.dtype, idx.rank);
+        idx_close(&idx);
         return 0;
     }
 
-    *out_rows = (int)rows;
-    *out_cols = (int)cols;
+    *out_rows = (int)idx.dims[1];
+    *out_cols = (int)idx.dims[2];
 
-    fclose(f);
+    uint32_t num_images = idx.n_item;
+    idx_close(&idx);
 
     return num_images;
 }
@@ -166,30 +150,37 @@ uint8_t* mnist_load_next_image(FILE* f, int idx, int rows, int cols) {
     return buf;
 }
 
-uint32_t mnist_label_info(const char* path) {
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        LOGE(TAG, "Failed to open file %s", path);
-        return 0;
+uint8_t* mnist_load_next_image_block(blockio_t* io, int rows, int cols) {
+    size_t total = (size_t) rows * cols;
+    uint8_t* buf = (uint8_t*) malloc( sizeof(uint8_t) * total);
+    if (!buf) {
+        LOGE(TAG, "Failed to allocate %d bytes of memory", total);
+        return NULL;
     }
 
-    uint8_t header[8];
-    if (fread(header, 1, 8, f) != 8) { 
-        fclose(f);
-        LOGE(TAG, "Failed to read header from file %s", path);
-        return 0;
+    if (blockio_read(io, buf, total) != total) {
+        LOGE(TAG, "Failed to read %d bytes data", total);
+        free(buf);
+        return NULL;
     }
 
-    uint32_t magic      = read_u32_be(&header[0]);
-    uint32_t num_labels = read_u32_be(&header[4]);
+    return buf;
+}
 
-    if (magic != 0x00000801) { 
-        fclose(f);
-        LOGE(TAG, "Invalid magic number in file %s", path);
+uint32_t mnist_label_info(const char* path) {
+    idx_file_t idx;
+    if (idx_open(&idx, path) != 0) {
+        return 0;
+    }
+
+    if (idx.dtype != IDX_UINT8 || idx.rank != 1) {
+        LOGE(TAG, "Expected 8-bit labels of rank 1 in file %s (dtype 0x%02x, rank %d)", path, idx.dtype, idx.rank);
+        idx_close(&idx);
         return 0;
     }
 
-    fclose(f);
+    uint32_t num_labels = idx.n_item;
+    idx_close(&idx);
 
     return num_labels;
 }
@@ -210,16 +201,142 @@ int8_t mnist_load_next_label(FILE* f, int idx) {
     return label;
 }
 
+int16_t mnist_load_next_label_block(blockio_t* io) {
+    uint8_t label;
+    if (blockio_read(io, &label, 1) != 1) { return -1; }
+
+    return label;
+}
+
+// Booleanize with the fitted encoder when given, else with the fixed
+// MNIST Gaussian n-bit scheme
+static dataset_t* mnist_load_dataset_with(const char* img_path, const char* label_path, int num_bits, const encoder_t* enc) {
+    int rows = 0, cols = 0;
+    uint32_t img_count = mnist_image_info(img_path, &rows, &cols);
+    uint32_t label_count = mnist_label_info(label_path);
+    if (img_count == 0 || img_count != label_count) {
+        LOGE(TAG, "Image count and label count do not match!");
+        return NULL;
+    }
+
+    idx_file_t imgs, labels;
+    if (idx_open(&imgs, img_path) != 0) {
+        return NULL;
+    }
+    if (idx_open(&labels, label_path) != 0) {
+        idx_close(&imgs);
+        return NULL;
+    }
+
+    if (enc && enc->n_feature != (uint32_t)(rows * cols)) {
+        LOGE(TAG, "Encoder expects %lu features, images have %d", (unsigned long)enc->n_feature, rows * cols);
+        idx_close(&imgs);
+        idx_close(&labels);
+        return NULL;
+    }
+
+    uint32_t n_feature = enc ? enc->n_feature * enc->n_bits : (uint32_t)(rows * cols * num_bits);
+    dataset_t* ds = dataset_create(img_count, n_feature);
+    uint8_t* bool_img = enc ? (uint8_t*)perf_malloc(n_feature, PERF_MEM_SCRATCH) : NULL;
+
+    // Stream both files in chunks so only a few hundred raw images are
+    // ever buffered, whatever the size of the set
+    const uint32_t chunk = 256;
+    if (!ds || (enc && !bool_img) || idx_stream_begin(&imgs, chunk) != 0 || idx_stream_begin(&labels, chunk) != 0) {
+        perf_free(bool_img);
+        dataset_free(ds);
+        idx_close(&imgs);
+        idx_close(&labels);
+        return NULL;
+    }
+
+    uint32_t i = 0;
+    uint32_t n_img, n_label;
+    const uint8_t* img_chunk;
+    while ((img_chunk = (const uint8_t*)idx_stream_next(&imgs, &n_img)) != NULL) {
+        const uint8_t* label_chunk = (const uint8_t*)idx_stream_next(&labels, &n_label);
+        if (!label_chunk || n_label != n_img) {
+            LOGE(TAG, "Failed to read labels for images %lu..%lu", (unsigned long)i, (unsigned long)(i + n_img));
+            dataset_free(ds);
+            ds = NULL;
+            break;
+        }
+
+        for (uint32_t k = 0; k < n_img; k++, i++) {
+            const uint8_t* img = img_chunk + (size_t)k * imgs.item_size;
+            if (enc) {
+                encoder_encode_u8(enc, img, bool_img);
+                dataset_set(ds, i, bool_img, label_chunk[k]);
+            } else {
+                uint8_t* n_bit_img = mnist_booleanize_img_n_bit((uint8_t*)img, rows, cols, num_bits);
+                if (!n_bit_img) {
+                    LOGE(TAG, "Failed to booleanize image %lu", (unsigned long)i);
+                    dataset_free(ds);
+                    ds = NULL;
+                    break;
+                }
+                dataset_set(ds, i, n_bit_img, label_chunk[k]);
+                free(n_bit_img);
+            }
+        }
+        if (!ds)
+            break;
+    }
+
+    // idx_stream_next() also returns NULL on a read error
+    if (ds && i != img_count) {
+        LOGE(TAG, "Read %lu of %lu images", (unsigned long)i, (unsigned long)img_count);
+        dataset_free(ds);
+        ds = NULL;
+    }
+
+    perf_free(bool_img);
+    idx_close(&imgs);
+    idx_close(&labels);
+
+    return ds;
+}
+
+dataset_t* mnist_load_dataset(const char* img_path, const char* label_path, int num_bits) {
+    return mnist_load_dataset_with(img_path, label_path, num_bits, NULL);
+}
+
+dataset_t* mnist_load_dataset_encoded(const char* img_path, const char* label_path, const encoder_t* enc) {
+    return mnist_load_dataset_with(img_path, label_path, 0, enc);
+}
+
+encoder_t* mnist_fit_encoder(const char* img_path, uint32_t n_bits) {
+    idx_file_t imgs;
+    if (idx_open(&imgs, img_path) != 0) {
+        return NULL;
+    }
+
+    encoder_t* enc = encoder_create((uint32_t)imgs.item_elems, n_bits, 256);
+    if (!enc || encoder_fit_idx(enc, &imgs) != 0 || encoder_fit_end(enc) != 0 || encoder_build_lut(enc) != 0) {
+        encoder_free(enc);
+        idx_close(&imgs);
+        return NULL;
+    }
+
+    idx_close(&imgs);
+    return enc;
+}
+
 // ASCII lib from (https://www.jianshu.com/p/1f58a0ebf5d9)
 static const char codeLib[] = "@B%8&WM#*oahkbdpqwmZO0QLCJUYXzcvunxrjft/\\|()1{}[]?-_+~<>i!lI;:,\"^`'.   ";
 void mnist_print_img(const uint8_t* buf)
 {
-    for(int y = 0; y < 28; y++) 
+    mnist_print_img_size(buf, 28, 28);
+}
+
+void mnist_print_img_size(const uint8_t* buf, int rows, int cols)
+{
+    for(int y = 0; y < rows; y++) 
     {
-        for (int x = 0; x < 28; x++) 
+        for (int x = 0; x < cols; x++) 
         {
             int index = 0; 
-            if(buf[y*28+x] > 75) index =69;
+            if(buf[y*cols+x] > 75) index =69;
             if(index < 0) index = 0;
                 printf("%c",codeLib[index]);
                 printf("%c",codeLib[index]);
@@ -10,6 +10,10 @@
 
 #include <stdint.h>
 #include <logging.h>
+#include <idx.h>
+#include <blockio.h>
+#include <dataset.h>
+#include <encoder.h>
 
 uint32_t mnist_image_info(const char* path, int* out_rows, int* out_cols);
 uint8_t* mnist_load_image(FILE* f, int idx, int rows, int cols);
@@ -19,7 +23,14 @@ uint32_t mnist_label_info(const char* path);
 int8_t mnist_load_label(FILE* f, int idx);
 int8_t mnist_load_next_label(FILE* f, int idx);
 
+// Same as the *_next_* readers, served from block-aligned reads.
+// Seek the reader past the IDX header (16 / 8 bytes) before the first call.
+uint8_t* mnist_load_next_image_block(blockio_t* io, int rows, int cols);
+// Labels are 0..255, -1 on a failed read
+int16_t mnist_load_next_label_block(blockio_t* io);
+
 void mnist_print_img(const uint8_t* buf);
+void mnist_print_img_size(const uint8_t* buf, int rows, int cols);
 
 // Static functions used internally
 // float* mnist_int_to_float(uint8_t *src, int rows, int cols);
@@ -40,4 +51,12 @@ uint8_t* mnist_booleanize_img_n_bit(
     int num_bits
 );
 
-void mnist_booleanize_img(uint8_t* img, uint32_t size, uint8_t threshold);
\ No newline at end of file
+void mnist_booleanize_img(uint8_t* img, uint32_t size, uint8_t threshold);
+
+// Load and booleanize a whole image/label pair into memory, for shuffled training
+dataset_t* mnist_load_dataset(const char* img_path, const char* label_path, int num_bits);
+
+// Quantile thermometer encoding fitted on the images in one streaming pass,
+// an alternative to the fixed MNIST mean/std Gaussian booleanizer
+encoder_t* mnist_fit_encoder(const char* img_path, uint32_t n_bits);
+dataset_t* mnist_load_dataset_encoded(const char* img_path, const char* label_path, const encoder_t* enc);
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "counters.h"
+
+#if defined(LIME_TM_COUNTERS)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <stdatomic.h>
+#endif
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(perf_counters);
+#endif
+
+static const char* TAG = "perf";
+
+static const char* NAMES[PERF_CTR_COUNT] = {
+    "clause_evaluate",
+    "clause_fire",
+    "literal_scan",
+    "feedback_type_i",
+    "feedback_type_ii",
+    "rng_draw",
+    "step",
+    "evaluate",
+};
+
+PERF_THREAD_LOCAL perf_counters_t* perf_counters_local;
+
+// Every block ever attached, pushed without a lock
+#if defined(_WIN32)
+    static perf_counters_t* volatile blocks;
+#else
+    static _Atomic(perf_counters_t*) blocks;
+#endif
+
+static perf_counters_t* first_block(void) {
+#if defined(_WIN32)
+    return (perf_counters_t*)InterlockedCompareExchangePointer((PVOID volatile*)&blocks, NULL, NULL);
+#else
+    return atomic_load(&blocks);
+#endif
+}
+
+perf_counters_t* perf_counters_attach(void) {
+    perf_counters_t* b = (perf_counters_t*)calloc(1, sizeof(perf_counters_t));
+    if (!b)
+        return NULL;
+
+#if defined(_WIN32)
+    PVOID head;
+    do {
+        head = (PVOID)blocks;
+        b->next = (perf_counters_t*)head;
+    } while (InterlockedCompareExchangePointer((PVOID volatile*)&blocks, b, head) != head);
+#else
+    perf_counters_t* head = atomic_load(&blocks);
+    do {
+        b->next = head;
+    } while (!atomic_compare_exchange_weak(&blocks, &head, b));
+#endif
+
+    perf_counters_local = b;
+    return b;
+}
+
+void perf_counters_snapshot(uint64_t out[PERF_CTR_COUNT]) {
+    memset(out, 0, PERF_CTR_COUNT * sizeof(uint64_t));
+    for (perf_counters_t* b = first_block(); b; b = b->next) {
+        for (int c = 0; c < PERF_CTR_COUNT; c++)
+            out[c] += b->v[c];
+    }
+}
+
+void perf_counters_reset(void) {
+    for (perf_counters_t* b = first_block(); b; b = b->next)
+        memset(b->v, 0, sizeof(b->v));
+}
+
+static double ratio(uint64_t a, uint64_t b) {
+    return b ? (double)a / (double)b : 0;
+}
+
+void perf_counters_report(void) {
+    uint64_t v[PERF_CTR_COUNT];
+    perf_counters_snapshot(v);
+
+    double scan = ratio(v[PERF_CTR_LITERAL_SCAN], v[PERF_CTR_CLAUSE_EVALUATE]);
+    double fire = ratio(v[PERF_CTR_CLAUSE_FIRE], v[PERF_CTR_CLAUSE_EVALUATE]);
+    double draws = ratio(v[PERF_CTR_RNG_DRAW], v[PERF_CTR_STEP]);
+
+#if defined(__ZEPHYR__) || defined(ESP_PLATFORM) || defined(__RTTHREAD__)
+    for (int c = 0; c < PERF_CTR_COUNT; c++)
+        LOGI(TAG, "%-18s %lu", NAMES[c], (unsigned long)v[c]);
+
+    // Integers only, not every platform logger formats floating point
+    LOGI(TAG, "literals/clause    %lu.%02lu", (unsigned long)scan, (unsigned long)(scan * 100) % 100);
+    LOGI(TAG, "fire rate          %lu.%02lu%%", (unsigned long)(fire * 100), (unsigned long)(fire * 10000) % 100);
+    LOGI(TAG, "rng draws/step     %lu.%02lu", (unsigned long)draws, (unsigned long)(draws * 100) % 100);
+#else
+    printf("{\"counters\": {");
+    for (int c = 0; c < PERF_CTR_COUNT; c++)
+        printf("%s\"%s\": %llu", c ? ", " : "", NAMES[c], (unsigned long long)v[c]);
+    printf("}, \"literals_per_clause\": %.4f, \"fire_rate\": %.6f, \"rng_draws_per_step\": %.4f}\n",
+           scan, fire, draws);
+    fflush(stdout);
+#endif
+}
+
+#else
+
+// Counters are disabled, see counters.h
+typedef int perf_counters_disabled_t;
+
+#endif // LIME_TM_COUNTERS
@@ -0,0 +1,75 @@
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <stdint.h>
+
+#if defined(ESP_PLATFORM)
+    #include "sdkconfig.h"
+#endif
+
+// Hot-path event counters, compiled in only when LIME_TM_COUNTERS is
+// defined (cmake -DLIME_TM_COUNTERS=ON, or CONFIG_LIME_TM_COUNTERS on
+// ESP-IDF). Otherwise every PERF_COUNT() and PERF_COUNTERS_*() below
+// expands to nothing and the library has no trace of them.
+//
+// Each thread counts into its own block, found through a thread-local
+// pointer, and the blocks are summed when reporting. Where thread-local
+// storage is unavailable all threads share one block.
+#if defined(CONFIG_LIME_TM_COUNTERS) && !defined(LIME_TM_COUNTERS)
+    #define LIME_TM_COUNTERS
+#endif
+
+typedef enum {
+    PERF_CTR_CLAUSE_EVALUATE,   // clause_evaluate() calls
+    PERF_CTR_CLAUSE_FIRE,       // ... that returned 1
+    PERF_CTR_LITERAL_SCAN,      // literals looked at before returning
+    PERF_CTR_FEEDBACK_TYPE_I,   // clause_update_type_I() calls
+    PERF_CTR_FEEDBACK_TYPE_II,  // clause_update_type_II() calls
+    PERF_CTR_RNG_DRAW,          // random numbers drawn
+    PERF_CTR_STEP,              // tsetlin_step() calls
+    PERF_CTR_EVALUATE,          // tsetlin_evaluate() calls
+    PERF_CTR_COUNT
+} perf_counter_t;
+
+#if defined(LIME_TM_COUNTERS)
+
+#include "thread_local.h"
+
+typedef struct perf_counters {
+    uint64_t v[PERF_CTR_COUNT];
+    struct perf_counters* next;
+} perf_counters_t;
+
+extern PERF_THREAD_LOCAL perf_counters_t* perf_counters_local;
+
+// Block of the calling thread, created on first use and never freed, so
+// that counts of finished threads still show up in reports
+perf_counters_t* perf_counters_attach(void);
+
+static inline void perf_count(perf_counter_t c, uint64_t n) {
+    perf_counters_t* b = perf_counters_local;
+    if (!b && !(b = perf_counters_attach()))
+        return;
+    b->v[c] += n;
+}
+
+// Sum over all threads
+void perf_counters_snapshot(uint64_t out[PERF_CTR_COUNT]);
+void perf_counters_reset(void);
+
+// LOGI lines on embedded targets, one JSON object on stdout elsewhere
+void perf_counters_report(void);
+
+#define PERF_COUNT(c, n)        perf_count((c), (n))
+#define PERF_COUNTERS_RESET()   perf_counters_reset()
+#define PERF_COUNTERS_REPORT()  perf_counters_report()
+
+#else
+
+#define PERF_COUNT(c, n)        ((void)0)
+#define PERF_COUNTERS_RESET()   ((void)0)
+#define PERF_COUNTERS_REPORT()  ((void)0)
+
+#endif // LIME_TM_COUNTERS
+
+#endif // _PERF_COUNTERS_H_
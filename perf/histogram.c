@@ -0,0 +1,91 @@
+#include "histogram.h"
+
+#include <string.h>
+
+#include <logging.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(perf_histogram);
+#endif
+
+static const char* TAG = "perf";
+
+static uint32_t msb(uint64_t v) {
+    uint32_t n = 0;
+    while (v >>= 1)
+        n++;
+    return n;
+}
+
+static uint32_t bucket_of(uint64_t v) {
+    if (v >= ((uint64_t)1 << PERF_HIST_MAX_BITS))
+        return PERF_HIST_BUCKETS - 1;
+    if (v < ((uint64_t)1 << PERF_HIST_SUB_BITS))
+        return (uint32_t)v;
+
+    uint32_t shift = msb(v) - (PERF_HIST_SUB_BITS - 1);
+    return shift * PERF_HIST_HALF + (uint32_t)(v >> shift);
+}
+
+// Largest value that still lands in bucket b
+static uint64_t bucket_top(uint32_t b) {
+    if (b < 2 * PERF_HIST_HALF)
+        return b;
+
+    uint32_t shift = b / PERF_HIST_HALF - 1;
+    uint64_t mantissa = b % PERF_HIST_HALF + PERF_HIST_HALF;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void perf_hist_reset(perf_hist_t* h) {
+    memset(h, 0, sizeof(perf_hist_t));
+    h->min = UINT64_MAX;
+}
+
+void perf_hist_record(perf_hist_t* h, uint64_t ns) {
+    h->counts[bucket_of(ns)]++;
+    h->n++;
+    h->sum += ns;
+    if (ns < h->min)
+        h->min = ns;
+    if (ns > h->max)
+        h->max = ns;
+}
+
+uint64_t perf_hist_percentile(const perf_hist_t* h, double q) {
+    if (h->n == 0)
+        return 0;
+
+    double r = q * (double)h->n;
+    uint64_t rank = (uint64_t)r;
+    if ((double)rank < r)
+        rank++;
+    if (rank < 1)
+        rank = 1;
+    if (rank > h->n)
+        rank = h->n;
+
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < PERF_HIST_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            // The last bucket also holds everything past its top
+            uint64_t top = (b == PERF_HIST_BUCKETS - 1) ? h->max : bucket_top(b);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+// Microseconds with two decimals as integers, since not every platform
+// logger formats floating point
+#define US_PARTS(ns) (unsigned long)((ns) / 1000), (unsigned long)((ns) % 1000 / 10)
+
+void perf_hist_print(const perf_hist_t* h, const char* name) {
+    uint64_t p50 = perf_hist_percentile(h, 0.50);
+    uint64_t p99 = perf_hist_percentile(h, 0.99);
+    uint64_t p999 = perf_hist_percentile(h, 0.999);
+
+    LOGI(TAG, "%-10s n %lu  p50 %lu.%02lu us  p99 %lu.%02lu us  p999 %lu.%02lu us  max %lu.%02lu us",
+         name, (unsigned long)h->n, US_PARTS(p50), US_PARTS(p99), US_PARTS(p999), US_PARTS(h->max));
+}
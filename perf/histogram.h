@@ -0,0 +1,38 @@
+#ifndef _PERF_HISTOGRAM_H_
+#define _PERF_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// HDR-style latency histogram with fixed storage, no allocation.
+//
+// Values below 2^PERF_HIST_SUB_BITS ns are counted exactly. Above that,
+// every power of two is split into 2^(PERF_HIST_SUB_BITS - 1) buckets,
+// so a reported percentile is within 1/32 (about 3%) of the true value
+// at any scale. Values of 2^PERF_HIST_MAX_BITS ns (about 68 s) and more
+// share the last bucket; max stays exact.
+#define PERF_HIST_SUB_BITS 6
+#define PERF_HIST_MAX_BITS 36
+#define PERF_HIST_HALF     (1u << (PERF_HIST_SUB_BITS - 1))
+#define PERF_HIST_BUCKETS  ((PERF_HIST_MAX_BITS - PERF_HIST_SUB_BITS + 2) * PERF_HIST_HALF)
+
+typedef struct {
+    uint32_t counts[PERF_HIST_BUCKETS];
+
+    uint64_t n;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} perf_hist_t;
+
+void perf_hist_reset(perf_hist_t* h);
+void perf_hist_record(perf_hist_t* h, uint64_t ns);
+
+// Smallest value at or above fraction q (0..1) of the samples, e.g.
+// 0.999 for p999. Reported as the top of its bucket, never above max.
+uint64_t perf_hist_percentile(const perf_hist_t* h, double q);
+
+// One line: count, p50, p99, p999 and max
+void perf_hist_print(const perf_hist_t* h, const char* name);
+
+#endif // _PERF_HISTOGRAM_H_
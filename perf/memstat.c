@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+
+#include "memstat.h"
+#include "spinlock.h"
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(perf_memstat);
+#endif
+
+static const char* TAG = "perf";
+
+static const char* NAMES[PERF_MEM_COUNT] = {
+    "model",
+    "dataset",
+    "scratch",
+};
+
+// Keeps the block behind it aligned for any type
+typedef union {
+    max_align_t align;
+    struct {
+        size_t size;
+        perf_mem_cat_t cat;
+    } info;
+} perf_mem_header_t;
+
+static perf_mem_stats_t stats;
+static size_t limit[PERF_MEM_COUNT];
+static perf_spinlock_t mem_lock = PERF_SPINLOCK_INIT;
+
+// Reserve size bytes of cat, lock held. Returns 0 if a limit says no.
+static int reserve(size_t size, perf_mem_cat_t cat) {
+    if (limit[cat] && stats.current_cat[cat] + size > limit[cat]) {
+        stats.n_denied++;
+        return 0;
+    }
+
+    stats.current += size;
+    stats.current_cat[cat] += size;
+    if (stats.current > stats.peak)
+        stats.peak = stats.current;
+    if (stats.current_cat[cat] > stats.peak_cat[cat])
+        stats.peak_cat[cat] = stats.current_cat[cat];
+    return 1;
+}
+
+static void release(size_t size, perf_mem_cat_t cat) {
+    stats.current -= size;
+    stats.current_cat[cat] -= size;
+}
+
+static void* attach(perf_mem_header_t* h, size_t size, perf_mem_cat_t cat) {
+    h->info.size = size;
+    h->info.cat = cat;
+    return h + 1;
+}
+
+void* perf_malloc(size_t size, perf_mem_cat_t cat) {
+    if (size > SIZE_MAX - sizeof(perf_mem_header_t))
+        return NULL;
+
+    perf_spin_lock(&mem_lock);
+    int ok = reserve(size, cat);
+    perf_spin_unlock(&mem_lock);
+    if (!ok) {
+        LOGW(TAG, "%lu bytes of %s over the limit", (unsigned long)size, NAMES[cat]);
+        return NULL;
+    }
+
+    perf_mem_header_t* h = (perf_mem_header_t*)malloc(sizeof(perf_mem_header_t) + size);
+
+    perf_spin_lock(&mem_lock);
+    if (h)
+        stats.n_alloc++;
+    else
+        release(size, cat);
+    perf_spin_unlock(&mem_lock);
+
+    return h ? attach(h, size, cat) : NULL;
+}
+
+void* perf_calloc(size_t n, size_t size, perf_mem_cat_t cat) {
+    if (size && n > SIZE_MAX / size)
+        return NULL;
+
+    void* ptr = perf_malloc(n * size, cat);
+    if (ptr)
+        memset(ptr, 0, n * size);
+    return ptr;
+}
+
+void* perf_realloc(void* ptr, size_t size, perf_mem_cat_t cat) {
+    if (!ptr)
+        return perf_malloc(size, cat);
+    if (size > SIZE_MAX - sizeof(perf_mem_header_t))
+        return NULL;
+
+    perf_mem_header_t* h = (perf_mem_header_t*)ptr - 1;
+    size_t old_size = h->info.size;
+    perf_mem_cat_t old_cat = h->info.cat;
+
+    // Account for the new size first, so a limit is checked before growing
+    perf_spin_lock(&mem_lock);
+    release(old_size, old_cat);
+    int ok = reserve(size, cat);
+    if (!ok)
+        reserve(old_size, old_cat);
+    perf_spin_unlock(&mem_lock);
+    if (!ok) {
+        LOGW(TAG, "%lu bytes of %s over the limit", (unsigned long)size, NAMES[cat]);
+        return NULL;
+    }
+
+    perf_mem_header_t* grown = (perf_mem_header_t*)realloc(h, sizeof(perf_mem_header_t) + size);
+    if (!grown) {
+        perf_spin_lock(&mem_lock);
+        release(size, cat);
+        reserve(old_size, old_cat);
+        perf_spin_unlock(&mem_lock);
+        return NULL;
+    }
+
+    return attach(grown, size, cat);
+}
+
+void perf_free(void* ptr) {
+    if (!ptr)
+        return;
+
+    perf_mem_header_t* h = (perf_mem_header_t*)ptr - 1;
+
+    perf_spin_lock(&mem_lock);
+    release(h->info.size, h->info.cat);
+    stats.n_free++;
+    perf_spin_unlock(&mem_lock);
+
+    free(h);
+}
+
+void perf_mem_stats(perf_mem_stats_t* out) {
+    perf_spin_lock(&mem_lock);
+    *out = stats;
+    perf_spin_unlock(&mem_lock);
+}
+
+void perf_mem_reset_peak(void) {
+    perf_spin_lock(&mem_lock);
+    stats.peak = stats.current;
+    for (int c = 0; c < PERF_MEM_COUNT; c++)
+        stats.peak_cat[c] = stats.current_cat[c];
+    perf_spin_unlock(&mem_lock);
+}
+
+void perf_mem_set_limit(perf_mem_cat_t cat, size_t bytes) {
+    perf_spin_lock(&mem_lock);
+    limit[cat] = bytes;
+    perf_spin_unlock(&mem_lock);
+}
+
+void perf_mem_print(void) {
+    perf_mem_stats_t s;
+    perf_mem_stats(&s);
+
+    LOGI(TAG, "heap       %lu bytes  peak %lu  blocks %lu  allocs %lu",
+         (unsigned long)s.current, (unsigned long)s.peak,
+         (unsigned long)(s.n_alloc - s.n_free), (unsigned long)s.n_alloc);
+    for (int c = 0; c < PERF_MEM_COUNT; c++) {
+        LOGI(TAG, "%-10s %lu bytes  peak %lu", NAMES[c],
+             (unsigned long)s.current_cat[c], (unsigned long)s.peak_cat[c]);
+    }
+    if (s.n_denied)
+        LOGI(TAG, "denied     %lu allocations over a limit", (unsigned long)s.n_denied);
+}
@@ -0,0 +1,50 @@
+#ifndef _PERF_MEMSTAT_H_
+#define _PERF_MEMSTAT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Accounted heap for the allocations the libraries own: models, datasets
+// and scratch buffers. Every block carries a small header with its size
+// and category, so current, peak and per-category bytes are exact.
+//
+// A block from perf_malloc() must go back through perf_free(). Buffers
+// the libraries hand to the caller to free() (images from mnist.c,
+// tsetlin_read_file(), tsetlin_dirty_create()) stay on plain malloc and
+// are not counted.
+typedef enum {
+    PERF_MEM_MODEL,     // unpacked models, flat and lazy models
+    PERF_MEM_DATASET,   // datasets, iterators and read buffers
+    PERF_MEM_SCRATCH,   // temporaries of training steps, pruning, I/O
+    PERF_MEM_COUNT
+} perf_mem_cat_t;
+
+typedef struct {
+    size_t current;
+    size_t peak;
+    size_t current_cat[PERF_MEM_COUNT];
+    size_t peak_cat[PERF_MEM_COUNT];
+
+    uint64_t n_alloc;   // live blocks: n_alloc - n_free
+    uint64_t n_free;
+    uint64_t n_denied;  // refused by a limit
+} perf_mem_stats_t;
+
+void* perf_malloc(size_t size, perf_mem_cat_t cat);
+void* perf_calloc(size_t n, size_t size, perf_mem_cat_t cat);
+void* perf_realloc(void* ptr, size_t size, perf_mem_cat_t cat);
+void perf_free(void* ptr);
+
+void perf_mem_stats(perf_mem_stats_t* out);
+
+// Start the peaks again from the current use, to find the peak of one
+// phase such as a training step
+void perf_mem_reset_peak(void);
+
+// Refuse allocations that would take cat past limit bytes, 0 for none
+void perf_mem_set_limit(perf_mem_cat_t cat, size_t limit);
+
+// Current and peak bytes, total and per category, via LOGI
+void perf_mem_print(void);
+
+#endif // _PERF_MEMSTAT_H_
@@ -0,0 +1,134 @@
+#ifndef _PERF_SPINLOCK_H_
+#define _PERF_SPINLOCK_H_
+
+// Short lock for perf bookkeeping, held for a few stores at a time and
+// never across I/O. Define locks with PERF_SPINLOCK_INIT.
+//
+// On the RTOS ports it is the kernel's own critical section, so a holder
+// is never preempted by a thread spinning on the same lock. On a desktop
+// OS a waiter gives up its time slice while the lock stays taken.
+// perf_yield() is for waiting on a flag that another thread clears
+// outside the lock.
+
+#if defined(__ZEPHYR__)
+    /* ================= Zephyr ================= */
+    #include <zephyr/kernel.h>
+
+    typedef struct {
+        struct k_spinlock lock;
+        k_spinlock_key_t key;
+    } perf_spinlock_t;
+
+    #define PERF_SPINLOCK_INIT { 0 }
+
+    static inline void perf_spin_lock(perf_spinlock_t* lock) {
+        k_spinlock_key_t key = k_spin_lock(&lock->lock);
+        lock->key = key;
+    }
+
+    static inline void perf_spin_unlock(perf_spinlock_t* lock) {
+        k_spin_unlock(&lock->lock, lock->key);
+    }
+
+    static inline void perf_yield(void) {
+        k_yield();
+    }
+
+#elif defined(ESP_PLATFORM)
+    /* ================= ESP-IDF ================= */
+    #include "freertos/FreeRTOS.h"
+    #include "freertos/task.h"
+
+    typedef portMUX_TYPE perf_spinlock_t;
+
+    #define PERF_SPINLOCK_INIT portMUX_INITIALIZER_UNLOCKED
+
+    static inline void perf_spin_lock(perf_spinlock_t* lock) {
+        portENTER_CRITICAL(lock);
+    }
+
+    static inline void perf_spin_unlock(perf_spinlock_t* lock) {
+        portEXIT_CRITICAL(lock);
+    }
+
+    static inline void perf_yield(void) {
+        // taskYIELD() would keep a lower priority writer from running
+        vTaskDelay(1);
+    }
+
+#elif defined(__RTTHREAD__)
+    /* ================= RT-Thread ================= */
+    #include <rtthread.h>
+
+    // The scheduler lock is global, the lock itself only names the data
+    typedef struct {
+        char unused;
+    } perf_spinlock_t;
+
+    #define PERF_SPINLOCK_INIT { 0 }
+
+    static inline void perf_spin_lock(perf_spinlock_t* lock) {
+        (void)lock;
+        rt_enter_critical();
+    }
+
+    static inline void perf_spin_unlock(perf_spinlock_t* lock) {
+        (void)lock;
+        rt_exit_critical();
+    }
+
+    static inline void perf_yield(void) {
+        rt_thread_delay(1);
+    }
+
+#elif defined(_WIN32)
+    /* ================= Windows ================= */
+    #include <windows.h>
+
+    typedef volatile LONG perf_spinlock_t;
+
+    #define PERF_SPINLOCK_INIT 0
+
+    static inline void perf_yield(void) {
+        SwitchToThread();
+    }
+
+    static inline void perf_spin_lock(perf_spinlock_t* lock) {
+        for (int spin = 0; InterlockedExchange(lock, 1); spin++) {
+            if (spin < 64)
+                YieldProcessor();
+            else
+                perf_yield();
+        }
+    }
+
+    static inline void perf_spin_unlock(perf_spinlock_t* lock) {
+        InterlockedExchange(lock, 0);
+    }
+
+#else
+    /* ================= POSIX ================= */
+    #include <sched.h>
+    #include <stdatomic.h>
+
+    typedef atomic_flag perf_spinlock_t;
+
+    #define PERF_SPINLOCK_INIT ATOMIC_FLAG_INIT
+
+    static inline void perf_yield(void) {
+        sched_yield();
+    }
+
+    static inline void perf_spin_lock(perf_spinlock_t* lock) {
+        for (int spin = 0; atomic_flag_test_and_set_explicit(lock, memory_order_acquire); spin++) {
+            if (spin >= 64)
+                perf_yield();
+        }
+    }
+
+    static inline void perf_spin_unlock(perf_spinlock_t* lock) {
+        atomic_flag_clear_explicit(lock, memory_order_release);
+    }
+#endif
+
+#endif // _PERF_SPINLOCK_H_
@@ -0,0 +1,15 @@
+#ifndef _PERF_THREAD_LOCAL_H_
+#define _PERF_THREAD_LOCAL_H_
+
+// Storage class of per-thread perf state. Empty where thread-local
+// storage is unavailable (RT-Thread, Zephyr without
+// CONFIG_THREAD_LOCAL_STORAGE), so every thread shares one instance.
+#if defined(_MSC_VER)
+    #define PERF_THREAD_LOCAL __declspec(thread)
+#elif defined(__RTTHREAD__) || (defined(__ZEPHYR__) && !defined(CONFIG_THREAD_LOCAL_STORAGE))
+    #define PERF_THREAD_LOCAL
+#else
+    #define PERF_THREAD_LOCAL _Thread_local
+#endif
+
+#endif // _PERF_THREAD_LOCAL_H_
@@ -0,0 +1,32 @@
+#include "timer.h"
+
+#if defined(__ZEPHYR__) && !defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+
+static struct k_spinlock timer_lock;
+static uint32_t last_cycles;
+static int64_t last_ticks;
+static uint64_t total_cycles;
+
+uint64_t perf_now_ns(void) {
+    k_spinlock_key_t key = k_spin_lock(&timer_lock);
+
+    uint32_t now = k_cycle_get_32();
+    int64_t ticks = k_uptime_ticks();
+
+    // Cycles since the last call, plus the wraps the coarse system clock
+    // says were missed in between
+    uint64_t elapsed = (uint32_t)(now - last_cycles);
+    int64_t missed = (int64_t)k_ticks_to_cyc_floor64((uint64_t)(ticks - last_ticks)) - (int64_t)elapsed;
+    if (missed > 0)
+        elapsed += ((uint64_t)missed + ((uint64_t)1 << 31)) >> 32 << 32;
+
+    total_cycles += elapsed;
+    last_cycles = now;
+    last_ticks = ticks;
+    uint64_t cycles = total_cycles;
+
+    k_spin_unlock(&timer_lock, key);
+    return k_cyc_to_ns_floor64(cycles);
+}
+
+#endif
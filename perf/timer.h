@@ -0,0 +1,64 @@
+#ifndef PERF_TIMER_H
+#define PERF_TIMER_H
+
+#include <stdint.h>
+
+// Monotonic time in nanoseconds, for measuring intervals only. The
+// resolution is whatever the platform clock offers: a cycle counter on
+// Zephyr, 1 us from esp_timer, one OS tick (RT_TICK_PER_SECOND) on
+// RT-Thread and usually well under 1 us on a desktop OS.
+
+#if defined(__ZEPHYR__)
+    /* ================= Zephyr ================= */
+    #include <zephyr/kernel.h>
+
+    #if defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+        static inline uint64_t perf_now_ns(void) {
+            return k_cyc_to_ns_floor64(k_cycle_get_64());
+        }
+    #else
+        // The 32-bit counter wraps every few seconds, so it is extended in
+        // timer.c, with one wrap state for every caller
+        uint64_t perf_now_ns(void);
+    #endif
+
+#elif defined(ESP_PLATFORM)
+    /* ================= ESP-IDF ================= */
+    #include "esp_timer.h"
+
+    static inline uint64_t perf_now_ns(void) {
+        return (uint64_t)esp_timer_get_time() * 1000u;
+    }
+
+#elif defined(__RTTHREAD__)
+    /* ================= RT-Thread ================= */
+    #include <rtthread.h>
+
+    static inline uint64_t perf_now_ns(void) {
+        return (uint64_t)rt_tick_get() * (1000000000u / RT_TICK_PER_SECOND);
+    }
+
+#elif defined(_WIN32)
+    /* ================= Windows ================= */
+    #include <windows.h>
+
+    static inline uint64_t perf_now_ns(void) {
+        LARGE_INTEGER freq, count;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&count);
+        return (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000000u +
+               (uint64_t)(count.QuadPart % freq.QuadPart) * 1000000000u / (uint64_t)freq.QuadPart;
+    }
+
+#else
+    /* ================= POSIX ================= */
+    #include <time.h>
+
+    static inline uint64_t perf_now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    }
+#endif
+
+#endif /* PERF_TIMER_H */
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <logging.h>
+
+#include "trace.h"
+#include "thread_local.h"
+#include "spinlock.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <stdatomic.h>
+#endif
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(perf_trace);
+#endif
+
+static const char* TAG = "perf";
+
+// Threads that can be named, later ones keep a numbered track
+#define PERF_TRACE_MAX_THREAD 16
+
+typedef struct {
+    uint32_t tid;
+    const char* name;
+} trace_thread_t;
+
+// Events are recorded into ring. A full ring is swapped with spare under
+// the lock and written out after it is released, while recording goes
+// on into the other one.
+static struct {
+    perf_trace_event_t buffers[2][PERF_TRACE_RING];
+    perf_trace_event_t* ring;
+    perf_trace_event_t* spare;
+    uint64_t head;   // events recorded
+    uint64_t tail;   // events handed out for writing
+    int writing;     // spare is in use outside the lock
+
+    FILE* f;
+    uint32_t n_written;
+    uint64_t t0;
+    volatile int active;
+
+    trace_thread_t threads[PERF_TRACE_MAX_THREAD];
+    uint32_t n_thread;
+} trace = { .ring = trace.buffers[0], .spare = trace.buffers[1] };
+
+static PERF_THREAD_LOCAL uint32_t thread_id;
+
+static perf_spinlock_t trace_lock = PERF_SPINLOCK_INIT;
+
+#if defined(_WIN32)
+    static volatile LONG next_tid;
+
+    static uint32_t new_tid(void) {
+        return (uint32_t)InterlockedIncrement(&next_tid);
+    }
+#else
+    static atomic_uint next_tid;
+
+    static uint32_t new_tid(void) {
+        return (uint32_t)atomic_fetch_add(&next_tid, 1) + 1;
+    }
+#endif
+
+static uint32_t current_tid(void) {
+    if (!thread_id)
+        thread_id = new_tid();
+    return thread_id;
+}
+
+// Microseconds since perf_trace_open(), as Chrome expects
+static double trace_us(uint64_t ns) {
+    return ns > trace.t0 ? (double)(ns - trace.t0) / 1000.0 : 0;
+}
+
+static void write_event(FILE* f, uint32_t* n_written, const perf_trace_event_t* e) {
+    fprintf(f, "%s\n", (*n_written)++ ? "," : "");
+
+    switch (e->ph) {
+        case 'X':
+            fprintf(f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu}",
+                    e->name, e->cat, trace_us(e->ts_ns), (double)e->dur_ns / 1000.0, (unsigned long)e->tid);
+            break;
+        case 'i':
+            fprintf(f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu}",
+                    e->name, e->cat, trace_us(e->ts_ns), (unsigned long)e->tid);
+            break;
+        case 'C':
+            fprintf(f, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"value\":%.6g}}",
+                    e->name, trace_us(e->ts_ns), (unsigned long)e->tid, e->value);
+            break;
+        default:
+            break;
+    }
+}
+
+static void write_events(FILE* f, uint32_t* n_written, const perf_trace_event_t* ring, uint64_t first, uint64_t last) {
+    for (uint64_t i = first; i < last; i++)
+        write_event(f, n_written, &ring[i % PERF_TRACE_RING]);
+}
+
+static void write_thread_names(FILE* f, uint32_t* n_written, const trace_thread_t* threads, uint32_t n_thread) {
+    for (uint32_t i = 0; i < n_thread; i++) {
+        fprintf(f, "%s\n", (*n_written)++ ? "," : "");
+        fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                (unsigned long)threads[i].tid, threads[i].name);
+    }
+}
+
+// Take the spare ring for use outside the lock, waiting for a previous
+// writer to finish with it. Returns with the lock held.
+static void acquire_spare(void) {
+    perf_spin_lock(&trace_lock);
+    while (trace.writing) {
+        perf_spin_unlock(&trace_lock);
+        perf_yield();
+        perf_spin_lock(&trace_lock);
+    }
+    trace.writing = 1;
+}
+
+static void release_spare(void) {
+    perf_spin_lock(&trace_lock);
+    trace.writing = 0;
+    perf_spin_unlock(&trace_lock);
+}
+
+static void record(perf_trace_event_t* e) {
+    e->tid = current_tid();
+
+    for (;;) {
+        perf_spin_lock(&trace_lock);
+        if (!trace.active) {
+            perf_spin_unlock(&trace_lock);
+            return;
+        }
+        if (!trace.f || trace.head - trace.tail < PERF_TRACE_RING) {
+            trace.ring[trace.head % PERF_TRACE_RING] = *e;
+            trace.head++;
+            perf_spin_unlock(&trace_lock);
+            return;
+        }
+
+        // Full, and another thread is still writing the previous ring out
+        if (trace.writing) {
+            perf_spin_unlock(&trace_lock);
+            perf_yield();
+            continue;
+        }
+
+        perf_trace_event_t* full = trace.ring;
+        uint64_t first = trace.tail;
+        uint64_t last = trace.head;
+        FILE* f = trace.f;
+        trace.ring = trace.spare;
+        trace.spare = full;
+        trace.tail = last;
+        trace.writing = 1;
+        perf_spin_unlock(&trace_lock);
+
+        // Only the thread holding the spare ring writes to the file
+        write_events(f, &trace.n_written, full, first, last);
+        release_spare();
+    }
+}
+
+int perf_trace_open(const char* path) {
+    FILE* f = NULL;
+    if (path) {
+        f = fopen(path, "w");
+        if (!f) {
+            LOGE(TAG, "Failed to open file %s", path);
+            return -1;
+        }
+        fprintf(f, "{\"traceEvents\":[");
+    }
+
+    acquire_spare();
+    trace.f = f;
+    trace.head = 0;
+    trace.tail = 0;
+    trace.n_written = 0;
+    trace.t0 = perf_now_ns();
+    trace.active = 1;
+    trace.writing = 0;
+    perf_spin_unlock(&trace_lock);
+
+    return 0;
+}
+
+void perf_trace_close(void) {
+    // Stop recording, and wait for a ring being written out
+    perf_spin_lock(&trace_lock);
+    trace.active = 0;
+    perf_spin_unlock(&trace_lock);
+    acquire_spare();
+
+    FILE* f = trace.f;
+    uint64_t first = trace.tail;
+    uint64_t last = trace.head;
+    trace_thread_t threads[PERF_TRACE_MAX_THREAD];
+    uint32_t n_thread = trace.n_thread;
+    memcpy(threads, trace.threads, sizeof(threads));
+    trace.f = NULL;
+    trace.tail = last;
+    perf_spin_unlock(&trace_lock);
+
+    if (f) {
+        write_events(f, &trace.n_written, trace.ring, first, last);
+        write_thread_names(f, &trace.n_written, threads, n_thread);
+        fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    }
+    release_spare();
+
+    if (f && fclose(f) != 0)
+        LOGE(TAG, "Failed to write the trace");
+}
+
+void perf_trace_dump(void) {
+    // Copy the ring into the spare one, and print that with recording
+    // still going on
+    acquire_spare();
+
+    // Without a file the ring has kept only the latest events
+    uint64_t first = trace.tail;
+    uint64_t last = trace.head;
+    if (!trace.f && last - first > PERF_TRACE_RING)
+        first = last - PERF_TRACE_RING;
+    uint64_t n_lost = first - trace.tail;
+
+    perf_trace_event_t* copy = trace.spare;
+    memcpy(copy, trace.ring, sizeof(trace.buffers[0]));
+    trace_thread_t threads[PERF_TRACE_MAX_THREAD];
+    uint32_t n_thread = trace.n_thread;
+    memcpy(threads, trace.threads, sizeof(threads));
+    perf_spin_unlock(&trace_lock);
+
+    if (n_lost)
+        LOGW(TAG, "Trace ring overwrote %llu older events", (unsigned long long)n_lost);
+
+    uint32_t n_written = 0;
+    printf("[");
+    write_events(stdout, &n_written, copy, first, last);
+    write_thread_names(stdout, &n_written, threads, n_thread);
+    printf("\n]\n");
+    fflush(stdout);
+
+    release_spare();
+}
+
+void perf_trace_complete(const char* cat, const char* name, uint64_t start_ns, uint64_t end_ns) {
+    if (!trace.active)
+        return;
+
+    perf_trace_event_t e = { cat, name, start_ns, end_ns > start_ns ? end_ns - start_ns : 0, 0, 0, 'X' };
+    record(&e);
+}
+
+void perf_trace_instant(const char* cat, const char* name) {
+    if (!trace.active)
+        return;
+
+    perf_trace_event_t e = { cat, name, perf_now_ns(), 0, 0, 0, 'i' };
+    record(&e);
+}
+
+void perf_trace_counter(const char* name, double value) {
+    if (!trace.active)
+        return;
+
+    perf_trace_event_t e = { "counter", name, perf_now_ns(), 0, value, 0, 'C' };
+    record(&e);
+}
+
+void perf_trace_thread_name(const char* name) {
+    uint32_t tid = current_tid();
+
+    perf_spin_lock(&trace_lock);
+    uint32_t i = 0;
+    while (i < trace.n_thread && trace.threads[i].tid != tid)
+        i++;
+    if (i < PERF_TRACE_MAX_THREAD) {
+        trace.threads[i].tid = tid;
+        trace.threads[i].name = name;
+        if (i == trace.n_thread)
+            trace.n_thread++;
+    }
+    perf_spin_unlock(&trace_lock);
+}
@@ -0,0 +1,70 @@
+#ifndef _PERF_TRACE_H_
+#define _PERF_TRACE_H_
+
+#include <stdint.h>
+
+#include "timer.h"
+
+// Timeline of training and inference phases in the Chrome trace event
+// format, viewable in chrome://tracing or ui.perfetto.dev.
+//
+// Events go into a fixed ring without allocation. With a file open
+// (host builds) the ring is written out whenever it fills, so nothing is
+// lost. Without one (embedded ports) the oldest events are overwritten
+// and perf_trace_dump() prints what is left as a JSON array.
+//
+// Nothing is recorded until perf_trace_open(), and a closed trace costs
+// one branch per event. Names and categories are stored by pointer and
+// must outlive the trace, string literals in practice.
+#ifndef PERF_TRACE_RING
+    #if defined(__ZEPHYR__) || defined(ESP_PLATFORM) || defined(__RTTHREAD__)
+        #define PERF_TRACE_RING 128
+    #else
+        #define PERF_TRACE_RING 4096
+    #endif
+#endif
+
+typedef struct {
+    const char* cat;
+    const char* name;
+    uint64_t ts_ns;
+    uint64_t dur_ns;
+    double value;      // counter events
+    uint32_t tid;
+    char ph;           // 'X' complete, 'i' instant, 'C' counter, 'M' thread name
+} perf_trace_event_t;
+
+// Start recording, streaming to path, or only into the ring if path is
+// NULL. Timestamps count from here.
+int perf_trace_open(const char* path);
+
+// Stop recording, and write out and finish the file if there is one
+void perf_trace_close(void);
+
+// Ring contents as a Chrome trace JSON array on stdout
+void perf_trace_dump(void);
+
+void perf_trace_complete(const char* cat, const char* name, uint64_t start_ns, uint64_t end_ns);
+void perf_trace_instant(const char* cat, const char* name);
+void perf_trace_counter(const char* name, double value);
+
+// Label the calling thread's track, e.g. "worker 2"
+void perf_trace_thread_name(const char* name);
+
+// Scoped event: perf_trace_begin() on entry, perf_trace_end() on every exit
+typedef struct {
+    const char* cat;
+    const char* name;
+    uint64_t start_ns;
+} perf_trace_scope_t;
+
+static inline perf_trace_scope_t perf_trace_begin(const char* cat, const char* name) {
+    perf_trace_scope_t scope = { cat, name, perf_now_ns() };
+    return scope;
+}
+
+static inline void perf_trace_end(const perf_trace_scope_t* scope) {
+    perf_trace_complete(scope->cat, scope->name, scope->start_ns, perf_now_ns());
+}
+
+#endif // _PERF_TRACE_H_
@@ -60,6 +60,12 @@
 # define inline __inline
 #endif
 
+/* SSE2 fast path for packed varint arrays, see parse_packed_uint32(). */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define PROTOBUF_C_HAVE_SSE2 1
+#endif
+
 /**
  * \defgroup internal Internal functions and macros
  *
@@ -185,6 +191,20 @@ static ProtobufCAllocator protobuf_c__allocator = {
 	.allocator_data = NULL,
 };
 
+/*
+ * Temporaries of protobuf_c_message_unpack(), see
+ * protobuf_c_set_scratch_allocator().
+ */
+static ProtobufCAllocator *protobuf_c__scratch_allocator = &protobuf_c__allocator;
+
+void
+protobuf_c_set_scratch_allocator(ProtobufCAllocator *allocator)
+{
+	if (allocator == NULL)
+		allocator = &protobuf_c__allocator;
+	protobuf_c__scratch_allocator = allocator;
+}
+
 /* === buffer-simple === */
 
 void
@@ -2148,6 +2168,28 @@ static size_t
 max_b128_numbers(size_t len, const uint8_t *data)
 {
 	size_t rv = 0;
+#if defined(PROTOBUF_C_HAVE_SSE2)
+	/* 16 bytes at a time: terminators are the bytes without the top bit */
+	while (len >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) data);
+		unsigned m = ~(unsigned) _mm_movemask_epi8(v) & 0xffff;
+		m = m - ((m >> 1) & 0x5555);
+		m = (m & 0x3333) + ((m >> 2) & 0x3333);
+		m = (m + (m >> 4)) & 0x0f0f;
+		rv += (m + (m >> 8)) & 0x1f;
+		data += 16;
+		len -= 16;
+	}
+#endif
+	/* 8 bytes at a time: sum the inverted top bits with one multiply */
+	while (len >= 8) {
+		uint64_t w;
+		memcpy(&w, data, 8);
+		w = (~w & 0x8080808080808080ULL) >> 7;
+		rv += (size_t) ((w * 0x0101010101010101ULL) >> 56);
+		data += 8;
+		len -= 8;
+	}
 	while (len--)
 		if ((*data++ & 0x80) == 0)
 			++rv;
@@ -2740,6 +2782,106 @@ scan_varint(unsigned len, const uint8_t *data)
 	return i + 1;
 }
 
+/**
+ * Bulk decoder for packed 32-bit varints (uint32, int32, enum, and sint32
+ * before unzigzag). Model data is almost entirely such arrays, with states
+ * taking one byte and feature positions one or two.
+ *
+ * - SSE2: a 16-byte block of sixteen 1-byte or eight 2-byte varints is
+ *   decoded with a handful of vector ops.
+ * - Little-endian: the same two shapes are recognised in an 8-byte word.
+ * - Everything else goes value by value. The 1- and 2-byte cases are
+ *   tested first; longer values use scan_varint() / parse_uint32().
+ *
+ * Returns the number of values written to out, or (size_t) -1 on a
+ * truncated varint.
+ */
+static size_t
+parse_packed_uint32(size_t rem, const uint8_t *at, uint32_t *out)
+{
+	size_t count = 0;
+
+	while (rem > 0) {
+#if defined(PROTOBUF_C_HAVE_SSE2)
+		if (rem >= 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *) at);
+			__m128i zero = _mm_setzero_si128();
+			int m = _mm_movemask_epi8(v);
+
+			if (m == 0) {
+				__m128i lo = _mm_unpacklo_epi8(v, zero);
+				__m128i hi = _mm_unpackhi_epi8(v, zero);
+				_mm_storeu_si128((__m128i *) (out + count + 0), _mm_unpacklo_epi16(lo, zero));
+				_mm_storeu_si128((__m128i *) (out + count + 4), _mm_unpackhi_epi16(lo, zero));
+				_mm_storeu_si128((__m128i *) (out + count + 8), _mm_unpacklo_epi16(hi, zero));
+				_mm_storeu_si128((__m128i *) (out + count + 12), _mm_unpackhi_epi16(hi, zero));
+				count += 16;
+				at += 16;
+				rem -= 16;
+				continue;
+			}
+			if (m == 0x5555) {
+				/* 16-bit lanes hold (low 7 | 0x80) + (high 7 << 8) */
+				__m128i x = _mm_or_si128(
+					_mm_and_si128(v, _mm_set1_epi16(0x7f)),
+					_mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi16(0x3f80)));
+				_mm_storeu_si128((__m128i *) (out + count + 0), _mm_unpacklo_epi16(x, zero));
+				_mm_storeu_si128((__m128i *) (out + count + 4), _mm_unpackhi_epi16(x, zero));
+				count += 8;
+				at += 16;
+				rem -= 16;
+				continue;
+			}
+		}
+#endif
+#if !defined(WORDS_BIGENDIAN)
+		if (rem >= 8) {
+			uint64_t w;
+			uint64_t c;
+			unsigned k;
+
+			memcpy(&w, at, 8);
+			c = w & 0x8080808080808080ULL;
+			if (c == 0) {
+				for (k = 0; k < 8; k++)
+					out[count + k] = (uint32_t) (w >> (8 * k)) & 0xff;
+				count += 8;
+				at += 8;
+				rem -= 8;
+				continue;
+			}
+			if (c == 0x0080008000800080ULL) {
+				for (k = 0; k < 4; k++) {
+					uint32_t x = (uint32_t) (w >> (16 * k)) & 0xffff;
+					out[count + k] = (x & 0x7f) | ((x >> 1) & 0x3f80);
+				}
+				count += 4;
+				at += 8;
+				rem -= 8;
+				continue;
+			}
+		}
+#endif
+		if (at[0] < 0x80) {
+			out[count++] = at[0];
+			at += 1;
+			rem -= 1;
+		} else if (rem >= 2 && at[1] < 0x80) {
+			out[count++] = (at[0] & 0x7f) | ((uint32_t) at[1] << 7);
+			at += 2;
+			rem -= 2;
+		} else {
+			unsigned s = scan_varint(rem > 10 ? 10 : (unsigned) rem, at);
+			if (s == 0)
+				return (size_t) -1;
+			out[count++] = parse_uint32(s, at);
+			at += s;
+			rem -= s;
+		}
+	}
+	return count;
+}
+
 static protobuf_c_boolean
 parse_packed_repeated_member(ScannedMember *scanned_member,
 			     void *member,
@@ -2752,9 +2894,7 @@ parse_packed_repeated_member(ScannedMember *scanned_member,
 	const uint8_t *at = scanned_member->data + scanned_member->length_prefix_len;
 	size_t rem = scanned_member->len - scanned_member->length_prefix_len;
 	size_t count = 0;
-#if defined(WORDS_BIGENDIAN)
-	unsigned i;
-#endif
+	size_t i;
 
 	switch (field->type) {
 	case PROTOBUF_C_TYPE_SFIXED32:
@@ -2785,40 +2925,21 @@ parse_packed_repeated_member(ScannedMember *scanned_member,
 #endif
 	case PROTOBUF_C_TYPE_ENUM:
 	case PROTOBUF_C_TYPE_INT32:
-		while (rem > 0) {
-			unsigned s = scan_varint(rem, at);
-			if (s == 0) {
-				PROTOBUF_C_UNPACK_ERROR("bad packed-repeated int32 value");
-				return FALSE;
-			}
-			((int32_t *) array)[count++] = parse_int32(s, at);
-			at += s;
-			rem -= s;
+	case PROTOBUF_C_TYPE_UINT32:
+		count = parse_packed_uint32(rem, at, (uint32_t *) array);
+		if (count == (size_t) -1) {
+			PROTOBUF_C_UNPACK_ERROR("bad packed-repeated enum, int32 or uint32 value");
+			return FALSE;
 		}
 		break;
 	case PROTOBUF_C_TYPE_SINT32:
-		while (rem > 0) {
-			unsigned s = scan_varint(rem, at);
-			if (s == 0) {
-				PROTOBUF_C_UNPACK_ERROR("bad packed-repeated sint32 value");
-				return FALSE;
-			}
-			((int32_t *) array)[count++] = unzigzag32(parse_uint32(s, at));
-			at += s;
-			rem -= s;
-		}
-		break;
-	case PROTOBUF_C_TYPE_UINT32:
-		while (rem > 0) {
-			unsigned s = scan_varint(rem, at);
-			if (s == 0) {
-				PROTOBUF_C_UNPACK_ERROR("bad packed-repeated enum or uint32 value");
-				return FALSE;
-			}
-			((uint32_t *) array)[count++] = parse_uint32(s, at);
-			at += s;
-			rem -= s;
+		count = parse_packed_uint32(rem, at, (uint32_t *) array);
+		if (count == (size_t) -1) {
+			PROTOBUF_C_UNPACK_ERROR("bad packed-repeated sint32 value");
+			return FALSE;
 		}
+		for (i = 0; i < count; i++)
+			((int32_t *) array)[i] = unzigzag32(((uint32_t *) array)[i]);
 		break;
 
 	case PROTOBUF_C_TYPE_SINT64:
@@ -3055,6 +3176,13 @@ protobuf_c_message_unpack(const ProtobufCMessageDescriptor *desc,
 	unsigned char *required_fields_bitmap = required_fields_bitmap_stack;
 	protobuf_c_boolean required_fields_bitmap_alloced = FALSE;
 
+	/*
+	 * Scan slabs and the required-fields bitmap never outlive this call,
+	 * so they come from the scratch allocator. A custom (e.g. arena)
+	 * allocator then only ever sees memory owned by the message.
+	 */
+	ProtobufCAllocator *scan_allocator = protobuf_c__scratch_allocator;
+
 	ASSERT_IS_MESSAGE_DESCRIPTOR(desc);
 
 	if (allocator == NULL)
@@ -3067,7 +3195,7 @@ protobuf_c_message_unpack(const ProtobufCMessageDescriptor *desc,
 
 	required_fields_bitmap_len = (desc->n_fields + 7) / 8;
 	if (required_fields_bitmap_len > sizeof(required_fields_bitmap_stack)) {
-		required_fields_bitmap = do_alloc(allocator, required_fields_bitmap_len);
+		required_fields_bitmap = do_alloc(scan_allocator, required_fields_bitmap_len);
 		if (!required_fields_bitmap) {
 			do_free(allocator, rv);
 			return (NULL);
@@ -3194,7 +3322,7 @@ protobuf_c_message_unpack(const ProtobufCMessageDescriptor *desc,
 			which_slab++;
 			size = sizeof(ScannedMember)
 				<< (which_slab + FIRST_SCANNED_MEMBER_SLAB_SIZE_LOG2);
-			scanned_member_slabs[which_slab] = do_alloc(allocator, size);
+			scanned_member_slabs[which_slab] = do_alloc(scan_allocator, size);
 			if (scanned_member_slabs[which_slab] == NULL)
 				goto error_cleanup_during_scan;
 		}
@@ -3300,25 +3428,25 @@ protobuf_c_message_unpack(const ProtobufCMessageDescriptor *desc,
 
 	/* cleanup */
 	for (j = 1; j <= which_slab; j++)
-		do_free(allocator, scanned_member_slabs[j]);
+		do_free(scan_allocator, scanned_member_slabs[j]);
 	if (required_fields_bitmap_alloced)
-		do_free(allocator, required_fields_bitmap);
+		do_free(scan_allocator, required_fields_bitmap);
 	return rv;
 
 error_cleanup:
 	protobuf_c_message_free_unpacked(rv, allocator);
 	for (j = 1; j <= which_slab; j++)
-		do_free(allocator, scanned_member_slabs[j]);
+		do_free(scan_allocator, scanned_member_slabs[j]);
 	if (required_fields_bitmap_alloced)
-		do_free(allocator, required_fields_bitmap);
+		do_free(scan_allocator, required_fields_bitmap);
 	return NULL;
 
 error_cleanup_during_scan:
 	do_free(allocator, rv);
 	for (j = 1; j <= which_slab; j++)
-		do_free(allocator, scanned_member_slabs[j]);
+		do_free(scan_allocator, scanned_member_slabs[j]);
 	if (required_fields_bitmap_alloced)
-		do_free(allocator, required_fields_bitmap);
+		do_free(scan_allocator, required_fields_bitmap);
 	return NULL;
 }
 
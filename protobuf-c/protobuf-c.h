@@ -963,6 +963,19 @@ protobuf_c_message_unpack(
 	size_t len,
 	const uint8_t *data);
 
+/**
+ * Set the allocator for the temporary memory of protobuf_c_message_unpack(),
+ * the scan slabs and the required-fields bitmap. These are freed before the
+ * call returns, so the message allocator never sees them.
+ *
+ * \param allocator
+ *      `ProtobufCAllocator` to use for scratch memory. May be NULL to
+ *      restore the default allocator.
+ */
+PROTOBUF_C__API
+void
+protobuf_c_set_scratch_allocator(ProtobufCAllocator *allocator);
+
 /**
  * Free an unpacked message object.
  *
@@ -206,7 +206,7 @@ const ProtobufCMessageDescriptor clause__descriptor =
   (ProtobufCMessageInit) clause__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
-static const ProtobufCFieldDescriptor clause_compressed__field_descriptors[5] =
+static const ProtobufCFieldDescriptor clause_compressed__field_descriptors[9] =
 {
   {
     "n_pos_literal",
@@ -268,6 +268,54 @@ static const ProtobufCFieldDescriptor clause_compressed__field_descriptors[5] =
     0 | PROTOBUF_C_FIELD_FLAG_PACKED,             /* flags */
     0,NULL,NULL    /* reserved1,reserved2, etc */
   },
+  {
+    "state",
+    6,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_BYTES,
+    0,   /* quantifier_offset */
+    offsetof(ClauseCompressed, state),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "state_width",
+    7,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(ClauseCompressed, state_width),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "position_delta",
+    8,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_BYTES,
+    0,   /* quantifier_offset */
+    offsetof(ClauseCompressed, position_delta),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "position_bitmap",
+    9,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_BYTES,
+    0,   /* quantifier_offset */
+    offsetof(ClauseCompressed, position_bitmap),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
 };
 static const unsigned clause_compressed__field_indices_by_name[] = {
   4,   /* field[4] = data */
@@ -275,11 +323,15 @@ static const unsigned clause_compressed__field_indices_by_name[] = {
   0,   /* field[0] = n_pos_literal */
   2,   /* field[2] = n_state */
   3,   /* field[3] = position */
+  8,   /* field[8] = position_bitmap */
+  7,   /* field[7] = position_delta */
+  5,   /* field[5] = state */
+  6,   /* field[6] = state_width */
 };
 static const ProtobufCIntRange clause_compressed__number_ranges[1 + 1] =
 {
   { 1, 0 },
-  { 0, 5 }
+  { 0, 9 }
 };
 const ProtobufCMessageDescriptor clause_compressed__descriptor =
 {
@@ -289,14 +341,14 @@ const ProtobufCMessageDescriptor clause_compressed__descriptor =
   "ClauseCompressed",
   "",
   sizeof(ClauseCompressed),
-  5,
+  9,
   clause_compressed__field_descriptors,
   clause_compressed__field_indices_by_name,
   1,  clause_compressed__number_ranges,
   (ProtobufCMessageInit) clause_compressed__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
-static const ProtobufCFieldDescriptor tsetlin__field_descriptors[7] =
+static const ProtobufCFieldDescriptor tsetlin__field_descriptors[8] =
 {
   {
     "n_class",
@@ -382,6 +434,18 @@ static const ProtobufCFieldDescriptor tsetlin__field_descriptors[7] =
     0,             /* flags */
     0,NULL,NULL    /* reserved1,reserved2, etc */
   },
+  {
+    "version",
+    8,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(Tsetlin, version),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
 };
 static const unsigned tsetlin__field_indices_by_name[] = {
   5,   /* field[5] = clauses */
@@ -391,11 +455,12 @@ static const unsigned tsetlin__field_indices_by_name[] = {
   2,   /* field[2] = n_clause */
   1,   /* field[1] = n_feature */
   3,   /* field[3] = n_state */
+  7,   /* field[7] = version */
 };
 static const ProtobufCIntRange tsetlin__number_ranges[1 + 1] =
 {
   { 1, 0 },
-  { 0, 7 }
+  { 0, 8 }
 };
 const ProtobufCMessageDescriptor tsetlin__descriptor =
 {
@@ -405,7 +470,7 @@ const ProtobufCMessageDescriptor tsetlin__descriptor =
   "Tsetlin",
   "",
   sizeof(Tsetlin),
-  7,
+  8,
   tsetlin__field_descriptors,
   tsetlin__field_indices_by_name,
   1,  tsetlin__number_ranges,
@@ -54,10 +54,14 @@ struct  ClauseCompressed
   uint32_t *position;
   size_t n_data;
   uint32_t *data;
+  ProtobufCBinaryData state;
+  uint32_t state_width;
+  ProtobufCBinaryData position_delta;
+  ProtobufCBinaryData position_bitmap;
 };
 #define CLAUSE_COMPRESSED__INIT \
  { PROTOBUF_C_MESSAGE_INIT (&clause_compressed__descriptor) \
-    , 0, 0, 0, 0,NULL, 0,NULL }
+    , 0, 0, 0, 0,NULL, 0,NULL, {0,NULL}, 0, {0,NULL}, {0,NULL} }
 
 
 struct  Tsetlin
@@ -72,10 +76,11 @@ struct  Tsetlin
   Clause **clauses;
   size_t n_clauses_compressed;
   ClauseCompressed **clauses_compressed;
+  uint32_t version;
 };
 #define TSETLIN__INIT \
  { PROTOBUF_C_MESSAGE_INIT (&tsetlin__descriptor) \
-    , 0, 0, 0, 0, MODEL_TYPE__INFERENCE, 0,NULL, 0,NULL }
+    , 0, 0, 0, 0, MODEL_TYPE__INFERENCE, 0,NULL, 0,NULL, 0 }
 
 
 /* Clause methods */
@@ -11,6 +11,10 @@
 uint32_t xorshift128p_fast();
 uint32_t pcg32_fast();
 
+// Reentrant variant for callers that need their own reproducible stream
+// (e.g. dataset shuffling) without disturbing the global generator.
+uint32_t pcg32_fast_r(uint64_t* state);
+
 inline static int normal(double mean, double variance) {
     double u1 = (double) (fast_rand() + 1) / ((double) FAST_RAND_MAX + 1), u2 = (double) fast_rand() / FAST_RAND_MAX; // u1 in (0, 1] and u2 in [0, 1]
     double n1 = sqrt(-2 * log(u1)) * sin(8 * atan(1) * u2);
@@ -8,8 +8,12 @@ void pcg32_seed(uint64_t seed) {
 }
 
 uint32_t pcg32_fast() {
-    uint64_t x = mcg_state;
+    return pcg32_fast_r(&mcg_state);
+}
+
+uint32_t pcg32_fast_r(uint64_t* state) {
+    uint64_t x = *state;
     unsigned int count = (unsigned int)(x >> 61);	// 61 = 64 - 3
-    mcg_state = x * multiplier;
+    *state = x * multiplier;
     return (uint32_t)((x ^ x >> 22) >> (22 + count));	// 22 = 32 - 3 - 7
 }
\ No newline at end of file
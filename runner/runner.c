@@ -0,0 +1,732 @@
+#include "runner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mnist.h>
+#include <tsetlin.h>
+#include <fast_rand.h>
+#include <logging.h>
+#include <timer.h>
+#include <histogram.h>
+#include <counters.h>
+#include <trace.h>
+#include <memstat.h>
+
+#if defined(ESP_PLATFORM)
+    #include <sdkconfig.h>
+#endif
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(runner);
+#endif
+
+static const char* TAG = "runner";
+
+#define RUNNER_PATH_MAX 128
+
+// Pixels are booleanized into this many thermometer bits
+#define RUNNER_BITS 8
+
+#if defined(_WIN32)
+    #define RUNNER_OS "windows"
+#elif defined(__APPLE__)
+    #define RUNNER_OS "macos"
+#elif defined(__linux__)
+    #define RUNNER_OS "linux"
+#else
+    #define RUNNER_OS "posix"
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define RUNNER_ARCH "x86_64"
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define RUNNER_ARCH "arm64"
+#elif defined(__i386__) || defined(_M_IX86)
+    #define RUNNER_ARCH "x86"
+#elif defined(__arm__)
+    #define RUNNER_ARCH "arm"
+#elif defined(__riscv)
+    #define RUNNER_ARCH "riscv"
+#else
+    #define RUNNER_ARCH "unknown"
+#endif
+
+typedef struct {
+    uint32_t n_epoch;
+    uint32_t n_load;
+    uint32_t T;
+    float s;
+
+    // Journal the clauses changed by training every that many samples
+    uint32_t delta_interval;
+} runner_options_t;
+
+typedef struct {
+    const runner_platform_t* platform;
+    const char* name;
+    runner_options_t opt;
+
+    int rows, cols;
+    uint32_t n_train;
+    uint32_t n_test;
+
+    Tsetlin* model;
+    int32_t* votes;
+    blockio_t test_imgs, test_labels;
+
+    // Per-phase latency over every workload
+    perf_hist_t hist_load, hist_booleanize, hist_evaluate, hist_step;
+} runner_t;
+
+// Where the training samples of an epoch come from
+typedef struct {
+    dataset_t* set;
+    dataset_iter_t iter;
+
+    blockio_t imgs, labels;
+    uint32_t next;
+
+    uint8_t* x;
+} runner_train_t;
+
+static const char* WORKLOADS[] = { "load", "sample", "inference", "train" };
+#define N_WORKLOAD (sizeof(WORKLOADS) / sizeof(WORKLOADS[0]))
+
+static const char* default_name(void) {
+#if defined(ESP_PLATFORM)
+    return CONFIG_IDF_TARGET;
+#elif defined(__ZEPHYR__)
+    return CONFIG_BOARD;
+#elif defined(__RTTHREAD__)
+    return "rt-thread";
+#else
+    return RUNNER_OS "-" RUNNER_ARCH;
+#endif
+}
+
+static const char* path(const runner_t* r, const char* file, char* buf) {
+    snprintf(buf, RUNNER_PATH_MAX, "%s/%s", r->platform->root, file);
+    return buf;
+}
+
+static void print_progress(const char* label, int percent) {
+    const int bar_width = 40;
+    int filled = percent * bar_width / 100;
+
+    printf("%s [", label);
+    for (int i = 0; i < bar_width; i++) {
+        if (i < filled) printf("=");
+        else printf(" ");
+    }
+    printf("] %3d%%\r", percent);  // stay on same line
+    fflush(stdout);
+}
+
+static void print_result(const runner_t* r, const char* workload, const perf_hist_t* h, double accuracy) {
+    double per_s = h->sum ? (double)h->n / ((double)h->sum * 1e-9) : 0;
+
+    printf("{\"platform\":\"%s\",\"workload\":\"%s\",\"n\":%llu,\"min_ns\":%llu,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"per_s\":%.3f",
+           r->name, workload, (unsigned long long)h->n, (unsigned long long)(h->n ? h->min : 0),
+           (unsigned long long)perf_hist_percentile(h, 0.50), (unsigned long long)perf_hist_percentile(h, 0.90),
+           (unsigned long long)perf_hist_percentile(h, 0.99), per_s);
+    if (accuracy >= 0)
+        printf(",\"accuracy\":%.2f", accuracy);
+    printf("}\n");
+    fflush(stdout);
+}
+
+static int open_sets(runner_t* r) {
+    char buf[RUNNER_PATH_MAX];
+
+    // Get training set info
+    r->n_train = mnist_image_info(path(r, "train-images-idx3-ubyte", buf), &r->rows, &r->cols);
+    LOGI(TAG, "MNIST training set: %lu images of size %dx%d", (unsigned long)r->n_train, r->rows, r->cols);
+
+    uint32_t n_label = mnist_label_info(path(r, "train-labels-idx1-ubyte", buf));
+    if (r->n_train != n_label) {
+        LOGE(TAG, "Image count and label count do not match!");
+        return -1;
+    }
+
+    // Get test set info
+    r->n_test = mnist_image_info(path(r, "t10k-images-idx3-ubyte", buf), &r->rows, &r->cols);
+    LOGI(TAG, "MNIST test set: %lu images of size %dx%d", (unsigned long)r->n_test, r->rows, r->cols);
+
+    n_label = mnist_label_info(path(r, "t10k-labels-idx1-ubyte", buf));
+    if (r->n_test != n_label) {
+        LOGE(TAG, "Image count and label count do not match!");
+        return -1;
+    }
+
+    if (r->n_train == 0 || r->n_test == 0) {
+        LOGE(TAG, "No images found in dataset!");
+        return -1;
+    }
+
+    // Stream the test set through block-aligned reads: one FAT transaction
+    // per 16 KB block instead of one per image and one per label
+    if (blockio_open(&r->test_imgs, path(r, "t10k-images-idx3-ubyte", buf), BLOCKIO_DEFAULT_BLOCK_SIZE) != 0)
+        return -1;
+    if (blockio_open(&r->test_labels, path(r, "t10k-labels-idx1-ubyte", buf), BLOCKIO_DEFAULT_BLOCK_SIZE) != 0) {
+        blockio_close(&r->test_imgs);
+        return -1;
+    }
+
+    const runner_platform_t* p = r->platform;
+    if (p->throttle_latency_us || p->throttle_bytes_per_sec) {
+        blockio_set_throttle(&r->test_imgs, p->throttle_latency_us, p->throttle_bytes_per_sec);
+        blockio_set_throttle(&r->test_labels, p->throttle_latency_us, p->throttle_bytes_per_sec);
+    }
+    return 0;
+}
+
+static Tsetlin* load_model(const runner_t* r) {
+    char buf[RUNNER_PATH_MAX];
+    Tsetlin* model = tsetlin_load(path(r, r->platform->model, buf));
+    if (!model)
+        LOGE(TAG, "Failed to load model %s", buf);
+    return model;
+}
+
+// Adopt a freshly loaded model, checking it fits the images
+static int use_model(runner_t* r, Tsetlin* model) {
+    if (model->n_feature != (uint32_t)(r->rows * r->cols * RUNNER_BITS) || model->n_class == 0) {
+        LOGE(TAG, "Model of %lu features does not fit %dx%d images of %d bits",
+             (unsigned long)model->n_feature, r->rows, r->cols, RUNNER_BITS);
+        tsetlin_free(model);
+        return -1;
+    }
+
+    int32_t* votes = (int32_t*)realloc(r->votes, sizeof(int32_t) * model->n_class);
+    if (!votes) {
+        LOGE(TAG, "Failed to allocate memory for votes");
+        tsetlin_free(model);
+        return -1;
+    }
+
+    tsetlin_free(r->model);
+    r->model = model;
+    r->votes = votes;
+
+    LOGI(TAG, "n_class   = %lu", (unsigned long)model->n_class);
+    LOGI(TAG, "n_feature = %lu", (unsigned long)model->n_feature);
+    LOGI(TAG, "n_clause  = %lu", (unsigned long)model->n_clause);
+    LOGI(TAG, "n_state   = %lu", (unsigned long)model->n_state);
+    LOGI(TAG, "model_type = %u", (unsigned)model->model_type);
+
+    // Heap held by the model and its arena
+    perf_mem_print();
+    return 0;
+}
+
+static int need_model(runner_t* r) {
+    if (r->model)
+        return 0;
+
+    Tsetlin* model = load_model(r);
+    return model ? use_model(r, model) : -1;
+}
+
+static int run_load(runner_t* r) {
+    perf_hist_t hist;
+    perf_hist_reset(&hist);
+
+    Tsetlin* model = NULL;
+    for (uint32_t i = 0; i < r->opt.n_load; i++) {
+        tsetlin_free(model);
+
+        uint64_t start = perf_now_ns();
+        model = load_model(r);
+        uint64_t loaded = perf_now_ns();
+        if (!model)
+            return -1;
+
+        perf_hist_record(&hist, loaded - start);
+        perf_trace_complete("io", "load_model", start, loaded);
+    }
+
+    if (model && use_model(r, model) != 0)
+        return -1;
+
+    print_result(r, "load", &hist, -1);
+    return 0;
+}
+
+// One test image and its label, read with the IDX reader so that a short
+// file fails instead of returning a partial image
+static uint8_t* read_sample(runner_t* r, uint32_t index, uint8_t* out_label) {
+    char buf[RUNNER_PATH_MAX];
+    idx_file_t imgs, labels;
+    if (idx_open(&imgs, path(r, "t10k-images-idx3-ubyte", buf)) != 0)
+        return NULL;
+    if (idx_open(&labels, path(r, "t10k-labels-idx1-ubyte", buf)) != 0) {
+        idx_close(&imgs);
+        return NULL;
+    }
+
+    uint8_t* img = NULL;
+    if (imgs.dtype != IDX_UINT8 || imgs.item_size != (size_t)r->rows * r->cols ||
+        labels.dtype != IDX_UINT8 || labels.item_size != 1) {
+        LOGE(TAG, "Unexpected layout of the test set");
+    } else if (!(img = (uint8_t*)malloc(imgs.item_size))) {
+        LOGE(TAG, "Failed to allocate %lu bytes of memory", (unsigned long)imgs.item_size);
+    } else if (idx_read(&imgs, index, 1, img) != 0 || idx_read(&labels, index, 1, out_label) != 0) {
+        LOGE(TAG, "Failed to load test image %lu", (unsigned long)index);
+        free(img);
+        img = NULL;
+    } else if (*out_label >= r->model->n_class) {
+        LOGE(TAG, "Label %d of test image %lu is out of range", *out_label, (unsigned long)index);
+        free(img);
+        img = NULL;
+    }
+
+    idx_close(&imgs);
+    idx_close(&labels);
+    return img;
+}
+
+static int run_sample(runner_t* r) {
+    if (need_model(r) != 0)
+        return -1;
+
+    uint32_t img_index = fast_rand() % r->n_test;
+    uint8_t label = 0;
+    uint8_t* img = read_sample(r, img_index, &label);
+    if (!img)
+        return -1;
+
+    LOGI(TAG, "Evaluating model on test image %lu (label %d)", (unsigned long)img_index, label);
+    mnist_print_img_size(img, r->rows, r->cols);
+
+    uint64_t start = perf_now_ns();
+    uint8_t* bool_img = mnist_booleanize_img_n_bit(img, r->rows, r->cols, RUNNER_BITS);
+    free(img);
+    if (!bool_img)
+        return -1;
+
+    uint8_t predicted_class = 0;
+    tsetlin_evaluate(r->model, bool_img, r->votes, &predicted_class);
+    uint64_t evaluated = perf_now_ns();
+    free(bool_img);
+
+    LOGI(TAG, "Predicted class: %d with %ld votes", predicted_class, (long)r->votes[predicted_class]);
+    for (uint32_t c = 0; c < r->model->n_class; c++)
+        LOGI(TAG, "Class %lu: %ld votes", (unsigned long)c, (long)r->votes[c]);
+
+    perf_hist_t hist;
+    perf_hist_reset(&hist);
+    perf_hist_record(&hist, evaluated - start);
+    print_result(r, "sample", &hist, predicted_class == label ? 100 : 0);
+    return 0;
+}
+
+// One pass over the test set, streamed from storage. Returns the number
+// of images classified correctly; hist gets the whole time of each.
+static uint32_t test_pass(runner_t* r, perf_hist_t* hist) {
+    uint32_t correct = 0;
+    perf_trace_scope_t test = perf_trace_begin("eval", "test");
+
+    // Skip the headers
+    blockio_seek(&r->test_imgs, 16);
+    blockio_seek(&r->test_labels, 8);
+
+    for (uint32_t i = 0; i < r->n_test; i++) {
+        uint64_t start_load = perf_now_ns();
+
+        uint8_t* img = mnist_load_next_image_block(&r->test_imgs, r->rows, r->cols);
+        if (!img) {
+            LOGE(TAG, "Failed to load test image %lu", (unsigned long)i);
+            continue;
+        }
+
+        int16_t label = mnist_load_next_label_block(&r->test_labels);
+        if (label < 0) {
+            LOGE(TAG, "Failed to load test label %lu", (unsigned long)i);
+            free(img);
+            continue;
+        }
+
+        uint64_t start = perf_now_ns();
+        perf_hist_record(&r->hist_load, start - start_load);
+        perf_trace_complete("data", "load", start_load, start);
+
+        uint8_t* bool_img = mnist_booleanize_img_n_bit(img, r->rows, r->cols, RUNNER_BITS);
+        free(img);
+        if (!bool_img)
+            continue;
+
+        uint64_t booleanized = perf_now_ns();
+        perf_hist_record(&r->hist_booleanize, booleanized - start);
+        perf_trace_complete("data", "booleanize", start, booleanized);
+
+        uint8_t predicted_class = 0;
+        tsetlin_evaluate(r->model, bool_img, r->votes, &predicted_class);
+        uint64_t evaluated = perf_now_ns();
+        perf_hist_record(&r->hist_evaluate, evaluated - booleanized);
+        perf_trace_complete("eval", "evaluate", booleanized, evaluated);
+        if (hist)
+            perf_hist_record(hist, evaluated - start_load);
+
+        if (predicted_class == label)
+            correct++;
+
+        free(bool_img);
+
+        // Print progress every 1000 images
+        if ((i + 1) % 1000 == 0) {
+            char message[32];
+            snprintf(message, sizeof(message), "Testing %lu/%lu", (unsigned long)(i + 1), (unsigned long)r->n_test);
+            print_progress(message, (int)((uint64_t)(i + 1) * 100 / r->n_test));
+        }
+    }
+    printf("\n");
+
+    perf_trace_end(&test);
+    return correct;
+}
+
+static int run_inference(runner_t* r) {
+    if (need_model(r) != 0)
+        return -1;
+
+    perf_hist_t hist;
+    perf_hist_reset(&hist);
+    perf_hist_reset(&r->hist_load);
+    perf_hist_reset(&r->hist_booleanize);
+    perf_hist_reset(&r->hist_evaluate);
+
+    uint32_t reads = r->test_imgs.n_reads + r->test_labels.n_reads;
+    uint64_t bytes = r->test_imgs.n_bytes + r->test_labels.n_bytes;
+
+    uint32_t correct = test_pass(r, &hist);
+    double accuracy = (double)correct / r->n_test * 100;
+
+    perf_hist_print(&r->hist_load, "load");
+    perf_hist_print(&r->hist_booleanize, "booleanize");
+    perf_hist_print(&r->hist_evaluate, "evaluate");
+
+    LOGI(TAG, "Accuracy on test set (%lu): %.2f%%", (unsigned long)r->n_test, accuracy);
+    LOGI(TAG, "Test set reads: %lu blocks, %llu bytes",
+         (unsigned long)(r->test_imgs.n_reads + r->test_labels.n_reads - reads),
+         (unsigned long long)(r->test_imgs.n_bytes + r->test_labels.n_bytes - bytes));
+
+    print_result(r, "inference", &hist, accuracy);
+    return 0;
+}
+
+static int train_open(runner_t* r, runner_train_t* src) {
+    char buf[RUNNER_PATH_MAX];
+    memset(src, 0, sizeof(runner_train_t));
+
+    src->x = (uint8_t*)malloc(r->model->n_feature);
+    if (!src->x) {
+        LOGE(TAG, "Failed to allocate memory for training sample");
+        return -1;
+    }
+
+    if (!r->platform->train_resident) {
+        if (blockio_open(&src->imgs, path(r, "train-images-idx3-ubyte", buf), BLOCKIO_DEFAULT_BLOCK_SIZE) != 0)
+            return -1;
+        if (blockio_open(&src->labels, path(r, "train-labels-idx1-ubyte", buf), BLOCKIO_DEFAULT_BLOCK_SIZE) != 0) {
+            blockio_close(&src->imgs);
+            return -1;
+        }
+        return 0;
+    }
+
+    // Booleanize the training set once and keep it resident, so every epoch
+    // can visit it in a fresh random order without seeking the files
+    src->set = dataset_map(path(r, "train-bool-8.lds", buf));
+    if (!src->set) {
+        char labels[RUNNER_PATH_MAX];
+        src->set = mnist_load_dataset(path(r, "train-images-idx3-ubyte", buf),
+                                      path(r, "train-labels-idx1-ubyte", labels), RUNNER_BITS);
+        if (!src->set) {
+            LOGE(TAG, "Failed to load training set");
+            return -1;
+        }
+        dataset_save(src->set, path(r, "train-bool-8.lds", buf));
+    }
+
+    if (src->set->n_feature != r->model->n_feature ||
+        dataset_iter_init(&src->iter, src->set, 42, 0, 1) != 0) {
+        LOGE(TAG, "Failed to create training set iterator");
+        dataset_free(src->set);
+        src->set = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void train_close(runner_train_t* src) {
+    if (src->set) {
+        dataset_iter_free(&src->iter);
+        dataset_free(src->set);
+    } else if (src->x) {
+        blockio_close(&src->imgs);
+        blockio_close(&src->labels);
+    }
+    free(src->x);
+}
+
+static void train_epoch(runner_train_t* src, uint32_t epoch) {
+    if (src->set) {
+        dataset_iter_epoch(&src->iter, epoch);
+        return;
+    }
+
+    // Skip the headers
+    blockio_seek(&src->imgs, 16);
+    blockio_seek(&src->labels, 8);
+    src->next = 0;
+}
+
+// tsetlin_step() indexes the model's clauses with the label, as int8_t
+static int train_label_valid(const runner_t* r, uint16_t y) {
+    return y < r->model->n_class && y <= INT8_MAX;
+}
+
+// Next training sample into src->x, 0 at the end of the epoch
+static int train_next(runner_t* r, runner_train_t* src, uint16_t* y) {
+    if (src->set) {
+        while (dataset_iter_next(&src->iter, src->x, y)) {
+            if (train_label_valid(r, *y))
+                return 1;
+            LOGE(TAG, "Skipped train label %u out of range", (unsigned)*y);
+        }
+        return 0;
+    }
+
+    for (; src->next < r->n_train; src->next++) {
+        uint64_t start_load = perf_now_ns();
+
+        uint8_t* img = mnist_load_next_image_block(&src->imgs, r->rows, r->cols);
+        if (!img) {
+            LOGE(TAG, "Failed to load train image %lu", (unsigned long)src->next);
+            continue;
+        }
+
+        int16_t label = mnist_load_next_label_block(&src->labels);
+        if (label < 0) {
+            LOGE(TAG, "Failed to load train label %lu", (unsigned long)src->next);
+            free(img);
+            continue;
+        }
+        *y = (uint16_t)label;
+        if (!train_label_valid(r, *y)) {
+            LOGE(TAG, "Skipped train label %u out of range", (unsigned)*y);
+            free(img);
+            continue;
+        }
+
+        uint64_t start = perf_now_ns();
+        perf_hist_record(&r->hist_load, start - start_load);
+        perf_trace_complete("data", "load", start_load, start);
+
+        uint8_t* bool_img = mnist_booleanize_img_n_bit(img, r->rows, r->cols, RUNNER_BITS);
+        free(img);
+        if (!bool_img)
+            continue;
+        memcpy(src->x, bool_img, r->model->n_feature);
+        free(bool_img);
+
+        uint64_t booleanized = perf_now_ns();
+        perf_hist_record(&r->hist_booleanize, booleanized - start);
+        perf_trace_complete("data", "booleanize", start, booleanized);
+
+        src->next++;
+        return 1;
+    }
+    return 0;
+}
+
+static int run_train(runner_t* r) {
+    char buf[RUNNER_PATH_MAX];
+    if (need_model(r) != 0)
+        return -1;
+
+    runner_train_t src;
+    if (train_open(r, &src) != 0) {
+        train_close(&src);
+        return -1;
+    }
+
+    // Each epoch is checkpointed during the next one, a few clauses per
+    // training step, so saving never stalls training
+    tsetlin_checkpoint_t ckpt = { 0 };
+
+    // Between checkpoints, the clauses changed by training are appended to
+    // a journal every delta_interval samples. Replaying it over the model
+    // loaded above (lime-tm-replay) recovers training up to the last append.
+    uint8_t* dirty = tsetlin_dirty_create(r->model);
+    uint32_t delta_seq = 0;
+    uint32_t n_trained = 0;
+    remove(path(r, "tsetlin_model.lmd", buf));
+
+    perf_hist_t hist;
+    perf_hist_reset(&hist);
+    double accuracy = 0;
+
+    // Peaks from here on belong to training
+    perf_mem_reset_peak();
+
+    for (uint32_t i = 0; i < r->opt.n_epoch; i++) {
+        perf_trace_scope_t epoch = perf_trace_begin("train", "epoch");
+        perf_trace_scope_t train = perf_trace_begin("train", "train");
+
+        train_epoch(&src, i);
+
+        uint32_t j = 0;
+        uint16_t y_target;
+        while (train_next(r, &src, &y_target)) {
+            uint64_t start = perf_now_ns();
+            tsetlin_step_tracked(r->model, src.x, (int8_t)y_target, r->opt.T, r->opt.s, dirty);
+            uint64_t stepped = perf_now_ns();
+            perf_hist_record(&hist, stepped - start);
+            perf_hist_record(&r->hist_step, stepped - start);
+            perf_trace_complete("train", "step", start, stepped);
+
+            if (dirty && r->opt.delta_interval && ++n_trained % r->opt.delta_interval == 0) {
+                perf_trace_scope_t delta = perf_trace_begin("io", "delta");
+                // dirty stays set on failure, the next append retries it
+                if (tsetlin_delta_append(r->model, dirty, delta_seq++, path(r, "tsetlin_model.lmd", buf)) < 0)
+                    LOGE(TAG, "Failed to append to the delta journal");
+                perf_trace_end(&delta);
+            }
+            if (ckpt.active && tsetlin_checkpoint_step(&ckpt, 16) < 0) {
+                LOGE(TAG, "Failed to write the checkpoint");
+                tsetlin_checkpoint_abort(&ckpt);
+            }
+            j++;
+
+            // Print progress every 1000 images
+            if (j % 1000 == 0) {
+                char message[64];
+                snprintf(message, sizeof(message), "Epoch %lu: Processed %lu/%lu",
+                         (unsigned long)(i + 1), (unsigned long)j, (unsigned long)r->n_train);
+                print_progress(message, (int)((uint64_t)j * 100 / r->n_train));
+            }
+        }
+        printf("\n");
+
+        perf_trace_end(&train);
+
+        // Evaluate on test set after each epoch
+        uint32_t correct = test_pass(r, NULL);
+        accuracy = (double)correct / r->n_test * 100;
+        perf_trace_counter("accuracy", accuracy);
+        LOGI(TAG, "Testing Accuracy after epoch %lu: %.2f%%", (unsigned long)(i + 1), accuracy);
+
+        // Finish the previous checkpoint, then start one for this epoch
+        if (ckpt.active) {
+            perf_trace_scope_t checkpoint = perf_trace_begin("io", "checkpoint");
+            if (tsetlin_checkpoint_step(&ckpt, SIZE_MAX) < 0) {
+                LOGE(TAG, "Failed to write the checkpoint");
+                tsetlin_checkpoint_abort(&ckpt);
+            }
+            perf_trace_end(&checkpoint);
+        }
+        if (i + 1 < r->opt.n_epoch &&
+            tsetlin_checkpoint_begin(&ckpt, r->model, path(r, "tsetlin_model_ckpt.cpb", buf)) < 0) {
+            LOGE(TAG, "Failed to start the checkpoint");
+            tsetlin_checkpoint_abort(&ckpt);
+        }
+
+        perf_trace_end(&epoch);
+    }
+
+    train_close(&src);
+    free(dirty);
+
+    // Heap use and training peaks per category
+    perf_mem_print();
+
+    if (tsetlin_save(r->model, path(r, "tsetlin_model_trained.cpb", buf)) != 0)
+        LOGE(TAG, "Failed to save trained model");
+
+    print_result(r, "train", &hist, r->opt.n_epoch ? accuracy : -1);
+    return 0;
+}
+
+static int run(runner_t* r, const char* workload) {
+    if (strcmp(workload, "load") == 0)
+        return run_load(r);
+    if (strcmp(workload, "sample") == 0)
+        return run_sample(r);
+    if (strcmp(workload, "inference") == 0)
+        return run_inference(r);
+    return run_train(r);
+}
+
+static int known(const char* workload) {
+    for (size_t i = 0; i < N_WORKLOAD; i++) {
+        if (strcmp(workload, WORKLOADS[i]) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+int runner_main(const runner_platform_t* platform, int argc, char** argv) {
+    runner_t r;
+    memset(&r, 0, sizeof(runner_t));
+    r.platform = platform;
+    r.name = platform->name ? platform->name : default_name();
+    r.opt.n_epoch = 10;
+    r.opt.n_load = 3;
+    r.opt.T = 10;
+    r.opt.s = 7.5f;
+    r.opt.delta_interval = 5000;
+
+    // Options first, workload names after
+    int arg = 0;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--epochs") == 0 && arg + 1 < argc) {
+            r.opt.n_epoch = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else if (strcmp(argv[arg], "--loads") == 0 && arg + 1 < argc) {
+            r.opt.n_load = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else {
+            break;
+        }
+    }
+    for (int i = arg; i < argc; i++) {
+        if (!known(argv[i])) {
+            LOGE(TAG, "Usage: [--epochs N] [--loads N] [load] [sample] [inference] [train]");
+            return -1;
+        }
+    }
+
+    perf_hist_reset(&r.hist_load);
+    perf_hist_reset(&r.hist_booleanize);
+    perf_hist_reset(&r.hist_evaluate);
+    perf_hist_reset(&r.hist_step);
+
+    if (open_sets(&r) != 0)
+        return -1;
+
+    int ret = 0;
+    if (arg == argc) {
+        for (size_t i = 0; i < N_WORKLOAD && ret == 0; i++)
+            ret = run(&r, WORKLOADS[i]);
+    } else {
+        for (int i = arg; i < argc && ret == 0; i++)
+            ret = run(&r, argv[i]);
+    }
+
+    // Latency over all workloads, test passes included
+    perf_hist_print(&r.hist_load, "load");
+    perf_hist_print(&r.hist_booleanize, "booleanize");
+    perf_hist_print(&r.hist_evaluate, "evaluate");
+    perf_hist_print(&r.hist_step, "step");
+
+    // Hot-path counters, nothing unless built with LIME_TM_COUNTERS
+    PERF_COUNTERS_REPORT();
+
+    tsetlin_free(r.model);
+    free(r.votes);
+    blockio_close(&r.test_imgs);
+    blockio_close(&r.test_labels);
+
+    return ret;
+}
@@ -0,0 +1,55 @@
+#ifndef _RUNNER_H_
+#define _RUNNER_H_
+
+#include <stdint.h>
+
+// MNIST benchmark shared by every port. A port mounts its storage, fills
+// in a runner_platform_t and calls runner_main(); reading the sets,
+// timing, training and reporting are the same everywhere. Ticks and
+// logging come from perf/timer.h and utils/logging.h, files are read
+// through stdio.
+//
+// Workloads, run in the order they are named (all of them by default):
+//
+//   load       tsetlin_load() of the model, repeated --loads times
+//   sample     one random test image, printed and evaluated
+//   inference  every test image read, booleanized and evaluated
+//   train      --epochs epochs of training, each followed by a test pass
+//
+// Each workload ends with one line of JSON on stdout, in the same form on
+// every platform:
+//
+//   {"platform":"esp32s3","workload":"inference","n":10000,"min_ns":...,
+//    "p50_ns":...,"p90_ns":...,"p99_ns":...,"per_s":...,"accuracy":...}
+//
+// n counts loads, test images or training steps, the latencies are per
+// item and per_s is items per second of measured time. accuracy is left
+// out where there is none. grep '^{"platform"' collects the lines of a
+// log, so runs on different boards can be compared directly.
+typedef struct {
+    // Reported with every result; NULL for the build target, e.g.
+    // CONFIG_IDF_TARGET, CONFIG_BOARD or linux-x86_64
+    const char* name;
+
+    // Directory holding the MNIST IDX files, the model and everything
+    // written during training
+    const char* root;
+    const char* model;
+
+    // Keep the booleanized training set in memory, cached in root as
+    // train-bool-8.lds, and visit it in a new order every epoch. Without
+    // it the training set is streamed from storage in file order, which
+    // is what boards without room for the bit-packed set (47 MB for MNIST
+    // at 8 bits per pixel) do.
+    uint8_t train_resident;
+
+    // Emulate slow storage for the test set, see blockio_set_throttle()
+    uint32_t throttle_latency_us;
+    uint32_t throttle_bytes_per_sec;
+} runner_platform_t;
+
+// argv holds options and workload names only, no program name:
+// [--epochs N] [--loads N] [workload ...]. Returns 0, or -1 on an error.
+int runner_main(const runner_platform_t* platform, int argc, char** argv);
+
+#endif // _RUNNER_H_
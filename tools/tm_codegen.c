@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <tsetlin.h>
+#include <logging.h>
+
+static const char* TAG = "lime-tm-codegen";
+
+#define VALUES_PER_LINE   16
+#define LITERALS_PER_LINE 8
+
+static int is_identifier(const char* s) {
+    if (!isalpha((unsigned char)s[0]) && s[0] != '_')
+        return 0;
+    for (; *s; s++) {
+        if (!isalnum((unsigned char)*s) && *s != '_')
+            return 0;
+    }
+    return 1;
+}
+
+// Companion header next to out.c: out.h
+static char* header_path(const char* out) {
+    size_t n = strlen(out);
+    if (n > 2 && strcmp(out + n - 2, ".c") == 0)
+        n -= 2;
+
+    char* path = (char*)malloc(n + 3);
+    if (!path)
+        return NULL;
+    memcpy(path, out, n);
+    strcpy(path + n, ".h");
+    return path;
+}
+
+static const char* base_name(const char* path) {
+    const char* s = strrchr(path, '/');
+    const char* b = strrchr(path, '\\');
+    if (b > s)
+        s = b;
+    return s ? s + 1 : path;
+}
+
+static int included(const Tsetlin* model, const ClauseCompressed* clause, size_t k) {
+    return clause->data[k] > model->n_state / 2;
+}
+
+static int write_header(const char* path, const char* name) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    char guard[128];
+    size_t n = 0;
+    guard[n++] = '_';
+    for (const char* s = name; *s && n < sizeof(guard) - 4; s++)
+        guard[n++] = (char)toupper((unsigned char)*s);
+    strcpy(guard + n, "_H_");
+
+    fprintf(f, "// Generated by lime-tm-codegen. Do not edit.\n");
+    fprintf(f, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(f, "#include <tsetlin_static.h>\n\n");
+    fprintf(f, "extern const tsetlin_static_t %s;\n\n", name);
+    fprintf(f, "#endif // %s\n", guard);
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+// Included literals of every clause as position * 2 + negated
+static void write_tables(FILE* f, const Tsetlin* model, const char* name, size_t n_total, uint8_t width) {
+    fprintf(f, "static const uint32_t %s_clause_offset[%lu] = {", name, (unsigned long)(n_total + 1));
+
+    size_t offset = 0;
+    for (size_t i = 0; i <= n_total; i++) {
+        fprintf(f, (i % VALUES_PER_LINE == 0) ? "\n    %lu," : " %lu,", (unsigned long)offset);
+        if (i == n_total)
+            break;
+
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        for (size_t k = 0; k < clause->n_pos_literal + clause->n_neg_literal; k++)
+            offset += included(model, clause, k);
+    }
+    fprintf(f, "\n};\n\n");
+
+    // Keep the array non-empty for models without included literals
+    fprintf(f, "static const uint%d_t %s_literal[%lu] = {", width * 8, name, (unsigned long)(offset ? offset : 1));
+
+    size_t n = 0;
+    for (size_t i = 0; i < n_total; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        for (size_t k = 0; k < clause->n_pos_literal + clause->n_neg_literal; k++) {
+            if (!included(model, clause, k))
+                continue;
+
+            unsigned long l = (unsigned long)clause->position[k] * 2 + (k >= clause->n_pos_literal);
+            fprintf(f, (n++ % VALUES_PER_LINE == 0) ? "\n    %lu," : " %lu,", l);
+        }
+    }
+    if (n == 0)
+        fprintf(f, "\n    0,");
+    fprintf(f, "\n};\n\n");
+}
+
+// One straight-line function per class, each clause an && chain
+static void write_class_functions(FILE* f, const Tsetlin* model, const char* name) {
+    uint32_t n_clause = model->n_clause & ~1u;
+
+    for (uint32_t c = 0; c < model->n_class; c++) {
+        fprintf(f, "static int32_t %s_class_%lu(const uint8_t* x) {\n", name, (unsigned long)c);
+        fprintf(f, "    int32_t votes = 0;\n");
+
+        for (uint32_t j = 0; j < n_clause; j++) {
+            const ClauseCompressed* clause = model->clauses_compressed[c * model->n_clause + j];
+            fprintf(f, "    votes %s= ", (j & 1) ? "-" : "+");
+
+            size_t n = 0;
+            for (size_t k = 0; k < clause->n_pos_literal + clause->n_neg_literal; k++) {
+                if (!included(model, clause, k))
+                    continue;
+
+                if (n > 0)
+                    fprintf(f, (n % LITERALS_PER_LINE == 0) ? "\n        && " : " && ");
+                fprintf(f, "%sx[%lu]", (k >= clause->n_pos_literal) ? "!" : "", (unsigned long)clause->position[k]);
+                n++;
+            }
+
+            // An empty clause always fires
+            fprintf(f, n ? ";\n" : "1;\n");
+        }
+
+        fprintf(f, "    return votes;\n}\n\n");
+    }
+
+    fprintf(f, "static const tsetlin_static_class_fn %s_class_votes[%lu] = {", name, (unsigned long)model->n_class);
+    for (uint32_t c = 0; c < model->n_class; c++)
+        fprintf(f, (c % 4 == 0) ? "\n    %s_class_%lu," : " %s_class_%lu,", name, (unsigned long)c);
+    fprintf(f, "\n};\n\n");
+}
+
+static int generate(const Tsetlin* model, const char* in, const char* out, const char* name, int specialize) {
+    size_t n_total = (size_t)model->n_class * model->n_clause;
+    if (model->n_class == 0 || model->n_clauses_compressed < n_total) {
+        LOGE(TAG, "Model has no compressed clauses");
+        return -1;
+    }
+
+    for (size_t i = 0; i < n_total; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        size_t n = clause->n_pos_literal + clause->n_neg_literal;
+        if (clause->n_position < n || clause->n_data < n) {
+            LOGE(TAG, "Clause %lu has inconsistent literal counts", (unsigned long)i);
+            return -1;
+        }
+        for (size_t k = 0; k < n; k++) {
+            if (clause->position[k] >= model->n_feature) {
+                LOGE(TAG, "Clause %lu has a literal out of range", (unsigned long)i);
+                return -1;
+            }
+        }
+    }
+
+    uint8_t width = ((uint64_t)model->n_feature * 2 <= 65536) ? 2 : 4;
+
+    char* header = header_path(out);
+    if (!header || write_header(header, name) != 0) {
+        free(header);
+        return -1;
+    }
+
+    FILE* f = fopen(out, "w");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", out);
+        free(header);
+        return -1;
+    }
+
+    fprintf(f, "// Generated by lime-tm-codegen from %s. Do not edit.\n", base_name(in));
+    fprintf(f, "#include <stdint.h>\n#include \"%s\"\n\n", base_name(header));
+    free(header);
+
+    // The generic tables are only needed when there are no class functions
+    if (specialize)
+        write_class_functions(f, model, name);
+    else
+        write_tables(f, model, name, n_total, width);
+
+    fprintf(f, "const tsetlin_static_t %s = {\n", name);
+    fprintf(f, "    .n_class = %lu,\n", (unsigned long)model->n_class);
+    fprintf(f, "    .n_feature = %lu,\n", (unsigned long)model->n_feature);
+    fprintf(f, "    .n_clause = %lu,\n", (unsigned long)model->n_clause);
+    fprintf(f, "    .literal_width = %d,\n", width);
+    if (specialize) {
+        fprintf(f, "    .clause_offset = NULL,\n");
+        fprintf(f, "    .literal = NULL,\n");
+        fprintf(f, "    .class_votes = %s_class_votes,\n", name);
+    } else {
+        fprintf(f, "    .clause_offset = %s_clause_offset,\n", name);
+        fprintf(f, "    .literal = %s_literal,\n", name);
+        fprintf(f, "    .class_votes = NULL,\n");
+    }
+    fprintf(f, "};\n");
+
+    return (ferror(f) == 0 && fclose(f) == 0) ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    const char* name = "tsetlin_model";
+    int specialize = 0;
+
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--specialize") == 0) {
+            specialize = 1;
+        } else if (strcmp(argv[arg], "--name") == 0 && arg + 1 < argc) {
+            name = argv[++arg];
+        } else {
+            break;
+        }
+    }
+
+    if (argc - arg != 2 || !is_identifier(name)) {
+        printf("Usage: %s [--specialize] [--name NAME] <in.cpb> <out.c>\n", argv[0]);
+        printf("Writes the model as const tables (tsetlin_static.h) to out.c and\n");
+        printf("declares NAME in out.h. With --specialize every class becomes its\n");
+        printf("own straight-line function instead of tables.\n");
+        return 1;
+    }
+    const char* in = argv[arg];
+    const char* out = argv[arg + 1];
+
+    Tsetlin* model = tsetlin_load(in);
+    if (!model)
+        return 1;
+
+    int ret = generate(model, in, out, name, specialize);
+    tsetlin_free(model);
+
+    if (ret != 0) {
+        LOGE(TAG, "Failed to generate %s", out);
+        return 1;
+    }
+
+    printf("%s -> %s\n", in, out);
+    return 0;
+}
@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <tsetlin_ref.h>
+#include <tsetlin_flat.h>
+#include <tsetlin_lazy.h>
+#include <tsetlin_prune.h>
+#include <tsetlin_profile.h>
+#include <fast_rand.h>
+#include <fast_rand_seed.h>
+#include <logging.h>
+#include <synth.h>
+
+static const char* TAG = "lime-tm-conform";
+
+// Everything a model is checked with, on the stack of check_model()
+typedef struct {
+    const char* tmp_path;
+    uint32_t n_sample;
+    uint32_t n_step;
+
+    uint64_t seed;
+    uint64_t rng;
+    synth_model_config_t cfg;
+
+    uint8_t* x;
+    int32_t* ref_votes;
+    int32_t* votes;
+    uint8_t* ref_dirty;
+    uint8_t* dirty;
+} conform_t;
+
+static uint32_t next_below(uint64_t* state, uint32_t n) {
+    return n ? pcg32_fast_r(state) % n : 0;
+}
+
+static float next_range(uint64_t* state, float lo, float hi) {
+    return lo + (hi - lo) * (float)pcg32_fast_r(state) / (float)FAST_RAND_MAX;
+}
+
+// A random shape, now and then past the 8 and 16-bit state and position
+// widths of the flat format
+static void random_shape(synth_model_config_t* cfg, uint64_t seed, uint64_t* state) {
+    cfg->n_class = 2 + next_below(state, 14);
+    cfg->n_clause = 2 + next_below(state, 40);
+
+    uint32_t tier = next_below(state, 8);
+    cfg->n_feature = (tier == 0) ? 66000 + next_below(state, 4000) : 1 + next_below(state, 400);
+
+    tier = next_below(state, 8);
+    cfg->n_state = (tier == 0) ? 70000 + next_below(state, 30000) :
+                   (tier == 1) ? 256 + next_below(state, 2000) : 2 + next_below(state, 253);
+
+    // A handful of literals per clause, however wide the input
+    float density = next_range(state, 0.02f, 0.3f);
+    float cap = 48.0f / (float)cfg->n_feature;
+    cfg->density = density < cap ? density : cap;
+    cfg->include = next_range(state, 0.1f, 0.9f);
+    cfg->seed = seed;
+}
+
+static void random_input(conform_t* t, const Tsetlin* model) {
+    synth_input(t->x, model->n_feature, next_range(&t->rng, 0.2f, 0.8f), &t->rng);
+    if (next_below(&t->rng, 2))
+        synth_plant(t->x, model, next_below(&t->rng, model->n_class), &t->rng);
+}
+
+static void print_model(const conform_t* t) {
+    const synth_model_config_t* cfg = &t->cfg;
+    printf("model     seed %llu: %lu classes, %lu features, %lu clauses, %lu states\n",
+           (unsigned long long)t->seed, (unsigned long)cfg->n_class, (unsigned long)cfg->n_feature,
+           (unsigned long)cfg->n_clause, (unsigned long)cfg->n_state);
+    printf("repeat    --seed %llu --models 1\n", (unsigned long long)t->seed);
+}
+
+static int diverged_votes(const conform_t* t, const char* path, uint32_t sample, uint32_t n_class,
+                          const int32_t* votes, uint32_t cls, uint8_t ref_class) {
+    for (uint32_t c = 0; votes && c < n_class; c++) {
+        if (votes[c] != t->ref_votes[c]) {
+            printf("DIVERGED  %s, sample %lu: votes[%lu] = %ld, reference %ld\n", path,
+                   (unsigned long)sample, (unsigned long)c, (long)votes[c], (long)t->ref_votes[c]);
+            print_model(t);
+            return 1;
+        }
+    }
+    if (cls != ref_class) {
+        printf("DIVERGED  %s, sample %lu: class %lu, reference %lu\n", path,
+               (unsigned long)sample, (unsigned long)cls, (unsigned long)ref_class);
+        print_model(t);
+        return 1;
+    }
+    return 0;
+}
+
+// Independent copy of a model, through its protobuf image
+static Tsetlin* copy_model(const Tsetlin* model) {
+    size_t size = tsetlin__get_packed_size(model);
+    uint8_t* data = (uint8_t*)malloc(size);
+    if (!data)
+        return NULL;
+
+    tsetlin__pack(model, data);
+    Tsetlin* copy = tsetlin_unpack(data, size);
+    free(data);
+    return copy;
+}
+
+static int check_evaluate(conform_t* t, Tsetlin* model) {
+    if (tsetlin_flat_write(model, t->tmp_path) != 0)
+        return -1;
+
+    tsetlin_flat_t flat;
+    tsetlin_lazy_t lazy;
+    if (tsetlin_flat_open(&flat, t->tmp_path) != 0)
+        return -1;
+    // One slot on every other model, so classes are evicted and paged in
+    if (tsetlin_lazy_open(&lazy, t->tmp_path, (t->seed & 1) ? 1 : (size_t)1 << 20) != 0) {
+        tsetlin_flat_close(&flat);
+        return -1;
+    }
+
+    tsetlin_profile_t profile;
+    Tsetlin* pruned = copy_model(model);
+    tsetlin_prune_stats_t stats;
+    if (!pruned || tsetlin_prune(pruned, model->n_state / 2, &stats) != 0 ||
+        tsetlin_profile_init(&profile, model, 0) != 0) {
+        tsetlin_free(pruned);
+        tsetlin_lazy_close(&lazy);
+        tsetlin_flat_close(&flat);
+        return -1;
+    }
+
+    int ret = 0;
+    for (uint32_t i = 0; i < t->n_sample && ret == 0; i++) {
+        random_input(t, model);
+
+        uint8_t ref_class, cls;
+        uint32_t lazy_class;
+        tsetlin_ref_evaluate(model, t->x, t->ref_votes, &ref_class);
+
+        tsetlin_evaluate(model, t->x, t->votes, &cls);
+        if (diverged_votes(t, "tsetlin_evaluate", i, model->n_class, t->votes, cls, ref_class))
+            ret = 1;
+
+        if (ret == 0) {
+            tsetlin_flat_evaluate(&flat, t->x, t->votes, &cls);
+            if (diverged_votes(t, "tsetlin_flat_evaluate", i, model->n_class, t->votes, cls, ref_class))
+                ret = 1;
+        }
+
+        // Abandoned classes report INT32_MIN here, so only the class counts
+        if (ret == 0) {
+            if (tsetlin_lazy_evaluate(&lazy, t->x, t->votes, &lazy_class) != 0)
+                ret = -1;
+            else if (diverged_votes(t, "tsetlin_lazy_evaluate", i, model->n_class, NULL, lazy_class, ref_class))
+                ret = 1;
+        }
+
+        if (ret == 0) {
+            for (uint32_t c = 0; c < model->n_class && ret == 0; c++)
+                ret = tsetlin_lazy_class_votes(&lazy, c, t->x, INT32_MIN, &t->votes[c]);
+            if (ret == 0 && diverged_votes(t, "tsetlin_lazy_class_votes", i, model->n_class, t->votes, ref_class, ref_class))
+                ret = 1;
+        }
+
+        if (ret == 0) {
+            cls = tsetlin_profile_sample(&profile, model, t->x, 0);
+            if (diverged_votes(t, "tsetlin_profile_sample", i, model->n_class, NULL, cls, ref_class))
+                ret = 1;
+        }
+
+        if (ret == 0) {
+            tsetlin_evaluate(pruned, t->x, t->votes, &cls);
+            if (diverged_votes(t, "tsetlin_prune", i, model->n_class, t->votes, cls, ref_class))
+                ret = 1;
+        }
+    }
+
+    tsetlin_profile_free(&profile);
+    tsetlin_free(pruned);
+    tsetlin_lazy_close(&lazy);
+    tsetlin_flat_close(&flat);
+    return ret;
+}
+
+static int same_states(const conform_t* t, const char* path, uint32_t step, const Tsetlin* ref, const Tsetlin* model) {
+    size_t n_clauses = (size_t)ref->n_class * ref->n_clause;
+    for (size_t i = 0; i < n_clauses; i++) {
+        const ClauseCompressed* a = ref->clauses_compressed[i];
+        const ClauseCompressed* b = model->clauses_compressed[i];
+        size_t n = a->n_pos_literal + a->n_neg_literal;
+
+        if (a->n_pos_literal != b->n_pos_literal || a->n_neg_literal != b->n_neg_literal) {
+            printf("DIVERGED  %s, step %lu: class %lu clause %lu has %lu + %lu literals, reference %lu + %lu\n",
+                   path, (unsigned long)step, (unsigned long)(i / ref->n_clause), (unsigned long)(i % ref->n_clause),
+                   (unsigned long)b->n_pos_literal, (unsigned long)b->n_neg_literal,
+                   (unsigned long)a->n_pos_literal, (unsigned long)a->n_neg_literal);
+            print_model(t);
+            return 0;
+        }
+
+        for (size_t k = 0; k < n; k++) {
+            if (a->position[k] == b->position[k] && a->data[k] == b->data[k])
+                continue;
+
+            printf("DIVERGED  %s, step %lu: class %lu clause %lu literal %lu (%sx%lu) state %lu, reference %lu\n",
+                   path, (unsigned long)step, (unsigned long)(i / ref->n_clause), (unsigned long)(i % ref->n_clause),
+                   (unsigned long)k, k < a->n_pos_literal ? "" : "not ", (unsigned long)a->position[k],
+                   (unsigned long)b->data[k], (unsigned long)a->data[k]);
+            print_model(t);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Both start from copies of model and see the same inputs and fast_rand()
+// stream, one step at a time
+static int check_step(conform_t* t, const Tsetlin* model, int tracked) {
+    const char* path = tracked ? "tsetlin_step_tracked" : "tsetlin_step";
+    Tsetlin* ref = copy_model(model);
+    Tsetlin* opt = copy_model(model);
+    if (!ref || !opt) {
+        tsetlin_free(ref);
+        tsetlin_free(opt);
+        return -1;
+    }
+
+    size_t dirty_size = ((size_t)model->n_class * model->n_clause + 7) / 8;
+    int ret = 0;
+    for (uint32_t i = 0; i < t->n_step && ret == 0; i++) {
+        random_input(t, model);
+        int8_t y = (int8_t)next_below(&t->rng, model->n_class);
+        uint32_t T = 1 + next_below(&t->rng, model->n_clause + 1);
+        float s = next_range(&t->rng, 1.5f, 10.0f);
+        uint64_t stream = ((uint64_t)pcg32_fast_r(&t->rng) << 32) | pcg32_fast_r(&t->rng);
+
+        memset(t->ref_dirty, 0, dirty_size);
+        memset(t->dirty, 0, dirty_size);
+
+        pcg32_seed(stream);
+        tsetlin_ref_step_tracked(ref, t->x, y, T, s, t->ref_dirty);
+
+        pcg32_seed(stream);
+        if (tracked)
+            tsetlin_step_tracked(opt, t->x, y, T, s, t->dirty);
+        else
+            tsetlin_step(opt, t->x, y, T, s);
+
+        if (!same_states(t, path, i, ref, opt)) {
+            ret = 1;
+        } else if (tracked && memcmp(t->ref_dirty, t->dirty, dirty_size) != 0) {
+            printf("DIVERGED  %s, step %lu: dirty clauses differ from the reference\n", path, (unsigned long)i);
+            print_model(t);
+            ret = 1;
+        }
+    }
+
+    tsetlin_free(ref);
+    tsetlin_free(opt);
+    return ret;
+}
+
+static int check_model(conform_t* t) {
+    Tsetlin* model = synth_model(&t->cfg);
+    if (!model)
+        return -1;
+
+    size_t n_clauses = (size_t)model->n_class * model->n_clause;
+    t->x = (uint8_t*)malloc(model->n_feature);
+    t->ref_votes = (int32_t*)malloc(sizeof(int32_t) * model->n_class);
+    t->votes = (int32_t*)malloc(sizeof(int32_t) * model->n_class);
+    t->ref_dirty = (uint8_t*)malloc((n_clauses + 7) / 8);
+    t->dirty = (uint8_t*)malloc((n_clauses + 7) / 8);
+
+    int ret = -1;
+    if (t->x && t->ref_votes && t->votes && t->ref_dirty && t->dirty) {
+        ret = check_evaluate(t, model);
+        if (ret == 0)
+            ret = check_step(t, model, 0);
+        if (ret == 0)
+            ret = check_step(t, model, 1);
+    }
+
+    free(t->x);
+    free(t->ref_votes);
+    free(t->votes);
+    free(t->ref_dirty);
+    free(t->dirty);
+    tsetlin_free(model);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    conform_t t = { 0 };
+    t.tmp_path = "lime-tm-conform.tmf";
+    t.n_sample = 200;
+    t.n_step = 50;
+    uint64_t seed = 1;
+    uint32_t n_model = 100;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--models") == 0 && i + 1 < argc) {
+            n_model = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            t.n_sample = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            t.n_step = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--tmp") == 0 && i + 1 < argc) {
+            t.tmp_path = argv[++i];
+        } else {
+            printf("Usage: %s [--seed N] [--models N] [--samples N] [--steps N] [--tmp file.tmf]\n", argv[0]);
+            printf("Runs random models and inputs through the reference implementation\n");
+            printf("(tsetlin_ref.h) and every other evaluate and training path, and stops\n");
+            printf("at the first divergence. Model i uses seed + i; --tmp is where the\n");
+            printf("flat and lazy paths read their model from.\n");
+            return 1;
+        }
+    }
+
+    int ret = 0;
+    uint32_t i = 0;
+    for (; i < n_model && ret == 0; i++) {
+        t.seed = seed + i;
+        t.rng = t.seed;
+        random_shape(&t.cfg, t.seed, &t.rng);
+        ret = check_model(&t);
+    }
+    remove(t.tmp_path);
+
+    if (ret < 0) {
+        LOGE(TAG, "Failed to check model seed %llu", (unsigned long long)t.seed);
+        return 1;
+    }
+    if (ret > 0)
+        return 2;
+
+    printf("%lu models, %lu samples and %lu steps each: identical to the reference\n",
+           (unsigned long)i, (unsigned long)t.n_sample, (unsigned long)t.n_step);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <tsetlin_flat.h>
+#include <logging.h>
+
+static const char* TAG = "lime-tm-convert";
+
+static int is_flat_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return -1;
+
+    uint32_t magic = 0;
+    size_t n = fread(&magic, sizeof(magic), 1, f);
+    fclose(f);
+
+    return (n == 1 && magic == TSETLIN_FLAT_MAGIC) ? 1 : 0;
+}
+
+static int cpb_to_flat(const char* in, const char* out) {
+    Tsetlin* model = tsetlin_load(in);
+    if (!model)
+        return -1;
+
+    int ret = tsetlin_flat_write(model, out);
+    tsetlin_free(model);
+
+    return ret;
+}
+
+static int flat_to_cpb(const char* in, const char* out) {
+    tsetlin_flat_t flat;
+    if (tsetlin_flat_open(&flat, in) != 0)
+        return -1;
+
+    Tsetlin* model = tsetlin_flat_to_model(&flat);
+    tsetlin_flat_close(&flat);
+
+    if (!model)
+        return -1;
+
+    size_t size = tsetlin__get_packed_size(model);
+    uint8_t* data = (uint8_t*)malloc(size);
+    if (!data) {
+        LOGE(TAG, "Failed to allocate memory");
+        tsetlin_free(model);
+        return -1;
+    }
+    tsetlin__pack(model, data);
+    tsetlin_free(model);
+
+    FILE* f = fopen(out, "wb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", out);
+        free(data);
+        return -1;
+    }
+
+    int ret = (fwrite(data, 1, size, f) == size) ? 0 : -1;
+    ret |= (fclose(f) == 0) ? 0 : -1;
+    free(data);
+
+    return ret;
+}
+
+static int to_compact_cpb(const char* in, const char* out, int flat) {
+    if (!flat) {
+        Tsetlin* model = tsetlin_load(in);
+        if (!model)
+            return -1;
+
+        int ret = tsetlin_save_compact(model, out);
+        tsetlin_free(model);
+        return ret;
+    }
+
+    tsetlin_flat_t f;
+    if (tsetlin_flat_open(&f, in) != 0)
+        return -1;
+
+    Tsetlin* model = tsetlin_flat_to_model(&f);
+    tsetlin_flat_close(&f);
+    if (!model)
+        return -1;
+
+    int ret = tsetlin_save_compact(model, out);
+    tsetlin_free(model);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    int compact = (argc == 4 && strcmp(argv[1], "--compact") == 0);
+    if (argc != 3 && !compact) {
+        printf("Usage: %s [--compact] <input.cpb|input.tmf> <output>\n", argv[0]);
+        printf("The direction is picked from the input: a flat model is converted\n");
+        printf("back to protobuf, anything else is converted to the flat format.\n");
+        printf("With --compact, either input is written as a compact protobuf.\n");
+        return 1;
+    }
+
+    const char* in = argv[argc - 2];
+    const char* out = argv[argc - 1];
+
+    int flat = is_flat_file(in);
+    if (flat < 0) {
+        LOGE(TAG, "Failed to open file %s", in);
+        return 1;
+    }
+
+    int ret;
+    if (compact)
+        ret = to_compact_cpb(in, out, flat);
+    else
+        ret = flat ? flat_to_cpb(in, out) : cpb_to_flat(in, out);
+
+    if (ret != 0) {
+        LOGE(TAG, "Conversion failed");
+        return 1;
+    }
+
+    printf("%s -> %s\n", in, out);
+    return 0;
+}
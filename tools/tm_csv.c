@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dataset.h>
+#include <encoder.h>
+#include <tabular.h>
+#include <logging.h>
+#include <timer.h>
+
+static const char* TAG = "lime-tm-csv";
+
+static void usage(const char* prog) {
+    printf("Usage: %s [options] <in.csv|in.bin> <out.lds> [<out.lte>]\n", prog);
+    printf("Fits a quantile thermometer encoder (dataset/encoder.h) on numeric records\n");
+    printf("in one streaming pass, then encodes them into a dataset cache in a second.\n");
+    printf("The encoder is saved too when a path is given, to encode a test set with\n");
+    printf("the thresholds of the training set use --encoder.\n");
+    printf("  --label N      label column, 'none' for unlabelled records (last column)\n");
+    printf("  --bits N       literals per feature (8)\n");
+    printf("  --bins N       sketch bins per feature while fitting (256)\n");
+    printf("  --encoder E    encode with a saved encoder instead of fitting one\n");
+    printf("  --delim C      CSV field separator (,)\n");
+    printf("  --header       skip the first CSV line\n");
+    printf("  --binary T,..  fixed-width records, one of u8 i8 i16 i32 f32 f64 per column\n");
+    printf("  --big-endian   binary fields are big-endian\n");
+}
+
+// "u8,i16,f32" -> IDX dtype codes, returns the number of columns or 0
+static uint32_t parse_types(const char* spec, uint8_t** out_types) {
+    static const struct { const char* name; uint8_t code; } names[] = {
+        { "u8", IDX_UINT8 }, { "i8", IDX_INT8 }, { "i16", IDX_INT16 },
+        { "i32", IDX_INT32 }, { "f32", IDX_FLOAT32 }, { "f64", IDX_FLOAT64 },
+    };
+
+    uint32_t n_col = 1;
+    for (const char* p = spec; *p; p++)
+        n_col += (*p == ',');
+
+    uint8_t* types = (uint8_t*)malloc(n_col);
+    if (!types)
+        return 0;
+
+    const char* p = spec;
+    for (uint32_t c = 0; c < n_col; c++) {
+        size_t len = strcspn(p, ",");
+        uint8_t code = 0;
+        for (size_t k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+            if (strlen(names[k].name) == len && strncmp(p, names[k].name, len) == 0)
+                code = names[k].code;
+        }
+        if (code == 0) {
+            LOGE(TAG, "Unknown field type '%.*s' in column %lu", (int)len, p, (unsigned long)c);
+            free(types);
+            return 0;
+        }
+        types[c] = code;
+        p += len + (p[len] == ',');
+    }
+
+    *out_types = types;
+    return n_col;
+}
+
+int main(int argc, char** argv) {
+    const char* label_arg = NULL;
+    uint32_t n_bits = 8;
+    uint32_t n_bins = 256;
+    const char* encoder_path = NULL;
+    char delim = ',';
+    int header = 0;
+    const char* binary = NULL;
+    int big_endian = 0;
+
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--label") == 0 && arg + 1 < argc) {
+            label_arg = argv[++arg];
+        } else if (strcmp(argv[arg], "--bits") == 0 && arg + 1 < argc) {
+            n_bits = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else if (strcmp(argv[arg], "--bins") == 0 && arg + 1 < argc) {
+            n_bins = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else if (strcmp(argv[arg], "--encoder") == 0 && arg + 1 < argc) {
+            encoder_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--delim") == 0 && arg + 1 < argc) {
+            delim = argv[++arg][0];
+        } else if (strcmp(argv[arg], "--header") == 0) {
+            header = 1;
+        } else if (strcmp(argv[arg], "--binary") == 0 && arg + 1 < argc) {
+            binary = argv[++arg];
+        } else if (strcmp(argv[arg], "--big-endian") == 0) {
+            big_endian = 1;
+        } else {
+            break;
+        }
+    }
+
+    int n_rest = argc - arg;
+    if ((n_rest != 2 && n_rest != 3) || n_bits == 0 || delim == '\0') {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* in_path = argv[arg];
+    const char* out_path = argv[arg + 1];
+    const char* enc_out_path = (n_rest == 3) ? argv[arg + 2] : NULL;
+
+    tabular_reader_t reader;
+    int opened;
+    if (binary) {
+        uint8_t* types = NULL;
+        uint32_t n_col = parse_types(binary, &types);
+        if (n_col == 0)
+            return 1;
+        opened = tabular_open_binary(&reader, in_path, types, n_col, big_endian, TABULAR_DEFAULT_BLOCK_SIZE);
+        free(types);
+    } else {
+        opened = tabular_open_csv(&reader, in_path, delim, 0, header, TABULAR_DEFAULT_BLOCK_SIZE);
+    }
+    if (opened != 0) {
+        LOGE(TAG, "Failed to open %s", in_path);
+        return 1;
+    }
+
+    uint32_t label_col = reader.n_col - 1;
+    if (label_arg && strcmp(label_arg, "none") == 0)
+        label_col = TABULAR_NO_LABEL;
+    else if (label_arg)
+        label_col = (uint32_t)strtoul(label_arg, NULL, 10);
+
+    if (label_col != TABULAR_NO_LABEL && label_col >= reader.n_col) {
+        LOGE(TAG, "Label column %lu, records have %lu columns", (unsigned long)label_col, (unsigned long)reader.n_col);
+        tabular_close(&reader);
+        return 1;
+    }
+    uint32_t n_feature = (label_col == TABULAR_NO_LABEL) ? reader.n_col : reader.n_col - 1;
+
+    uint64_t start = perf_now_ns();
+    encoder_t* enc = NULL;
+    if (encoder_path) {
+        enc = encoder_load(encoder_path);
+        if (!enc)
+            LOGE(TAG, "Failed to load %s", encoder_path);
+    } else {
+        enc = encoder_create(n_feature, n_bits, n_bins);
+        if (enc && (tabular_fit_encoder(&reader, enc, label_col) <= 0 || encoder_fit_end(enc) != 0)) {
+            LOGE(TAG, "Failed to fit the encoder on %s", in_path);
+            encoder_free(enc);
+            enc = NULL;
+        }
+    }
+    if (!enc) {
+        tabular_close(&reader);
+        return 1;
+    }
+    uint64_t fitted = perf_now_ns();
+
+    dataset_t* ds = tabular_load_dataset(&reader, enc, label_col);
+    uint64_t encoded = perf_now_ns();
+
+    int ret = ds ? dataset_save(ds, out_path) : -1;
+    if (ret == 0 && enc_out_path && !encoder_path) {
+        ret = encoder_save(enc, enc_out_path);
+        if (ret != 0)
+            LOGE(TAG, "Failed to save %s", enc_out_path);
+    }
+
+    if (ret == 0) {
+        double fit_s = (double)(fitted - start) / 1e9;
+        double encode_s = (double)(encoded - fitted) / 1e9;
+        printf("records   %lu x %lu columns\n", (unsigned long)ds->n_sample, (unsigned long)reader.n_col);
+        printf("literals  %lu features x %lu bits = %lu\n", (unsigned long)enc->n_feature, (unsigned long)enc->n_bits, (unsigned long)ds->n_feature);
+        if (encoder_path)
+            printf("encoder   %s\n", encoder_path);
+        else
+            printf("fit       %.3f s\n", fit_s);
+        printf("encode    %.3f s, %.0f records/s\n", encode_s, encode_s > 0 ? ds->n_sample / encode_s : 0.0);
+        printf("dataset   %s\n", out_path);
+    }
+
+    dataset_free(ds);
+    encoder_free(enc);
+    tabular_close(&reader);
+    return ret == 0 ? 0 : 1;
+}
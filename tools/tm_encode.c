@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <mnist.h>
+#include <encoder.h>
+#include <logging.h>
+
+static const char* TAG = "lime-tm-encode";
+
+typedef struct {
+    double set;         // share of literals set over the whole set
+    uint32_t n_varying; // literals that are 0 for some samples, 1 for others
+    double accuracy;    // of the model, if one is given and matches
+} literal_stats_t;
+
+static int literal_stats(const dataset_t* ds, Tsetlin* model, literal_stats_t* out) {
+    uint32_t n = ds->n_feature;
+    uint8_t* x = (uint8_t*)malloc(n);
+    uint8_t* ever = (uint8_t*)calloc(n, 1);   // bit 0: seen 0, bit 1: seen 1
+    int32_t* votes = model ? (int32_t*)malloc(sizeof(int32_t) * model->n_class) : NULL;
+    if (!x || !ever || (model && !votes)) {
+        LOGE(TAG, "Failed to allocate memory");
+        free(x); free(ever); free(votes);
+        return -1;
+    }
+
+    uint64_t n_set = 0;
+    uint32_t correct = 0;
+    for (uint32_t i = 0; i < ds->n_sample; i++) {
+        dataset_get(ds, i, x);
+        for (uint32_t k = 0; k < n; k++) {
+            n_set += x[k];
+            ever[k] |= (uint8_t)(1 << x[k]);
+        }
+
+        if (model) {
+            uint8_t predicted;
+            tsetlin_evaluate(model, x, votes, &predicted);
+            correct += (predicted == ds->y[i]);
+        }
+    }
+
+    out->n_varying = 0;
+    for (uint32_t k = 0; k < n; k++)
+        out->n_varying += (ever[k] == 3);
+    out->set = ds->n_sample ? (double)n_set / ((double)ds->n_sample * n) * 100 : 0;
+    out->accuracy = (model && ds->n_sample) ? (double)correct / ds->n_sample * 100 : 0;
+
+    free(x);
+    free(ever);
+    free(votes);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t n_bits = 8;
+    const char* model_path = NULL;
+
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--bits") == 0 && arg + 1 < argc) {
+            n_bits = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else if (strcmp(argv[arg], "--model") == 0 && arg + 1 < argc) {
+            model_path = argv[++arg];
+        } else {
+            break;
+        }
+    }
+
+    int n_rest = argc - arg;
+    if ((n_rest != 2 && n_rest != 4 && n_rest != 5) || n_bits == 0 || n_bits > 8) {
+        printf("Usage: %s [--bits N] [--model M.cpb] <train-images> <out.lte> [<images> <labels> [<out.lds>]]\n", argv[0]);
+        printf("Fits a quantile thermometer encoder (dataset/encoder.h) of N bits per\n");
+        printf("pixel (8, at most 8) on an IDX image set and saves it. With an image/label\n");
+        printf("pair the saved encoder is loaded back, the pair is encoded, optionally\n");
+        printf("into a dataset cache, and compared with the fixed Gaussian booleanizer of\n");
+        printf("the same width: literals set, literals that vary at all, and the accuracy\n");
+        printf("of a model with matching n_feature.\n");
+        return 1;
+    }
+    const char* train_path = argv[arg];
+    const char* enc_path = argv[arg + 1];
+
+    encoder_t* enc = mnist_fit_encoder(train_path, n_bits);
+    if (!enc) {
+        LOGE(TAG, "Failed to fit the encoder on %s", train_path);
+        return 1;
+    }
+    if (encoder_save(enc, enc_path) != 0) {
+        LOGE(TAG, "Failed to save %s", enc_path);
+        encoder_free(enc);
+        return 1;
+    }
+    printf("encoder   %lu features x %lu bits -> %s\n", (unsigned long)enc->n_feature, (unsigned long)enc->n_bits, enc_path);
+    encoder_free(enc);
+
+    if (n_rest == 2)
+        return 0;
+
+    const char* img_path = argv[arg + 2];
+    const char* label_path = argv[arg + 3];
+    const char* out_path = (n_rest == 5) ? argv[arg + 4] : NULL;
+
+    // Encode with what was written, so the file format is covered too
+    enc = encoder_load(enc_path);
+    if (!enc) {
+        LOGE(TAG, "Failed to load %s", enc_path);
+        return 1;
+    }
+
+    dataset_t* encoded = mnist_load_dataset_encoded(img_path, label_path, enc);
+    dataset_t* gaussian = mnist_load_dataset(img_path, label_path, (int)n_bits);
+    encoder_free(enc);
+    if (!encoded || !gaussian) {
+        LOGE(TAG, "Failed to load %s and %s", img_path, label_path);
+        dataset_free(encoded);
+        dataset_free(gaussian);
+        return 1;
+    }
+
+    int ret = 0;
+    if (out_path) {
+        ret = dataset_save(encoded, out_path);
+        if (ret == 0)
+            printf("dataset   %lu samples -> %s\n", (unsigned long)encoded->n_sample, out_path);
+    }
+
+    Tsetlin* model = model_path ? tsetlin_load(model_path) : NULL;
+    if (model_path && !model)
+        ret = -1;
+    if (model && model->n_feature != encoded->n_feature) {
+        LOGW(TAG, "%s has %lu features, the images encode to %lu; accuracy skipped",
+             model_path, (unsigned long)model->n_feature, (unsigned long)encoded->n_feature);
+        tsetlin_free(model);
+        model = NULL;
+    }
+
+    literal_stats_t s_gaussian, s_encoded;
+    if (ret == 0 && (literal_stats(gaussian, model, &s_gaussian) != 0 || literal_stats(encoded, model, &s_encoded) != 0))
+        ret = -1;
+
+    if (ret == 0) {
+        printf("literals  %lu per image\n", (unsigned long)encoded->n_feature);
+        printf("set       gaussian %.2f%%, encoder %.2f%%\n", s_gaussian.set, s_encoded.set);
+        printf("varying   gaussian %lu, encoder %lu\n", (unsigned long)s_gaussian.n_varying, (unsigned long)s_encoded.n_varying);
+        if (model)
+            printf("accuracy  gaussian %.2f%%, encoder %.2f%% (%s)\n", s_gaussian.accuracy, s_encoded.accuracy, model_path);
+    }
+
+    tsetlin_free(model);
+    dataset_free(encoded);
+    dataset_free(gaussian);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <dataset.h>
+#include <logging.h>
+
+#include <synth.h>
+
+static const char* TAG = "lime-tm-gen";
+
+// Labels are uint16_t in the dataset format
+#define MAX_LABEL_CLASS ((uint32_t)DATASET_MAX_LABEL + 1)
+
+static void usage(const char* prog) {
+    printf("Usage: %s [options] <out.cpb> [<out.lds>]\n", prog);
+    printf("Writes a synthetic model and, optionally, a dataset labelled with the\n");
+    printf("model's own predictions, so any correct loader scores 100%%. Sample i\n");
+    printf("is random input with one positive clause of class i %% n_class made to fire.\n");
+    printf("Dataset labels are uint16_t, so a dataset needs n_class <= %lu.\n", (unsigned long)MAX_LABEL_CLASS);
+    printf("  --classes N    n_class (10)\n");
+    printf("  --features N   n_feature (6272)\n");
+    printf("  --clauses N    n_clause per class (200)\n");
+    printf("  --states N     n_state (100)\n");
+    printf("  --density F    literals stored per clause and polarity, as a fraction of n_feature (0.01)\n");
+    printf("  --include F    fraction of stored literals that are included (0.5)\n");
+    printf("  --sparsity F   fraction of input features set (0.5)\n");
+    printf("  --samples N    dataset size (1000)\n");
+    printf("  --seed N       model and input seed (1)\n");
+    printf("  --compact      write the compact model encoding\n");
+}
+
+// Highest vote, lowest class on ties, as tsetlin_evaluate() but past 256 classes
+static uint32_t predict(const int32_t* votes, uint32_t n_class) {
+    uint32_t best = 0;
+    for (uint32_t c = 1; c < n_class; c++) {
+        if (votes[c] > votes[best])
+            best = c;
+    }
+    return best;
+}
+
+static int write_dataset(Tsetlin* model, const char* path, uint32_t n_sample, float sparsity, uint64_t seed) {
+    dataset_t* ds = dataset_create(n_sample, model->n_feature);
+    uint8_t* x = (uint8_t*)malloc(model->n_feature);
+    int32_t* votes = (int32_t*)malloc(sizeof(int32_t) * model->n_class);
+    uint32_t* count = (uint32_t*)calloc(model->n_class, sizeof(uint32_t));
+    if (!ds || !x || !votes || !count) {
+        LOGE(TAG, "Failed to allocate memory");
+        dataset_free(ds);
+        free(x); free(votes); free(count);
+        return -1;
+    }
+
+    // A different stream than the model's
+    uint64_t state = seed * 2 + 3;
+    for (uint32_t i = 0; i < n_sample; i++) {
+        uint8_t predicted;
+        synth_input(x, model->n_feature, sparsity, &state);
+        synth_plant(x, model, i % model->n_class, &state);
+        tsetlin_evaluate(model, x, votes, &predicted);
+
+        uint32_t c = predict(votes, model->n_class);
+        count[c]++;
+        dataset_set(ds, i, x, (uint16_t)c);
+    }
+
+    // Planted clauses compete with every other firing clause, show how
+    // the predictions actually fell
+    uint32_t n_hit = 0;
+    for (uint32_t c = 0; c < model->n_class; c++)
+        n_hit += (count[c] > 0);
+    printf("labels    %lu of %lu classes predicted at least once\n", (unsigned long)n_hit, (unsigned long)model->n_class);
+
+    int ret = dataset_save(ds, path);
+
+    dataset_free(ds);
+    free(x);
+    free(votes);
+    free(count);
+
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    synth_model_config_t cfg;
+    synth_model_defaults(&cfg);
+
+    float sparsity = 0.5f;
+    uint32_t n_sample = 1000;
+    int compact = 0;
+
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        const char* opt = argv[arg];
+        if (strcmp(opt, "--compact") == 0) {
+            compact = 1;
+            continue;
+        }
+        if (arg + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        const char* val = argv[++arg];
+        if (strcmp(opt, "--classes") == 0)       cfg.n_class = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--features") == 0) cfg.n_feature = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--clauses") == 0)  cfg.n_clause = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--states") == 0)   cfg.n_state = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--density") == 0)  cfg.density = (float)strtod(val, NULL);
+        else if (strcmp(opt, "--include") == 0)  cfg.include = (float)strtod(val, NULL);
+        else if (strcmp(opt, "--sparsity") == 0) sparsity = (float)strtod(val, NULL);
+        else if (strcmp(opt, "--samples") == 0)  n_sample = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "--seed") == 0)     cfg.seed = strtoull(val, NULL, 10);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    int n_rest = argc - arg;
+    if (n_rest < 1 || n_rest > 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[arg];
+    const char* data_path = (n_rest == 2) ? argv[arg + 1] : NULL;
+
+    if (data_path && cfg.n_class > MAX_LABEL_CLASS) {
+        LOGE(TAG, "Dataset labels only hold %lu classes, write the model alone for --classes %lu",
+             (unsigned long)MAX_LABEL_CLASS, (unsigned long)cfg.n_class);
+        return 1;
+    }
+
+    Tsetlin* model = synth_model(&cfg);
+    if (!model)
+        return 1;
+
+    int ret = compact ? tsetlin_save_compact(model, model_path) : tsetlin_save(model, model_path);
+    if (ret != 0) {
+        LOGE(TAG, "Failed to save %s", model_path);
+        tsetlin_free(model);
+        return 1;
+    }
+
+    size_t n_literal = 0, n_included = 0;
+    for (size_t i = 0; i < model->n_clauses_compressed; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        for (size_t k = 0; k < clause->n_pos_literal + clause->n_neg_literal; k++) {
+            n_literal++;
+            n_included += clause->data[k] > model->n_state / 2;
+        }
+    }
+
+    printf("model     %lu classes, %lu features, %lu clauses, %lu states -> %s\n",
+           (unsigned long)cfg.n_class, (unsigned long)cfg.n_feature, (unsigned long)cfg.n_clause,
+           (unsigned long)cfg.n_state, model_path);
+    printf("literals  %lu stored, %lu included\n", (unsigned long)n_literal, (unsigned long)n_included);
+
+    if (data_path) {
+        ret = write_dataset(model, data_path, n_sample, sparsity, cfg.seed);
+        if (ret != 0) {
+            LOGE(TAG, "Failed to save %s", data_path);
+            tsetlin_free(model);
+            return 1;
+        }
+        printf("dataset   %lu samples, sparsity %.2f -> %s\n", (unsigned long)n_sample, sparsity, data_path);
+    }
+
+    tsetlin_free(model);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <tsetlin_profile.h>
+#include <mnist.h>
+#include <logging.h>
+
+static const char* TAG = "lime-tm-profile";
+
+// Booleanized dataset from a cache or an IDX image/label pair
+static dataset_t* load_set(const Tsetlin* model, int argc, char** argv) {
+    if (argc == 1)
+        return dataset_map(argv[0]);
+
+    int rows, cols;
+    if (mnist_image_info(argv[0], &rows, &cols) == 0 || rows * cols == 0)
+        return NULL;
+
+    int num_bits = (int)(model->n_feature / (uint32_t)(rows * cols));
+    return mnist_load_dataset(argv[0], argv[1], num_bits);
+}
+
+static double percent(uint64_t n, uint64_t total) {
+    return total ? (double)n / (double)total * 100 : 0;
+}
+
+static void print_summary(const tsetlin_profile_t* p) {
+    uint32_t n_evaluated = p->n_clause / 2 * 2;
+    uint64_t n_dead = 0, n_always = 0;
+    for (uint32_t c = 0; c < p->n_class; c++) {
+        for (uint32_t j = 0; j < n_evaluated; j++) {
+            uint64_t n = p->n_fire[(size_t)c * p->n_clause + j];
+            n_dead += (n == 0);
+            n_always += (n == p->n_sample);
+        }
+    }
+
+    uint64_t n_literal = 0;
+    uint32_t n_unused = 0;
+    for (uint32_t k = 0; k < p->n_feature; k++) {
+        n_literal += p->n_include[k * 2] + p->n_include[k * 2 + 1];
+        n_unused += (p->n_include[k * 2] == 0 && p->n_include[k * 2 + 1] == 0);
+    }
+
+    uint64_t n_clauses = (uint64_t)p->n_class * n_evaluated;
+    printf("samples   %llu, accuracy %.2f%%\n", (unsigned long long)p->n_sample, percent(p->n_correct, p->n_sample));
+    printf("clauses   %llu never fire (%.1f%%), %llu always fire, of %llu\n",
+           (unsigned long long)n_dead, percent(n_dead, n_clauses),
+           (unsigned long long)n_always, (unsigned long long)n_clauses);
+    printf("literals  %llu included, %.2f per clause\n",
+           (unsigned long long)n_literal, n_clauses ? (double)n_literal / (double)n_clauses : 0);
+    printf("features  %lu of %lu never included, can be dropped\n",
+           (unsigned long)n_unused, (unsigned long)p->n_feature);
+
+    int32_t vote_max = 0;
+    printf("class  samples  margin mean    min    max  |votes| max  >= T\n");
+    for (uint32_t c = 0; c < p->n_class; c++) {
+        uint64_t n = p->n_labelled[c];
+        printf("%5lu  %7llu  %11.2f  %5ld  %5ld  %11ld  %5.1f%%\n",
+               (unsigned long)c, (unsigned long long)n,
+               n ? (double)p->margin_sum[c] / (double)n : 0.0,
+               (long)p->margin_min[c], (long)p->margin_max[c], (long)p->vote_max[c],
+               percent(p->n_saturated[c], p->n_sample));
+        if (p->vote_max[c] > vote_max)
+            vote_max = p->vote_max[c];
+    }
+    printf("headroom  |votes| reached %ld of T = %lu\n", (long)vote_max, (unsigned long)p->T);
+}
+
+int main(int argc, char** argv) {
+    uint32_t T = 10;
+    uint32_t limit = 0;
+
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--T") == 0 && arg + 1 < argc) {
+            T = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else if (strcmp(argv[arg], "--limit") == 0 && arg + 1 < argc) {
+            limit = (uint32_t)strtoul(argv[++arg], NULL, 10);
+        } else {
+            break;
+        }
+    }
+
+    int n_rest = argc - arg;
+    if (n_rest < 3 || n_rest > 4) {
+        printf("Usage: %s [--T N] [--limit N] <model.cpb> <report.json> <data.lds | <images> <labels>>\n", argv[0]);
+        printf("Runs the dataset through the model and reports how often each clause\n");
+        printf("fires, how many clauses include each literal, and per class vote\n");
+        printf("margins and how close votes come to T (default 10, as in training).\n");
+        printf("--limit profiles only the first N samples.\n");
+        return 1;
+    }
+    const char* in = argv[arg];
+    const char* out = argv[arg + 1];
+
+    Tsetlin* model = tsetlin_load(in);
+    if (!model)
+        return 1;
+
+    dataset_t* ds = load_set(model, n_rest - 2, argv + arg + 2);
+    if (!ds || ds->n_feature != model->n_feature) {
+        LOGE(TAG, "Dataset does not match the model");
+        dataset_free(ds);
+        tsetlin_free(model);
+        return 1;
+    }
+
+    tsetlin_profile_t profile;
+    uint8_t* x = (uint8_t*)malloc(model->n_feature);
+    if (!x || tsetlin_profile_init(&profile, model, T) != 0) {
+        LOGE(TAG, "Failed to allocate memory");
+        free(x);
+        dataset_free(ds);
+        tsetlin_free(model);
+        return 1;
+    }
+
+    uint32_t n_sample = (limit && limit < ds->n_sample) ? limit : ds->n_sample;
+    for (uint32_t i = 0; i < n_sample; i++) {
+        dataset_get(ds, i, x);
+        tsetlin_profile_sample(&profile, model, x, ds->y[i]);
+    }
+
+    int ret = tsetlin_profile_save(&profile, out);
+    if (ret == 0)
+        print_summary(&profile);
+
+    tsetlin_profile_free(&profile);
+    free(x);
+    dataset_free(ds);
+    tsetlin_free(model);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <tsetlin_prune.h>
+#include <mnist.h>
+#include <logging.h>
+
+static const char* TAG = "lime-tm-prune";
+
+// Booleanized test set from a dataset cache or an IDX image/label pair
+static dataset_t* load_test_set(const Tsetlin* model, int argc, char** argv) {
+    if (argc == 1)
+        return dataset_map(argv[0]);
+
+    int rows, cols;
+    if (mnist_image_info(argv[0], &rows, &cols) == 0 || rows * cols == 0)
+        return NULL;
+
+    int num_bits = (int)(model->n_feature / (uint32_t)(rows * cols));
+    return mnist_load_dataset(argv[0], argv[1], num_bits);
+}
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+static double accuracy(Tsetlin* model, const dataset_t* ds, uint8_t* x, int32_t* votes) {
+    uint32_t correct = 0;
+    for (uint32_t i = 0; i < ds->n_sample; i++) {
+        uint8_t predicted;
+        dataset_get(ds, i, x);
+        tsetlin_evaluate(model, x, votes, &predicted);
+        correct += (predicted == ds->y[i]);
+    }
+    return ds->n_sample ? (double)correct / ds->n_sample * 100 : 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t threshold = 0;
+    int threshold_set = 0;
+    int compact = 0;
+
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--threshold") == 0 && arg + 1 < argc) {
+            threshold = (uint32_t)strtoul(argv[++arg], NULL, 10);
+            threshold_set = 1;
+        } else if (strcmp(argv[arg], "--compact") == 0) {
+            compact = 1;
+        } else {
+            break;
+        }
+    }
+
+    int n_rest = argc - arg;
+    if (n_rest < 2 || n_rest > 4) {
+        printf("Usage: %s [--threshold N] [--compact] <in.cpb> <out.cpb> [<test.lds> | <test-images> <test-labels>]\n", argv[0]);
+        printf("Drops literals with a state <= N (default n_state / 2, lossless for\n");
+        printf("inference) and removes clauses that never fire or cancel out. With a\n");
+        printf("test set the accuracy before and after is reported.\n");
+        return 1;
+    }
+    const char* in = argv[arg];
+    const char* out = argv[arg + 1];
+
+    Tsetlin* model = tsetlin_load(in);
+    if (!model)
+        return 1;
+    if (!threshold_set)
+        threshold = model->n_state / 2;
+
+    dataset_t* test_set = NULL;
+    uint8_t* x = NULL;
+    int32_t* votes = NULL;
+    double acc_before = 0;
+    if (n_rest > 2) {
+        test_set = load_test_set(model, n_rest - 2, argv + arg + 2);
+        if (!test_set || test_set->n_feature != model->n_feature) {
+            LOGE(TAG, "Test set does not match the model");
+            tsetlin_free(model);
+            dataset_free(test_set);
+            return 1;
+        }
+
+        x = (uint8_t*)malloc(model->n_feature);
+        votes = (int32_t*)malloc(sizeof(int32_t) * model->n_class);
+        if (!x || !votes) {
+            LOGE(TAG, "Failed to allocate memory");
+            tsetlin_free(model);
+            return 1;
+        }
+        acc_before = accuracy(model, test_set, x, votes);
+    }
+
+    tsetlin_prune_stats_t stats;
+    if (tsetlin_prune(model, threshold, &stats) != 0) {
+        LOGE(TAG, "Failed to prune %s", in);
+        tsetlin_free(model);
+        return 1;
+    }
+
+    int ret = compact ? tsetlin_save_compact(model, out) : tsetlin_save(model, out);
+    if (ret != 0) {
+        LOGE(TAG, "Failed to save %s", out);
+        tsetlin_free(model);
+        return 1;
+    }
+
+    printf("threshold %lu\n", (unsigned long)threshold);
+    printf("literals  %lu -> %lu\n", (unsigned long)stats.n_literal_before, (unsigned long)stats.n_literal_after);
+    printf("clauses   %lu -> %lu (%lu never fire, %lu cancel out, %lu stubs)\n",
+           (unsigned long)stats.n_clause_before, (unsigned long)stats.n_clause_after,
+           (unsigned long)stats.n_dead, (unsigned long)stats.n_cancelled, (unsigned long)stats.n_stub);
+    printf("n_clause  %lu per class\n", (unsigned long)model->n_clause);
+    printf("size      %ld -> %ld bytes\n", file_size(in), file_size(out));
+
+    if (test_set) {
+        double acc_after = accuracy(model, test_set, x, votes);
+        printf("accuracy  %.2f%% -> %.2f%% (%+.2f)\n", acc_before, acc_after, acc_after - acc_before);
+        free(x);
+        free(votes);
+        dataset_free(test_set);
+    }
+
+    tsetlin_free(model);
+    return 0;
+}
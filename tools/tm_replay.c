@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tsetlin.h>
+#include <logging.h>
+
+static const char* TAG = "lime-tm-replay";
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        printf("Usage: %s <base.cpb> <journal> <output.cpb>\n", argv[0]);
+        printf("Applies every complete segment of a delta journal to the base\n");
+        printf("model it was started from and saves the result.\n");
+        return 1;
+    }
+
+    Tsetlin* model = tsetlin_load(argv[1]);
+    if (!model)
+        return 1;
+
+    uint32_t last_seq = 0;
+    int applied = tsetlin_delta_replay(model, argv[2], &last_seq);
+    if (applied < 0) {
+        LOGE(TAG, "Failed to replay %s", argv[2]);
+        tsetlin_free(model);
+        return 1;
+    }
+
+    int ret = tsetlin_save(model, argv[3]);
+    tsetlin_free(model);
+    if (ret != 0) {
+        LOGE(TAG, "Failed to save %s", argv[3]);
+        return 1;
+    }
+
+    if (applied > 0)
+        printf("%s + %d segments (last seq %lu) -> %s\n", argv[1], applied, (unsigned long)last_seq, argv[3]);
+    else
+        printf("%s + 0 segments -> %s\n", argv[1], argv[3]);
+    return 0;
+}
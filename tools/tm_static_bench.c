@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <tsetlin.h>
+#include <tsetlin_static.h>
+#include <mnist.h>
+#include <fast_rand.h>
+#include <logging.h>
+
+// Generated from LIME_TM_CODEGEN_MODEL at build time
+#include "tsetlin_model_static.h"
+
+static const char* TAG = "lime-tm-static-bench";
+
+#define N_RANDOM 2000
+
+static double now_s(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Booleanized test set, or random inputs when none is given
+static dataset_t* load_inputs(uint32_t n_feature, int argc, char** argv) {
+    if (argc == 1)
+        return dataset_map(argv[0]);
+
+    if (argc == 2) {
+        int rows, cols;
+        if (mnist_image_info(argv[0], &rows, &cols) == 0 || rows * cols == 0)
+            return NULL;
+        return mnist_load_dataset(argv[0], argv[1], (int)(n_feature / (uint32_t)(rows * cols)));
+    }
+
+    dataset_t* ds = dataset_create(N_RANDOM, n_feature);
+    uint8_t* x = (uint8_t*)malloc(n_feature);
+    if (!ds || !x) {
+        dataset_free(ds);
+        free(x);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < N_RANDOM; i++) {
+        uint32_t density = fast_rand() % 100;
+        for (uint32_t k = 0; k < n_feature; k++)
+            x[k] = (fast_rand() % 100) < density;
+        dataset_set(ds, i, x, 0);
+    }
+    free(x);
+
+    return ds;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 4) {
+        printf("Usage: %s <model.cpb> [<test.lds> | <test-images> <test-labels>]\n", argv[0]);
+        printf("Times the built-in generated model against tsetlin_evaluate() on the\n");
+        printf("model it was generated from, over a test set or random inputs.\n");
+        return 1;
+    }
+
+    const tsetlin_static_t* fixed = &tsetlin_model_static;
+
+    Tsetlin* model = tsetlin_load(argv[1]);
+    if (!model)
+        return 1;
+    if (model->n_class != fixed->n_class || model->n_feature != fixed->n_feature || model->n_clause != fixed->n_clause) {
+        LOGE(TAG, "%s is not the model this binary was generated from", argv[1]);
+        tsetlin_free(model);
+        return 1;
+    }
+
+    dataset_t* ds = load_inputs(model->n_feature, argc - 2, argv + 2);
+    uint8_t* x = (uint8_t*)malloc(model->n_feature);
+    int32_t* votes = (int32_t*)malloc(sizeof(int32_t) * model->n_class);
+    uint8_t* expected = ds ? (uint8_t*)malloc(ds->n_sample) : NULL;
+    if (!ds || ds->n_feature != model->n_feature || !x || !votes || !expected) {
+        LOGE(TAG, "Failed to load inputs");
+        tsetlin_free(model);
+        dataset_free(ds);
+        free(x); free(votes); free(expected);
+        return 1;
+    }
+
+    double start = now_s();
+    for (uint32_t i = 0; i < ds->n_sample; i++) {
+        dataset_get(ds, i, x);
+        tsetlin_evaluate(model, x, votes, &expected[i]);
+    }
+    double t_model = now_s() - start;
+
+    uint32_t mismatch = 0;
+    start = now_s();
+    for (uint32_t i = 0; i < ds->n_sample; i++) {
+        uint8_t predicted;
+        dataset_get(ds, i, x);
+        tsetlin_static_evaluate(fixed, x, votes, &predicted);
+        mismatch += (predicted != expected[i]);
+    }
+    double t_static = now_s() - start;
+
+    double n = ds->n_sample ? ds->n_sample : 1;
+    printf("samples   %lu\n", (unsigned long)ds->n_sample);
+    printf("protobuf  %.2f us/sample\n", t_model / n * 1e6);
+    printf("generated %.2f us/sample (%s, %.2fx)\n", t_static / n * 1e6,
+           fixed->class_votes ? "specialized" : "tables", t_static > 0 ? t_model / t_static : 0);
+    printf("mismatch  %lu\n", (unsigned long)mismatch);
+
+    tsetlin_free(model);
+    dataset_free(ds);
+    free(x);
+    free(votes);
+    free(expected);
+
+    return mismatch ? 1 : 0;
+}
@@ -1,5 +1,14 @@
 #include "clause.h"
 
+#include <counters.h>
+
+// One clause_evaluate() call that looked at n_scan stored literals
+#define COUNT_EVALUATE(n_scan, fired) do { \
+    PERF_COUNT(PERF_CTR_CLAUSE_EVALUATE, 1); \
+    PERF_COUNT(PERF_CTR_LITERAL_SCAN, (n_scan)); \
+    PERF_COUNT(PERF_CTR_CLAUSE_FIRE, (fired)); \
+} while (0)
+
 float random_float_01(void) {
 #if defined(__ZEPHYR__)
     // uint32_t r = sys_rand32_get();
@@ -12,13 +21,15 @@ float random_float_01(void) {
     uint32_t r = pcg32_fast();
 #endif
 
+    PERF_COUNT(PERF_CTR_RNG_DRAW, 1);
     return (float)r / ((float)UINT32_MAX + 1.0f);
 }
 
-void clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t clause_output, uint32_t n_state, uint32_t n_feature, float s) {
+uint8_t clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t clause_output, uint32_t n_state, uint32_t n_feature, float s) {
     // Want clause_output to be 1
     float s1 = 1 / s;
     float s2 = (s - 1) / s;
+    uint8_t changed = 0;
 
     // Erase Pattern
     // Reduce the number of included literals
@@ -31,6 +42,7 @@ void clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t claus
             {
                 // Decrease state for included positive literal
                 clause->data[k]--;
+                changed = 1;
             }
         }
 
@@ -42,6 +54,7 @@ void clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t claus
             {
                 // Decrease state for included negative literal
                 clause->data[clause->n_pos_literal + k]--;
+                changed = 1;
             }
         }
     }
@@ -57,11 +70,13 @@ void clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t claus
             {
                 // Increase state for included positive literal
                 clause->data[k]++;
+                changed = 1;
             }
             else if (input[idx_literal] == 0 && clause->data[k] > 1 && random_float_01() <= s1)
             {
                 // Decrease state for excluded positive literal
                 clause->data[k]--;
+                changed = 1;
             }
         }
 
@@ -73,17 +88,23 @@ void clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t claus
             {
                 // Decrease state for included negative literal
                 clause->data[clause->n_pos_literal + k]--;
+                changed = 1;
             }
             else if (input[idx_literal] == 0 && clause->data[clause->n_pos_literal + k] < n_state && random_float_01() <= s2)
             {
                 // Increase state for excluded negative literal
                 clause->data[clause->n_pos_literal + k]++;
+                changed = 1;
             }
         }
     }
+
+    return changed;
 }
 
-void clause_update_type_II(ClauseCompressed* clause, uint8_t* input, uint32_t n_state, uint32_t n_feature) {
+uint8_t clause_update_type_II(ClauseCompressed* clause, uint8_t* input, uint32_t n_state, uint32_t n_feature) {
+    uint8_t changed = 0;
+
     // Update positive literals
     for (size_t k = 0; k < clause->n_pos_literal; k++)
     {
@@ -93,6 +114,7 @@ void clause_update_type_II(ClauseCompressed* clause, uint8_t* input, uint32_t n_
             // Increase state for included positive literal
             if (clause->data[k] < n_state) {
                 clause->data[k]++;
+                changed = 1;
             }
         }
     }
@@ -106,9 +128,12 @@ void clause_update_type_II(ClauseCompressed* clause, uint8_t* input, uint32_t n_
             // Increase state for included negative literal
             if (clause->data[clause->n_pos_literal + k] < n_state) {
                 clause->data[clause->n_pos_literal + k]++;
+                changed = 1;
             }
         }
     }
+
+    return changed;
 }
 
 uint8_t clause_evaluate(ClauseCompressed* clause, uint8_t* input, uint32_t n_state, uint32_t n_feature) {
@@ -120,6 +145,7 @@ uint8_t clause_evaluate(ClauseCompressed* clause, uint8_t* input, uint32_t n_sta
             // positive literal is included
             if (input[idx_literal] == 0)
             {
+                COUNT_EVALUATE(k + 1, 0);
                 return 0; // Clause evaluates to false
             }
         }
@@ -133,10 +159,12 @@ uint8_t clause_evaluate(ClauseCompressed* clause, uint8_t* input, uint32_t n_sta
             // negative literal is included
             if (input[idx_literal] == 1)
             {
+                COUNT_EVALUATE(clause->n_pos_literal + k + 1, 0);
                 return 0; // Clause evaluates to false
             }
         }
     }
 
+    COUNT_EVALUATE(clause->n_pos_literal + clause->n_neg_literal, 1);
     return 1; // Clause evaluates to true
 }
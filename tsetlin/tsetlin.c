@@ -1,5 +1,8 @@
 #include "tsetlin.h"
 
+#include <counters.h>
+#include <memstat.h>
+
 #if defined(__ZEPHYR__)
     /* Zephyr RTOS */
     #include <zephyr/fs/fs.h>
@@ -33,12 +36,76 @@ uint8_t* tsetlin_read_file(const char* path, size_t* out_size) {
     return buffer;
 }
 
+Tsetlin* tsetlin_unpack(const uint8_t* data, size_t size) {
+    size_t capacity = tsetlin_arena_estimate(&tsetlin__descriptor, data, size);
+    if (capacity == 0) {
+        LOGE(TAG, "Failed to scan protobuf");
+        return NULL;
+    }
+
+    tsetlin_arena_t* arena = tsetlin_arena_create(capacity);
+    if (!arena) {
+        LOGE(TAG, "Failed to allocate %lu bytes for model", (unsigned long)capacity);
+        return NULL;
+    }
+
+    // The scan slabs, the largest temporaries of a load, count as scratch
+    protobuf_c_set_scratch_allocator(&tsetlin_scratch_allocator);
+    Tsetlin* model = tsetlin__unpack(&arena->allocator, size, data);
+    if (!model || (void*)model != tsetlin_arena_first(arena)) {
+        LOGE(TAG, "Failed to unpack protobuf");
+        tsetlin_arena_destroy(arena);
+        return NULL;
+    }
+
+    // Compact clauses are expanded next to the unpacked bytes
+    arena->chunk_size = TSETLIN_STREAM_ARENA_CHUNK;
+    if (tsetlin_compact_expand_model(model, arena) != 0) {
+        tsetlin_arena_destroy(arena);
+        return NULL;
+    }
+
+    return model;
+}
+
+Tsetlin* tsetlin_load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return NULL;
+    }
+
+    Tsetlin* model = tsetlin_load_fp(f);
+    fclose(f);
+
+    return model;
+}
+
+void tsetlin_free(Tsetlin* model) {
+    if (!model)
+        return;
+
+    // The model is the first allocation in its arena
+    tsetlin_arena_destroy(tsetlin_arena_from_first(model));
+}
+
+static void mark_dirty(uint8_t* dirty, size_t index) {
+    if (dirty)
+        dirty[index >> 3] |= (uint8_t)(1 << (index & 7));
+}
+
 void tsetlin_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s) {
+    tsetlin_step_tracked(model, X_img, y_target, T, s, NULL);
+}
+
+void tsetlin_step_tracked(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s, uint8_t* dirty) {
+    PERF_COUNT(PERF_CTR_STEP, 1);
+
     // Pair 1: Target class
     int32_t class_sum = 0;
     
     //int8_t pos_clauses_eval[model->n_clause / 2];
-    int8_t* pos_clauses_eval = (int8_t*)malloc(sizeof(int8_t) * model->n_clause / 2);
+    int8_t* pos_clauses_eval = (int8_t*)perf_malloc(sizeof(int8_t) * model->n_clause / 2, PERF_MEM_SCRATCH);
     if (!pos_clauses_eval) {
        LOGE(TAG, "Failed to allocate memory for pos clauses!");
        return;
@@ -46,9 +113,10 @@ void tsetlin_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, f
     memset(pos_clauses_eval, 0, sizeof(int8_t) * model->n_clause / 2);
 
     //int8_t neg_clauses_eval[model->n_clause / 2];
-    int8_t* neg_clauses_eval = (int8_t*)malloc(sizeof(int8_t) * model->n_clause / 2);
+    int8_t* neg_clauses_eval = (int8_t*)perf_malloc(sizeof(int8_t) * model->n_clause / 2, PERF_MEM_SCRATCH);
     if (!neg_clauses_eval) {
         LOGE(TAG, "Failed to allocate memory for neg clauses!");
+        perf_free(pos_clauses_eval);
         return;
     }
     memset(neg_clauses_eval, 0, sizeof(int8_t) * model->n_clause / 2);
@@ -81,12 +149,18 @@ void tsetlin_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, f
         ClauseCompressed* n_clause = model->clauses_compressed[y_target * model->n_clause + i * 2 + 1];
 
         // Positive Clause: Type I Feedback
-        if (random_float_01() <= c1)
-            clause_update_type_I(p_clause, X_img, pos_clauses_eval[i], model->n_state, model->n_feature, s);
+        if (random_float_01() <= c1) {
+            PERF_COUNT(PERF_CTR_FEEDBACK_TYPE_I, 1);
+            if (clause_update_type_I(p_clause, X_img, pos_clauses_eval[i], model->n_state, model->n_feature, s))
+                mark_dirty(dirty, y_target * model->n_clause + i * 2);
+        }
 
         // Negative Clause: Type II Feedback
-        if (neg_clauses_eval[i] == 1 && (random_float_01() <= c1))
-            clause_update_type_II(n_clause, X_img, model->n_state, model->n_feature);
+        if (neg_clauses_eval[i] == 1 && (random_float_01() <= c1)) {
+            PERF_COUNT(PERF_CTR_FEEDBACK_TYPE_II, 1);
+            if (clause_update_type_II(n_clause, X_img, model->n_state, model->n_feature))
+                mark_dirty(dirty, y_target * model->n_clause + i * 2 + 1);
+        }
     }
 
     // Pair 2: Non-target classes
@@ -104,6 +178,7 @@ void tsetlin_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, f
         #else
             other_class = fast_rand() % model->n_class;
         #endif
+        PERF_COUNT(PERF_CTR_RNG_DRAW, 1);
     }
 
     class_sum = 0;
@@ -135,17 +210,25 @@ void tsetlin_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, f
 
         // Positive Clause: Type II Feedback
         if (pos_clauses_eval[i] == 1 && (random_float_01() <= c2)) {
-            clause_update_type_II(p_clause, X_img, model->n_state, model->n_feature);
+            PERF_COUNT(PERF_CTR_FEEDBACK_TYPE_II, 1);
+            if (clause_update_type_II(p_clause, X_img, model->n_state, model->n_feature))
+                mark_dirty(dirty, other_class * model->n_clause + i * 2);
         }
 
         // Negative Clause: Type I Feedback
         if (neg_clauses_eval[i] == 1 && (random_float_01() <= c2)) {
-            clause_update_type_I(n_clause, X_img, neg_clauses_eval[i], model->n_state, model->n_feature, s);
+            PERF_COUNT(PERF_CTR_FEEDBACK_TYPE_I, 1);
+            if (clause_update_type_I(n_clause, X_img, neg_clauses_eval[i], model->n_state, model->n_feature, s))
+                mark_dirty(dirty, other_class * model->n_clause + i * 2 + 1);
         }
     }
+
+    perf_free(pos_clauses_eval);
+    perf_free(neg_clauses_eval);
 }
 
 int tsetlin_evaluate(Tsetlin* model, uint8_t* input, int32_t *out_votes, uint8_t* out_class) {
+    PERF_COUNT(PERF_CTR_EVALUATE, 1);
     memset(out_votes, 0, model->n_class * sizeof(int32_t));
 
     for (size_t c = 0; c < model->n_class; c++)
@@ -11,9 +11,26 @@
 #include <tsetlin.pb-c.h>
 #include <logging.h>
 #include "clause.h"
+#include "tsetlin_arena.h"
+#include "tsetlin_compact.h"
+#include "tsetlin_stream.h"
+#include "tsetlin_save.h"
+#include "tsetlin_delta.h"
 
 uint8_t* tsetlin_read_file(const char* path, size_t* out_size);
 
+// tsetlin_unpack() decodes an in-memory image into a single arena sized
+// from a pre-scan of the buffer. tsetlin_load() streams the file instead
+// of reading it whole (see tsetlin_stream.h). Models from either must be
+// released with tsetlin_free(), never tsetlin__free_unpacked().
+Tsetlin* tsetlin_unpack(const uint8_t* data, size_t size);
+Tsetlin* tsetlin_load(const char* path);
+void tsetlin_free(Tsetlin* model);
+
 void tsetlin_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s);
 
+// Same as tsetlin_step(), and sets bit (class * n_clause + clause) in
+// dirty for every clause whose states changed (see tsetlin_delta.h)
+void tsetlin_step_tracked(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s, uint8_t* dirty);
+
 int tsetlin_evaluate(Tsetlin* model, uint8_t* input, int32_t *out_votes, uint8_t* out_class);
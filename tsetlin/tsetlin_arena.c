@@ -0,0 +1,262 @@
+#include "tsetlin_arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memstat.h>
+
+#define ARENA_ROUND(x) (((x) + TSETLIN_ARENA_ALIGN - 1) & ~(size_t)(TSETLIN_ARENA_ALIGN - 1))
+
+// Header sizes rounded so that chunk payloads stay aligned
+#define ARENA_HEADER_SIZE ARENA_ROUND(sizeof(tsetlin_arena_t))
+#define CHUNK_HEADER_SIZE ARENA_ROUND(sizeof(tsetlin_arena_chunk_t))
+
+// Repeated fields seen per message while estimating
+#define ARENA_MAX_FIELDS 32
+
+static void* arena_alloc(void* allocator_data, size_t size) {
+    tsetlin_arena_t* arena = (tsetlin_arena_t*)allocator_data;
+    size = ARENA_ROUND(size);
+
+    if ((size_t)(arena->end - arena->cur) < size) {
+        size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+
+        tsetlin_arena_chunk_t* chunk = (tsetlin_arena_chunk_t*)perf_malloc(CHUNK_HEADER_SIZE + chunk_size, PERF_MEM_MODEL);
+        if (!chunk)
+            return NULL;
+
+        chunk->next = arena->chunks;
+        chunk->size = chunk_size;
+        arena->chunks = chunk;
+        arena->n_chunk++;
+
+        arena->cur = (uint8_t*)chunk + CHUNK_HEADER_SIZE;
+        arena->end = arena->cur + chunk_size;
+    }
+
+    void* p = arena->cur;
+    arena->cur += size;
+    arena->used += size;
+    arena->n_alloc++;
+
+    return p;
+}
+
+static void arena_free(void* allocator_data, void* data) {
+    // Everything is released at once in tsetlin_arena_destroy()
+    (void)allocator_data;
+    (void)data;
+}
+
+static void* heap_alloc(void* allocator_data, size_t size) {
+    (void)allocator_data;
+    return perf_malloc(size, PERF_MEM_MODEL);
+}
+
+static void heap_free(void* allocator_data, void* data) {
+    (void)allocator_data;
+    perf_free(data);
+}
+
+ProtobufCAllocator tsetlin_allocator = { heap_alloc, heap_free, NULL };
+
+static void* scratch_alloc(void* allocator_data, size_t size) {
+    (void)allocator_data;
+    return perf_malloc(size, PERF_MEM_SCRATCH);
+}
+
+ProtobufCAllocator tsetlin_scratch_allocator = { scratch_alloc, heap_free, NULL };
+
+tsetlin_arena_t* tsetlin_arena_create(size_t capacity) {
+    capacity = ARENA_ROUND(capacity);
+
+    tsetlin_arena_t* arena = (tsetlin_arena_t*)perf_malloc(ARENA_HEADER_SIZE + capacity, PERF_MEM_MODEL);
+    if (!arena)
+        return NULL;
+
+    memset(arena, 0, sizeof(tsetlin_arena_t));
+    arena->allocator.alloc = arena_alloc;
+    arena->allocator.free = arena_free;
+    arena->allocator.allocator_data = arena;
+
+    arena->cur = (uint8_t*)arena + ARENA_HEADER_SIZE;
+    arena->end = arena->cur + capacity;
+    arena->chunk_size = TSETLIN_ARENA_MIN_CHUNK;
+    arena->n_chunk = 1;
+
+    return arena;
+}
+
+void tsetlin_arena_destroy(tsetlin_arena_t* arena) {
+    if (!arena)
+        return;
+
+    tsetlin_arena_chunk_t* chunk = arena->chunks;
+    while (chunk) {
+        tsetlin_arena_chunk_t* next = chunk->next;
+        perf_free(chunk);
+        chunk = next;
+    }
+
+    perf_free(arena);
+}
+
+void* tsetlin_arena_alloc(tsetlin_arena_t* arena, size_t size) {
+    return arena_alloc(arena, size);
+}
+
+void* tsetlin_arena_first(tsetlin_arena_t* arena) {
+    return (uint8_t*)arena + ARENA_HEADER_SIZE;
+}
+
+tsetlin_arena_t* tsetlin_arena_from_first(void* first) {
+    return (tsetlin_arena_t*)((uint8_t*)first - ARENA_HEADER_SIZE);
+}
+
+static size_t read_varint(const uint8_t* data, size_t len, uint64_t* out) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < len && i < 10; i++) {
+        v |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0) {
+            *out = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static size_t repeated_elt_size(ProtobufCType type) {
+    switch (type) {
+        case PROTOBUF_C_TYPE_SINT64:
+        case PROTOBUF_C_TYPE_INT64:
+        case PROTOBUF_C_TYPE_UINT64:
+        case PROTOBUF_C_TYPE_SFIXED64:
+        case PROTOBUF_C_TYPE_FIXED64:
+        case PROTOBUF_C_TYPE_DOUBLE:
+            return 8;
+        case PROTOBUF_C_TYPE_BOOL:
+            return sizeof(protobuf_c_boolean);
+        case PROTOBUF_C_TYPE_STRING:
+        case PROTOBUF_C_TYPE_MESSAGE:
+            return sizeof(void*);
+        case PROTOBUF_C_TYPE_BYTES:
+            return sizeof(ProtobufCBinaryData);
+        default:
+            return 4;
+    }
+}
+
+// Number of elements in a packed repeated field
+static size_t packed_count(ProtobufCType type, const uint8_t* data, size_t len) {
+    switch (type) {
+        case PROTOBUF_C_TYPE_SFIXED32:
+        case PROTOBUF_C_TYPE_FIXED32:
+        case PROTOBUF_C_TYPE_FLOAT:
+            return len / 4;
+        case PROTOBUF_C_TYPE_SFIXED64:
+        case PROTOBUF_C_TYPE_FIXED64:
+        case PROTOBUF_C_TYPE_DOUBLE:
+            return len / 8;
+        default: {
+            // One element per byte without the continuation bit
+            size_t count = 0;
+            for (size_t i = 0; i < len; i++)
+                count += (data[i] & 0x80) == 0;
+            return count;
+        }
+    }
+}
+
+size_t tsetlin_arena_estimate(const ProtobufCMessageDescriptor* desc, const uint8_t* data, size_t len) {
+    size_t counts[ARENA_MAX_FIELDS] = { 0 };
+    size_t bytes = ARENA_ROUND(desc->sizeof_message);
+    size_t n_unknown = 0;
+
+    if (desc->n_fields > ARENA_MAX_FIELDS)
+        return 0;
+
+    size_t at = 0;
+    while (at < len) {
+        uint64_t key = 0;
+        size_t used = read_varint(data + at, len - at, &key);
+        if (used == 0)
+            return 0;
+        at += used;
+
+        uint32_t tag = (uint32_t)(key >> 3);
+        uint8_t wire_type = (uint8_t)(key & 7);
+
+        size_t field_len = 0;
+        size_t prefix_len = 0;
+        switch (wire_type) {
+            case PROTOBUF_C_WIRE_TYPE_VARINT: {
+                uint64_t v;
+                field_len = read_varint(data + at, len - at, &v);
+                if (field_len == 0)
+                    return 0;
+                break;
+            }
+            case PROTOBUF_C_WIRE_TYPE_64BIT:
+                field_len = 8;
+                break;
+            case PROTOBUF_C_WIRE_TYPE_32BIT:
+                field_len = 4;
+                break;
+            case PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED: {
+                uint64_t v;
+                prefix_len = read_varint(data + at, len - at, &v);
+                if (prefix_len == 0 || v > len - at - prefix_len)
+                    return 0;
+                field_len = prefix_len + (size_t)v;
+                break;
+            }
+            default:
+                return 0;
+        }
+        if (field_len > len - at)
+            return 0;
+
+        const uint8_t* payload = data + at + prefix_len;
+        size_t payload_len = field_len - prefix_len;
+
+        const ProtobufCFieldDescriptor* field = protobuf_c_message_descriptor_get_field(desc, tag);
+        if (!field) {
+            n_unknown++;
+            bytes += ARENA_ROUND(field_len);
+        } else {
+            if (field->label == PROTOBUF_C_LABEL_REPEATED) {
+                size_t index = (size_t)(field - desc->fields);
+                if (wire_type == PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED &&
+                    field->type != PROTOBUF_C_TYPE_STRING &&
+                    field->type != PROTOBUF_C_TYPE_BYTES &&
+                    field->type != PROTOBUF_C_TYPE_MESSAGE) {
+                    counts[index] += packed_count(field->type, payload, payload_len);
+                } else {
+                    counts[index] += 1;
+                }
+            }
+
+            if (field->type == PROTOBUF_C_TYPE_MESSAGE) {
+                size_t sub = tsetlin_arena_estimate((const ProtobufCMessageDescriptor*)field->descriptor, payload, payload_len);
+                if (sub == 0)
+                    return 0;
+                bytes += sub;
+            } else if (field->type == PROTOBUF_C_TYPE_STRING) {
+                bytes += ARENA_ROUND(payload_len + 1);
+            } else if (field->type == PROTOBUF_C_TYPE_BYTES) {
+                bytes += ARENA_ROUND(payload_len);
+            }
+        }
+
+        at += field_len;
+    }
+
+    for (unsigned f = 0; f < desc->n_fields; f++) {
+        if (counts[f])
+            bytes += ARENA_ROUND(counts[f] * repeated_elt_size(desc->fields[f].type));
+    }
+    if (n_unknown)
+        bytes += ARENA_ROUND(n_unknown * sizeof(ProtobufCMessageUnknownField));
+
+    return bytes;
+}
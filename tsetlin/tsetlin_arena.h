@@ -0,0 +1,56 @@
+#ifndef _TSETLIN_ARENA_H_
+#define _TSETLIN_ARENA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <protobuf-c/protobuf-c.h>
+
+#define TSETLIN_ARENA_ALIGN      8
+#define TSETLIN_ARENA_MIN_CHUNK  (4 * 1024)
+
+typedef struct tsetlin_arena_chunk {
+    struct tsetlin_arena_chunk* next;
+    size_t size;
+} tsetlin_arena_chunk_t;
+
+// Bump allocator for protobuf-c unpacking. free() is a no-op, the
+// whole arena goes away in tsetlin_arena_destroy(). The first chunk is
+// sized up front (see tsetlin_arena_estimate()), further chunks of at
+// least chunk_size bytes are added when it runs out.
+typedef struct {
+    ProtobufCAllocator allocator;
+
+    tsetlin_arena_chunk_t* chunks;
+    uint8_t* cur;
+    uint8_t* end;
+    size_t chunk_size;
+
+    size_t n_alloc;
+    size_t n_chunk;
+    size_t used;
+} tsetlin_arena_t;
+
+// The arena header and the first chunk come from one malloc, so the
+// first allocation always lands at tsetlin_arena_first(arena)
+tsetlin_arena_t* tsetlin_arena_create(size_t capacity);
+void tsetlin_arena_destroy(tsetlin_arena_t* arena);
+
+void* tsetlin_arena_alloc(tsetlin_arena_t* arena, size_t size);
+
+// protobuf-c on the accounted heap (perf/memstat.h), for messages that
+// are not unpacked into an arena
+extern ProtobufCAllocator tsetlin_allocator;
+
+// Same, counted as scratch, for the temporaries of an unpack; see
+// protobuf_c_set_scratch_allocator()
+extern ProtobufCAllocator tsetlin_scratch_allocator;
+
+void* tsetlin_arena_first(tsetlin_arena_t* arena);
+tsetlin_arena_t* tsetlin_arena_from_first(void* first);
+
+// Bytes needed to unpack a message of type desc from data, found by
+// walking the wire format without allocating. Returns 0 on malformed input.
+size_t tsetlin_arena_estimate(const ProtobufCMessageDescriptor* desc, const uint8_t* data, size_t len);
+
+#endif // _TSETLIN_ARENA_H_
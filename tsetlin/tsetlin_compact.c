@@ -0,0 +1,351 @@
+#include "tsetlin_compact.h"
+
+#include <string.h>
+
+#include <logging.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_compact);
+#endif
+
+static const char* TAG = "tsetlin_compact";
+
+static size_t varint_size(uint32_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static size_t bitmap_bytes(uint32_t n_feature) {
+    return (n_feature + 7) / 8;
+}
+
+// Positions must be strictly increasing within each polarity
+static int positions_sorted(const ClauseCompressed* clause) {
+    size_t n = clause->n_pos_literal + clause->n_neg_literal;
+    for (size_t k = 1; k < n; k++) {
+        if (k != clause->n_pos_literal && clause->position[k] <= clause->position[k - 1])
+            return 0;
+    }
+    return 1;
+}
+
+// The bitmap has room for positions below n_feature only
+static int positions_in_range(const ClauseCompressed* clause, uint32_t n_feature) {
+    size_t n = clause->n_pos_literal + clause->n_neg_literal;
+    for (size_t k = 0; k < n; k++) {
+        if (clause->position[k] >= n_feature)
+            return 0;
+    }
+    return 1;
+}
+
+static size_t delta_size(const ClauseCompressed* clause) {
+    size_t n = clause->n_pos_literal + clause->n_neg_literal;
+    size_t size = 0;
+    uint32_t prev = 0;
+    for (size_t k = 0; k < n; k++) {
+        if (k == clause->n_pos_literal)
+            prev = 0;
+        size += varint_size(clause->position[k] - prev);
+        prev = clause->position[k];
+    }
+    return size;
+}
+
+size_t tsetlin_compact_bound(const ClauseCompressed* clause, uint32_t n_feature) {
+    size_t n = clause->n_pos_literal + clause->n_neg_literal;
+    size_t positions = n * 5;
+    if (positions < 2 * bitmap_bytes(n_feature))
+        positions = 2 * bitmap_bytes(n_feature);
+
+    return n * 2 + positions;
+}
+
+void tsetlin_compact_encode(const ClauseCompressed* clause, uint32_t n_feature, uint8_t* scratch, ClauseCompressed* out) {
+    *out = *clause;
+
+    size_t n = clause->n_pos_literal + clause->n_neg_literal;
+    if (clause->n_data != n || clause->n_position != n)
+        return;
+
+    uint32_t max_state = clause->n_state;
+    for (size_t k = 0; k < n; k++) {
+        if (clause->data[k] > max_state)
+            max_state = clause->data[k];
+    }
+
+    if (max_state <= 0xFFFF) {
+        uint8_t width = (max_state <= 0xFF) ? 1 : 2;
+        for (size_t k = 0; k < n; k++) {
+            scratch[k * width] = (uint8_t)clause->data[k];
+            if (width == 2)
+                scratch[k * width + 1] = (uint8_t)(clause->data[k] >> 8);
+        }
+
+        out->state.data = scratch;
+        out->state.len = n * width;
+        out->state_width = width;
+        out->n_data = 0;
+        out->data = NULL;
+        scratch += n * width;
+    }
+
+    if (!positions_sorted(clause))
+        return;
+
+    size_t delta = delta_size(clause);
+    size_t bitmap = 2 * bitmap_bytes(n_feature);
+
+    if (n > 0 && bitmap < delta && positions_in_range(clause, n_feature)) {
+        memset(scratch, 0, bitmap);
+        for (size_t k = 0; k < n; k++) {
+            size_t bit = clause->position[k] + (k < clause->n_pos_literal ? 0 : bitmap_bytes(n_feature) * 8);
+            scratch[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+        }
+
+        out->position_bitmap.data = scratch;
+        out->position_bitmap.len = bitmap;
+    } else {
+        uint8_t* p = scratch;
+        uint32_t prev = 0;
+        for (size_t k = 0; k < n; k++) {
+            if (k == clause->n_pos_literal)
+                prev = 0;
+
+            uint32_t v = clause->position[k] - prev;
+            prev = clause->position[k];
+            while (v >= 0x80) {
+                *p++ = (uint8_t)(v | 0x80);
+                v >>= 7;
+            }
+            *p++ = (uint8_t)v;
+        }
+
+        out->position_delta.data = scratch;
+        out->position_delta.len = delta;
+    }
+
+    out->n_position = 0;
+    out->position = NULL;
+}
+
+static int decode_delta(const ClauseCompressed* src, uint32_t* out, size_t n, uint32_t n_feature) {
+    const uint8_t* p = src->position_delta.data;
+    const uint8_t* end = p + src->position_delta.len;
+
+    uint32_t prev = 0;
+    for (size_t k = 0; k < n; k++) {
+        if (k == src->n_pos_literal)
+            prev = 0;
+
+        uint32_t v = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            if (p == end || shift > 28)
+                return -1;
+            v |= (uint32_t)(*p & 0x7F) << shift;
+            if ((*p++ & 0x80) == 0)
+                break;
+        }
+
+        prev += v;
+        if (prev >= n_feature)
+            return -1;
+        out[k] = prev;
+    }
+
+    return (p == end) ? 0 : -1;
+}
+
+static int decode_bitmap(const ClauseCompressed* src, uint32_t* out, size_t n, uint32_t n_feature) {
+    size_t bytes = bitmap_bytes(n_feature);
+    if (src->position_bitmap.len != 2 * bytes)
+        return -1;
+
+    size_t count = 0;
+    for (size_t half = 0; half < 2; half++) {
+        const uint8_t* bits = src->position_bitmap.data + half * bytes;
+        for (size_t i = 0; i < bytes; i++) {
+            if (bits[i] == 0)
+                continue;
+
+            for (uint32_t b = 0; b < 8; b++) {
+                if (!((bits[i] >> b) & 1))
+                    continue;
+
+                uint32_t position = (uint32_t)(i * 8 + b);
+                if (position >= n_feature || count == n)
+                    return -1;
+                out[count++] = position;
+            }
+        }
+
+        if (half == 0 && count != src->n_pos_literal)
+            return -1;
+    }
+
+    return (count == n) ? 0 : -1;
+}
+
+static uint32_t* copy_array(tsetlin_arena_t* arena, const uint32_t* array, size_t n) {
+    uint32_t* copy = (uint32_t*)tsetlin_arena_alloc(arena, n * sizeof(uint32_t) + 1);
+    if (copy && n)
+        memcpy(copy, array, n * sizeof(uint32_t));
+    return copy;
+}
+
+int tsetlin_compact_is_compact(const ClauseCompressed* clause) {
+    return clause->state_width != 0 || clause->position_delta.len > 0 || clause->position_bitmap.len > 0;
+}
+
+int tsetlin_compact_expand(const ClauseCompressed* src, ClauseCompressed* dst, uint32_t n_feature, tsetlin_arena_t* arena) {
+    size_t n = src->n_pos_literal + src->n_neg_literal;
+
+    uint32_t* data = src->data;
+    size_t n_data = src->n_data;
+    if (src->state_width != 0) {
+        if ((src->state_width != 1 && src->state_width != 2) || src->state.len != n * src->state_width)
+            return -1;
+
+        data = (uint32_t*)tsetlin_arena_alloc(arena, n * sizeof(uint32_t) + 1);
+        if (!data)
+            return -1;
+
+        // Widening copy, vectorized by the compiler
+        const uint8_t* s = src->state.data;
+        if (src->state_width == 1) {
+            for (size_t k = 0; k < n; k++)
+                data[k] = s[k];
+        } else {
+            for (size_t k = 0; k < n; k++)
+                data[k] = (uint32_t)s[2 * k] | ((uint32_t)s[2 * k + 1] << 8);
+        }
+        n_data = n;
+    }
+
+    uint32_t* position = src->position;
+    size_t n_position = src->n_position;
+    if (src->position_delta.len > 0 || src->position_bitmap.len > 0) {
+        position = (uint32_t*)tsetlin_arena_alloc(arena, n * sizeof(uint32_t) + 1);
+        if (!position)
+            return -1;
+
+        int ret = (src->position_delta.len > 0) ? decode_delta(src, position, n, n_feature)
+                                                : decode_bitmap(src, position, n, n_feature);
+        if (ret != 0)
+            return -1;
+        n_position = n;
+    }
+
+    if (n_data != n || n_position != n)
+        return -1;
+
+    if (dst != src) {
+        // src may point into a read buffer, keep nothing that points into it
+        *dst = *src;
+        if (data == src->data && !(data = copy_array(arena, src->data, n)))
+            return -1;
+        if (position == src->position && !(position = copy_array(arena, src->position, n)))
+            return -1;
+    }
+
+    dst->data = data;
+    dst->n_data = n_data;
+    dst->position = position;
+    dst->n_position = n_position;
+
+    // The compact bytes are dead from here on
+    dst->state.data = NULL;
+    dst->state.len = 0;
+    dst->state_width = 0;
+    dst->position_delta.data = NULL;
+    dst->position_delta.len = 0;
+    dst->position_bitmap.data = NULL;
+    dst->position_bitmap.len = 0;
+
+    return 0;
+}
+
+static size_t read_varint(const uint8_t* data, size_t len, uint64_t* out) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < len && i < 10; i++) {
+        v |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0) {
+            *out = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+int tsetlin_compact_unpack(const uint8_t* data, size_t len, uint32_t n_feature, tsetlin_arena_t* arena, ClauseCompressed** out) {
+    ClauseCompressed src;
+    clause_compressed__init(&src);
+
+    size_t at = 0;
+    while (at < len) {
+        uint64_t key, v;
+        size_t used = read_varint(data + at, len - at, &key);
+        if (used == 0)
+            return -1;
+        at += used;
+
+        uint32_t tag = (uint32_t)(key >> 3);
+        uint8_t wire_type = (uint8_t)(key & 7);
+        if (wire_type != PROTOBUF_C_WIRE_TYPE_VARINT && wire_type != PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED)
+            return 1;
+
+        used = read_varint(data + at, len - at, &v);
+        if (used == 0)
+            return -1;
+        at += used;
+
+        if (wire_type == PROTOBUF_C_WIRE_TYPE_VARINT) {
+            switch (tag) {
+                case 1: src.n_pos_literal = (uint32_t)v; break;
+                case 2: src.n_neg_literal = (uint32_t)v; break;
+                case 3: src.n_state = (uint32_t)v; break;
+                case 7: src.state_width = (uint32_t)v; break;
+                default: return 1;
+            }
+            continue;
+        }
+
+        if (v > len - at)
+            return -1;
+
+        ProtobufCBinaryData bytes = { (size_t)v, (uint8_t*)data + at };
+        switch (tag) {
+            case 6: src.state = bytes; break;
+            case 8: src.position_delta = bytes; break;
+            case 9: src.position_bitmap = bytes; break;
+            default: return 1;
+        }
+        at += (size_t)v;
+    }
+
+    ClauseCompressed* clause = (ClauseCompressed*)tsetlin_arena_alloc(arena, sizeof(ClauseCompressed));
+    if (!clause || tsetlin_compact_expand(&src, clause, n_feature, arena) != 0)
+        return -1;
+
+    *out = clause;
+    return 0;
+}
+
+int tsetlin_compact_expand_model(Tsetlin* model, tsetlin_arena_t* arena) {
+    for (size_t i = 0; i < model->n_clauses_compressed; i++) {
+        ClauseCompressed* clause = model->clauses_compressed[i];
+        if (!tsetlin_compact_is_compact(clause))
+            continue;
+
+        if (tsetlin_compact_expand(clause, clause, model->n_feature, arena) != 0) {
+            LOGE(TAG, "Invalid compact clause %lu", (unsigned long)i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef _TSETLIN_COMPACT_H_
+#define _TSETLIN_COMPACT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+
+#include "tsetlin_arena.h"
+
+// Tsetlin.version of models whose clauses may use the compact fields.
+// Older files leave it at 0 and keep everything in position/data.
+#define TSETLIN_VERSION_COMPACT 2
+
+// Compact clause encoding, chosen per clause when saving:
+//   state           states as uint8 or uint16 (state_width 1 or 2),
+//                   little-endian, positive literals first
+//   position_delta  varint gaps between sorted positions, restarting
+//                   from 0 at the first negative literal
+//   position_bitmap n_feature bits for the positive literals followed
+//                   by n_feature bits for the negative ones
+// A clause that does not fit (states above 65535, unsorted positions) keeps
+// the packed uint32 fields. In memory clauses are always expanded.
+
+// Scratch bytes tsetlin_compact_encode() needs for clause
+size_t tsetlin_compact_bound(const ClauseCompressed* clause, uint32_t n_feature);
+
+// Set out to the compact form of clause. The new fields point into scratch.
+void tsetlin_compact_encode(const ClauseCompressed* clause, uint32_t n_feature, uint8_t* scratch, ClauseCompressed* out);
+
+// Decode the compact fields of src into position/data arrays of dst
+// allocated from arena, dst may be src. Returns -1 if they do not match
+// the literal counts.
+int tsetlin_compact_expand(const ClauseCompressed* src, ClauseCompressed* dst, uint32_t n_feature, tsetlin_arena_t* arena);
+
+// Decode a serialized clause that only uses the scalar and compact
+// fields into arena, without copying the compact bytes. Returns 0 with
+// *out set, 1 if the clause needs the generic unpacker, -1 on error.
+int tsetlin_compact_unpack(const uint8_t* data, size_t len, uint32_t n_feature, tsetlin_arena_t* arena, ClauseCompressed** out);
+
+int tsetlin_compact_is_compact(const ClauseCompressed* clause);
+int tsetlin_compact_expand_model(Tsetlin* model, tsetlin_arena_t* arena);
+
+#endif // _TSETLIN_COMPACT_H_
@@ -0,0 +1,333 @@
+#include "tsetlin_delta.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+#include <memstat.h>
+#include <file64.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_delta);
+#endif
+
+#if !defined(_WIN32) && !defined(__ZEPHYR__) && !defined(ESP_PLATFORM) && !defined(__RTTHREAD__)
+    #define TSETLIN_DELTA_HAS_FSYNC 1
+    #include <unistd.h>
+#endif
+
+static const char* TAG = "tsetlin_delta";
+
+#define FNV_OFFSET 0x811C9DC5u
+#define FNV_PRIME  0x01000193u
+
+// Serialized header and record sizes, see tsetlin_delta.h
+#define DELTA_HEADER_SIZE 28
+#define DELTA_RECORD_SIZE 8
+
+static uint32_t fnv1a(uint32_t h, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Field by field, so the journal does not depend on host padding or byte order
+static void header_encode(const tsetlin_delta_header_t* h, uint8_t* out) {
+    put_u32(out, h->magic);
+    out[4] = (uint8_t)h->version;
+    out[5] = (uint8_t)(h->version >> 8);
+    out[6] = h->state_width;
+    out[7] = h->reserved;
+    put_u32(out + 8, h->seq);
+    put_u32(out + 12, h->n_clauses);
+    put_u32(out + 16, h->n_record);
+    put_u32(out + 20, h->payload_size);
+    put_u32(out + 24, h->checksum);
+}
+
+static void header_decode(const uint8_t* in, tsetlin_delta_header_t* h) {
+    h->magic = get_u32(in);
+    h->version = (uint16_t)(in[4] | (in[5] << 8));
+    h->state_width = in[6];
+    h->reserved = in[7];
+    h->seq = get_u32(in + 8);
+    h->n_clauses = get_u32(in + 12);
+    h->n_record = get_u32(in + 16);
+    h->payload_size = get_u32(in + 20);
+    h->checksum = get_u32(in + 24);
+}
+
+static uint8_t state_width(uint32_t n_state) {
+    return (n_state <= 0xFF) ? 1 : (n_state <= 0xFFFF) ? 2 : 4;
+}
+
+static int is_dirty(const uint8_t* dirty, size_t index) {
+    return (dirty[index >> 3] >> (index & 7)) & 1;
+}
+
+size_t tsetlin_dirty_size(const Tsetlin* model) {
+    return (model->n_clauses_compressed + 7) / 8;
+}
+
+uint8_t* tsetlin_dirty_create(const Tsetlin* model) {
+    uint8_t* dirty = (uint8_t*)calloc(tsetlin_dirty_size(model) + 1, 1);
+    if (!dirty)
+        LOGE(TAG, "Failed to allocate memory for dirty bits");
+    return dirty;
+}
+
+void tsetlin_dirty_clear(const Tsetlin* model, uint8_t* dirty) {
+    memset(dirty, 0, tsetlin_dirty_size(model));
+}
+
+size_t tsetlin_dirty_count(const Tsetlin* model, const uint8_t* dirty) {
+    size_t count = 0;
+    for (size_t i = 0; i < model->n_clauses_compressed; i++)
+        count += is_dirty(dirty, i);
+    return count;
+}
+
+// Narrow n states into out little-endian, returns the bytes used
+static size_t pack_states(const uint32_t* data, size_t n, uint8_t width, uint8_t* out) {
+    for (size_t k = 0; k < n; k++) {
+        uint32_t v = data[k];
+        for (uint8_t b = 0; b < width; b++)
+            out[k * width + b] = (uint8_t)(v >> (8 * b));
+    }
+    return n * width;
+}
+
+// Feed every dirty record either to the checksum or to the file
+static int emit_records(const Tsetlin* model, const uint8_t* dirty, uint8_t width, FILE* f, uint32_t* checksum, uint32_t* n_record, uint32_t* size) {
+    uint8_t chunk[256];
+
+    *checksum = FNV_OFFSET;
+    *n_record = 0;
+    *size = 0;
+
+    for (size_t i = 0; i < model->n_clauses_compressed; i++) {
+        if (!is_dirty(dirty, i))
+            continue;
+
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        uint32_t n_literal = clause->n_pos_literal + clause->n_neg_literal;
+        uint8_t record[DELTA_RECORD_SIZE];
+        put_u32(record, (uint32_t)i);
+        put_u32(record + 4, n_literal);
+
+        *checksum = fnv1a(*checksum, record, sizeof(record));
+        if (f && fwrite(record, sizeof(record), 1, f) != 1)
+            return -1;
+
+        // States go out in chunks so no per-clause buffer is needed
+        size_t left = n_literal;
+        size_t offset = 0;
+        while (left > 0) {
+            size_t n = left < sizeof(chunk) / 4 ? left : sizeof(chunk) / 4;
+            size_t bytes = pack_states(clause->data + offset, n, width, chunk);
+            *checksum = fnv1a(*checksum, chunk, bytes);
+            if (f && fwrite(chunk, 1, bytes, f) != bytes)
+                return -1;
+
+            offset += n;
+            left -= n;
+        }
+
+        (*n_record)++;
+        *size += (uint32_t)(sizeof(record) + n_literal * width);
+    }
+
+    return 0;
+}
+
+long tsetlin_delta_append(const Tsetlin* model, uint8_t* dirty, uint32_t seq, const char* path) {
+    tsetlin_delta_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TSETLIN_DELTA_MAGIC;
+    header.version = TSETLIN_DELTA_VERSION;
+    header.state_width = state_width(model->n_state);
+    header.seq = seq;
+    header.n_clauses = (uint32_t)model->n_clauses_compressed;
+
+    // First pass sizes and checksums the payload, the second writes it
+    emit_records(model, dirty, header.state_width, NULL, &header.checksum, &header.n_record, &header.payload_size);
+    if (header.n_record == 0)
+        return 0;
+
+    FILE* f = fopen(path, "ab");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    uint8_t raw[DELTA_HEADER_SIZE];
+    header_encode(&header, raw);
+
+    uint32_t checksum, n_record, size;
+    int ret = (fwrite(raw, sizeof(raw), 1, f) == 1) ? 0 : -1;
+    if (ret == 0)
+        ret = emit_records(model, dirty, header.state_width, f, &checksum, &n_record, &size);
+
+    if (fflush(f) != 0)
+        ret = -1;
+#if defined(TSETLIN_DELTA_HAS_FSYNC)
+    if (ret == 0)
+        ret = fsync(fileno(f));
+#endif
+    if (fclose(f) != 0)
+        ret = -1;
+
+    // dirty is kept, so the next segment carries these clauses again
+    if (ret != 0) {
+        LOGE(TAG, "Failed to write file %s", path);
+        return -1;
+    }
+
+    tsetlin_dirty_clear(model, dirty);
+    return (long)(DELTA_HEADER_SIZE + header.payload_size);
+}
+
+// Check every record of a segment before any of it is applied
+static int check_segment(const Tsetlin* model, const tsetlin_delta_header_t* header, const uint8_t* payload) {
+    size_t at = 0;
+    for (uint32_t r = 0; r < header->n_record; r++) {
+        uint32_t record[2];
+        if (header->payload_size - at < DELTA_RECORD_SIZE)
+            return -1;
+        record[0] = get_u32(payload + at);
+        record[1] = get_u32(payload + at + 4);
+        at += DELTA_RECORD_SIZE;
+
+        if (record[0] >= model->n_clauses_compressed)
+            return -1;
+
+        const ClauseCompressed* clause = model->clauses_compressed[record[0]];
+        if (record[1] != clause->n_pos_literal + clause->n_neg_literal ||
+            (size_t)record[1] * header->state_width > header->payload_size - at)
+            return -1;
+
+        at += (size_t)record[1] * header->state_width;
+    }
+
+    return (at == header->payload_size) ? 0 : -1;
+}
+
+static void apply_segment(Tsetlin* model, const tsetlin_delta_header_t* header, const uint8_t* payload) {
+    size_t at = 0;
+    for (uint32_t r = 0; r < header->n_record; r++) {
+        uint32_t record[2];
+        record[0] = get_u32(payload + at);
+        record[1] = get_u32(payload + at + 4);
+        at += DELTA_RECORD_SIZE;
+
+        ClauseCompressed* clause = model->clauses_compressed[record[0]];
+        for (uint32_t k = 0; k < record[1]; k++) {
+            uint32_t v = 0;
+            for (uint8_t b = 0; b < header->state_width; b++)
+                v |= (uint32_t)payload[at + b] << (8 * b);
+            clause->data[k] = v;
+            at += header->state_width;
+        }
+    }
+}
+
+// Offset of the next segment magic at or after from, -1 if there is none
+static int64_t find_magic(FILE* f, int64_t from) {
+    if (file_seek64(f, from, SEEK_SET) != 0)
+        return -1;
+
+    uint32_t window = 0;
+    int64_t at = from;
+    int ch;
+    while ((ch = fgetc(f)) != EOF) {
+        window = (window >> 8) | ((uint32_t)ch << 24);
+        at++;
+        if (at - from >= 4 && window == TSETLIN_DELTA_MAGIC)
+            return at - 4;
+    }
+    return -1;
+}
+
+int tsetlin_delta_replay(Tsetlin* model, const char* path, uint32_t* out_last_seq) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    int64_t end = (file_seek64(f, 0, SEEK_END) == 0) ? file_tell64(f) : -1;
+
+    int applied = 0;
+    uint32_t n_skipped = 0;
+    uint8_t* payload = NULL;
+    size_t capacity = 0;
+
+    int64_t at = 0;
+    while (at >= 0 && end - at >= DELTA_HEADER_SIZE) {
+        uint8_t raw[DELTA_HEADER_SIZE];
+        tsetlin_delta_header_t header;
+        if (file_seek64(f, at, SEEK_SET) != 0 || fread(raw, sizeof(raw), 1, f) != 1)
+            break;
+        header_decode(raw, &header);
+
+        int valid = header.magic == TSETLIN_DELTA_MAGIC && header.version == TSETLIN_DELTA_VERSION;
+        if (valid && at == 0 &&
+            (header.n_clauses != model->n_clauses_compressed || header.state_width != state_width(model->n_state))) {
+            LOGE(TAG, "Delta journal does not match the model");
+            applied = -1;
+            break;
+        }
+        valid = valid && header.n_clauses == model->n_clauses_compressed &&
+                header.state_width == state_width(model->n_state) &&
+                header.payload_size <= (uint64_t)(end - at - DELTA_HEADER_SIZE);
+
+        if (valid && header.payload_size > capacity) {
+            uint8_t* grown = (uint8_t*)perf_realloc(payload, header.payload_size, PERF_MEM_SCRATCH);
+            if (!grown) {
+                LOGE(TAG, "Failed to allocate %lu bytes", (unsigned long)header.payload_size);
+                break;
+            }
+            payload = grown;
+            capacity = header.payload_size;
+        }
+
+        if (!valid ||
+            fread(payload, 1, header.payload_size, f) != header.payload_size ||
+            fnv1a(FNV_OFFSET, payload, header.payload_size) != header.checksum ||
+            check_segment(model, &header, payload) != 0) {
+            // Torn by a failed or interrupted append: the segments after it
+            // were written on top, so carry on from the next intact one
+            n_skipped++;
+            at = find_magic(f, at + 1);
+            continue;
+        }
+
+        apply_segment(model, &header, payload);
+        if (out_last_seq)
+            *out_last_seq = header.seq;
+        applied++;
+        at += DELTA_HEADER_SIZE + header.payload_size;
+    }
+
+    if (n_skipped > 0)
+        LOGW(TAG, "Skipped damaged journal data %lu times", (unsigned long)n_skipped);
+
+    perf_free(payload);
+    fclose(f);
+
+    return applied;
+}
@@ -0,0 +1,56 @@
+#ifndef _TSETLIN_DELTA_H_
+#define _TSETLIN_DELTA_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+
+#define TSETLIN_DELTA_MAGIC   0x444D544C  // "LTMD"
+#define TSETLIN_DELTA_VERSION 1
+
+// Delta journal: an append-only file of segments, each holding the full
+// state array of every clause that changed since the previous segment.
+// Replaying the segments in order over the base model the journal was
+// started from rebuilds the latest model. Positions never change during
+// training, so only states are recorded.
+//
+//   header
+//   n_record x { uint32 clause index, uint32 n_literal, states[n_literal] }
+//
+// Every field is little-endian, the header is 28 bytes in the order
+// below. States are stored as uint8/uint16/uint32 depending on n_state.
+// The checksum covers the records, so a segment torn by power loss or a
+// failed write is detected; replay skips it and resumes at the next
+// segment magic. A failed append keeps its dirty bits, so the next
+// segment carries the lost clauses again.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t state_width;
+    uint8_t reserved;
+
+    uint32_t seq;
+    uint32_t n_clauses;
+    uint32_t n_record;
+    uint32_t payload_size;
+    uint32_t checksum;
+} tsetlin_delta_header_t;
+
+// One dirty bit per clause, indexed like clauses_compressed,
+// set by tsetlin_step_tracked()
+size_t tsetlin_dirty_size(const Tsetlin* model);
+uint8_t* tsetlin_dirty_create(const Tsetlin* model);
+void tsetlin_dirty_clear(const Tsetlin* model, uint8_t* dirty);
+size_t tsetlin_dirty_count(const Tsetlin* model, const uint8_t* dirty);
+
+// Append a segment with every dirty clause to the journal at path and
+// clear dirty. Returns the number of bytes written, -1 on error.
+long tsetlin_delta_append(const Tsetlin* model, uint8_t* dirty, uint32_t seq, const char* path);
+
+// Apply every complete segment of the journal to model. Returns the
+// number of segments applied, -1 if the journal does not match the model.
+int tsetlin_delta_replay(Tsetlin* model, const char* path, uint32_t* out_last_seq);
+
+#endif // _TSETLIN_DELTA_H_
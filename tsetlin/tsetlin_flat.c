@@ -0,0 +1,443 @@
+#include "tsetlin_flat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memstat.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_flat);
+#endif
+
+#if !defined(_WIN32) && !defined(__ZEPHYR__) && !defined(ESP_PLATFORM) && !defined(__RTTHREAD__)
+    #define TSETLIN_FLAT_HAS_MMAP 1
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+static const char* TAG = "tsetlin_flat";
+
+static uint64_t align_up(uint64_t x) {
+    return (x + TSETLIN_FLAT_ALIGN - 1) & ~(uint64_t)(TSETLIN_FLAT_ALIGN - 1);
+}
+
+static uint32_t read_value(const void* values, uint8_t width, size_t i) {
+    switch (width) {
+        case 1: return ((const uint8_t*)values)[i];
+        case 2: return ((const uint16_t*)values)[i];
+        default: return ((const uint32_t*)values)[i];
+    }
+}
+
+// count items of width bytes at offset lie within size, without overflow
+static int section_fits(uint64_t offset, uint64_t count, uint64_t width, uint64_t size) {
+    return offset % TSETLIN_FLAT_ALIGN == 0 && offset <= size && count <= (size - offset) / width;
+}
+
+// Every clause must lie within its class, and every position within the
+// input, so evaluation never reads outside the image or the input
+static int check_clauses(const tsetlin_flat_header_t* h, const uint8_t* base) {
+    const uint32_t* class_offset = (const uint32_t*)(base + h->class_offset);
+    const tsetlin_flat_clause_t* clauses = (const tsetlin_flat_clause_t*)(base + h->clause_offset);
+
+    if (class_offset[0] != 0 || class_offset[h->n_class] != h->n_literal)
+        return -1;
+
+    for (uint32_t c = 0; c < h->n_class; c++) {
+        if (class_offset[c + 1] < class_offset[c])
+            return -1;
+
+        for (uint32_t j = 0; j < h->n_clause; j++) {
+            const tsetlin_flat_clause_t* clause = &clauses[(size_t)c * h->n_clause + j];
+            if (clause->offset < class_offset[c] ||
+                (uint64_t)clause->offset + clause->n_pos_literal + clause->n_neg_literal > class_offset[c + 1])
+                return -1;
+        }
+    }
+
+    const void* position = base + h->position_offset;
+    for (uint64_t k = 0; k < h->n_literal; k++) {
+        if (read_value(position, h->position_width, (size_t)k) >= h->n_feature)
+            return -1;
+    }
+
+    return 0;
+}
+
+int tsetlin_flat_from_buffer(tsetlin_flat_t* flat, const void* buf, size_t size) {
+    const tsetlin_flat_header_t* h = (const tsetlin_flat_header_t*)buf;
+
+    if (size < sizeof(tsetlin_flat_header_t) || h->magic != TSETLIN_FLAT_MAGIC) {
+        LOGE(TAG, "Invalid flat model");
+        return -1;
+    }
+    if (h->version != TSETLIN_FLAT_VERSION) {
+        LOGE(TAG, "Unsupported flat model version %lu", (unsigned long)h->version);
+        return -1;
+    }
+
+    uint64_t n_clauses = (uint64_t)h->n_class * h->n_clause;
+    if (h->size > size || h->n_class == 0 || h->n_literal > UINT32_MAX ||
+        (h->position_width != 2 && h->position_width != 4) ||
+        (h->state_width != 1 && h->state_width != 2 && h->state_width != 4) ||
+        !section_fits(h->class_offset, (uint64_t)h->n_class + 1, sizeof(uint32_t), h->size) ||
+        !section_fits(h->clause_offset, n_clauses, sizeof(tsetlin_flat_clause_t), h->size) ||
+        !section_fits(h->position_offset, h->n_literal, h->position_width, h->size) ||
+        !section_fits(h->state_offset, h->n_literal, h->state_width, h->size) ||
+        check_clauses(h, (const uint8_t*)buf) != 0) {
+        LOGE(TAG, "Corrupted flat model");
+        return -1;
+    }
+
+    const uint8_t* base = (const uint8_t*)buf;
+    flat->header = h;
+    flat->class_offset = (const uint32_t*)(base + h->class_offset);
+    flat->clauses = (const tsetlin_flat_clause_t*)(base + h->clause_offset);
+    flat->position = base + h->position_offset;
+    flat->state = base + h->state_offset;
+
+    flat->n_class = h->n_class;
+    flat->n_feature = h->n_feature;
+    flat->n_clause = h->n_clause;
+    flat->n_state = h->n_state;
+
+    flat->base = NULL;
+    flat->size = 0;
+    flat->mapped = 0;
+
+    return 0;
+}
+
+int tsetlin_flat_open(tsetlin_flat_t* flat, const char* path) {
+    void* base = NULL;
+    size_t size = 0;
+    uint8_t mapped = 0;
+
+#if defined(TSETLIN_FLAT_HAS_MMAP)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    size = (size_t)st.st_size;
+    base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        LOGE(TAG, "Failed to mmap file %s", path);
+        return -1;
+    }
+    mapped = 1;
+#else
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    base = perf_malloc(size, PERF_MEM_MODEL);
+    if (!base || fread(base, 1, size, f) != size) {
+        LOGE(TAG, "Failed to read file %s", path);
+        perf_free(base);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+#endif
+
+    if (tsetlin_flat_from_buffer(flat, base, size) != 0) {
+#if defined(TSETLIN_FLAT_HAS_MMAP)
+        munmap(base, size);
+#else
+        perf_free(base);
+#endif
+        return -1;
+    }
+
+    flat->base = base;
+    flat->size = size;
+    flat->mapped = mapped;
+
+    return 0;
+}
+
+void tsetlin_flat_close(tsetlin_flat_t* flat) {
+    if (!flat->base)
+        return;
+
+#if defined(TSETLIN_FLAT_HAS_MMAP)
+    if (flat->mapped)
+        munmap(flat->base, flat->size);
+#else
+    perf_free(flat->base);
+#endif
+
+    flat->base = NULL;
+}
+
+// One evaluation loop per (position, state) width pair, picked once per
+// call instead of per literal. The class is abandoned, returning
+// INT32_MIN, once even every remaining positive clause firing could not
+// bring its votes up to bound.
+#define TSETLIN_FLAT_CLASS_VOTES(NAME, POS_T, STATE_T)                                             \
+static int32_t NAME(const tsetlin_flat_t* flat, uint32_t c, const uint8_t* input, int32_t bound) { \
+    const POS_T* position = (const POS_T*)flat->position;                                          \
+    const STATE_T* state = (const STATE_T*)flat->state;                                            \
+    const uint32_t half = flat->n_state / 2;                                                       \
+    const uint32_t n_clause = flat->n_clause & ~1u;                                                \
+    int32_t votes = 0;                                                                             \
+    int32_t pos_left = (int32_t)(n_clause / 2);                                                    \
+    for (uint32_t j = 0; j < n_clause; j++) {                                                      \
+        const tsetlin_flat_clause_t* clause = &flat->clauses[c * flat->n_clause + j];              \
+        const POS_T* pos = position + clause->offset;                                              \
+        const STATE_T* st = state + clause->offset;                                                \
+        uint8_t output = 1;                                                                        \
+        for (uint32_t k = 0; k < clause->n_pos_literal && output; k++) {                           \
+            if (st[k] > half && input[pos[k]] == 0)                                                \
+                output = 0;                                                                        \
+        }                                                                                          \
+        pos += clause->n_pos_literal;                                                              \
+        st += clause->n_pos_literal;                                                               \
+        for (uint32_t k = 0; k < clause->n_neg_literal && output; k++) {                           \
+            if (st[k] > half && input[pos[k]] == 1)                                                \
+                output = 0;                                                                        \
+        }                                                                                          \
+        if (j & 1) {                                                                               \
+            votes -= output;                                                                       \
+        } else {                                                                                   \
+            votes += output;                                                                       \
+            pos_left--;                                                                            \
+        }                                                                                          \
+        if (votes + pos_left < bound)                                                              \
+            return INT32_MIN;                                                                      \
+    }                                                                                              \
+    return votes;                                                                                  \
+}
+
+TSETLIN_FLAT_CLASS_VOTES(class_votes_16_8, uint16_t, uint8_t)
+TSETLIN_FLAT_CLASS_VOTES(class_votes_16_16, uint16_t, uint16_t)
+TSETLIN_FLAT_CLASS_VOTES(class_votes_16_32, uint16_t, uint32_t)
+TSETLIN_FLAT_CLASS_VOTES(class_votes_32_8, uint32_t, uint8_t)
+TSETLIN_FLAT_CLASS_VOTES(class_votes_32_16, uint32_t, uint16_t)
+TSETLIN_FLAT_CLASS_VOTES(class_votes_32_32, uint32_t, uint32_t)
+
+int32_t tsetlin_flat_class_votes(const tsetlin_flat_t* flat, uint32_t c, const uint8_t* input, int32_t bound) {
+    uint8_t pw = flat->header->position_width;
+    uint8_t sw = flat->header->state_width;
+    if (pw == 2)
+        return (sw == 1) ? class_votes_16_8(flat, c, input, bound) : (sw == 2) ? class_votes_16_16(flat, c, input, bound) : class_votes_16_32(flat, c, input, bound);
+    return (sw == 1) ? class_votes_32_8(flat, c, input, bound) : (sw == 2) ? class_votes_32_16(flat, c, input, bound) : class_votes_32_32(flat, c, input, bound);
+}
+
+int tsetlin_flat_evaluate(const tsetlin_flat_t* flat, const uint8_t* input, int32_t* out_votes, uint8_t* out_class) {
+    int32_t (*class_votes)(const tsetlin_flat_t*, uint32_t, const uint8_t*, int32_t);
+
+    uint8_t pw = flat->header->position_width;
+    uint8_t sw = flat->header->state_width;
+    if (pw == 2) {
+        class_votes = (sw == 1) ? class_votes_16_8 : (sw == 2) ? class_votes_16_16 : class_votes_16_32;
+    } else {
+        class_votes = (sw == 1) ? class_votes_32_8 : (sw == 2) ? class_votes_32_16 : class_votes_32_32;
+    }
+
+    for (uint32_t c = 0; c < flat->n_class; c++) {
+        out_votes[c] = class_votes(flat, c, input, INT32_MIN);
+    }
+
+    // Find class with maximum votes
+    uint8_t max_class = 0;
+    int32_t max_votes = out_votes[0];
+    for (uint32_t c = 1; c < flat->n_class; c++) {
+        if (out_votes[c] > max_votes) {
+            max_votes = out_votes[c];
+            max_class = (uint8_t)c;
+        }
+    }
+
+    *out_class = max_class;
+    return 0;
+}
+
+static int write_padding(FILE* f, uint64_t* offset, uint64_t target) {
+    static const uint8_t zeros[TSETLIN_FLAT_ALIGN] = { 0 };
+    size_t n = (size_t)(target - *offset);
+    *offset = target;
+    return fwrite(zeros, 1, n, f) == n ? 0 : -1;
+}
+
+static int write_values(FILE* f, const uint32_t* values, size_t count, uint8_t width) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v = values[i];
+        uint8_t bytes[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+        if (fwrite(bytes, 1, width, f) != width)
+            return -1;
+    }
+    return 0;
+}
+
+int tsetlin_flat_write(const Tsetlin* model, const char* path) {
+    uint64_t n_clauses = (uint64_t)model->n_class * model->n_clause;
+    if (model->n_clauses_compressed < n_clauses) {
+        LOGE(TAG, "Model has %lu compressed clauses, expected %lu", (unsigned long)model->n_clauses_compressed, (unsigned long)n_clauses);
+        return -1;
+    }
+
+    tsetlin_flat_header_t h;
+    memset(&h, 0, sizeof(h));
+    h.magic = TSETLIN_FLAT_MAGIC;
+    h.version = TSETLIN_FLAT_VERSION;
+    h.n_class = model->n_class;
+    h.n_feature = model->n_feature;
+    h.n_clause = model->n_clause;
+    h.n_state = model->n_state;
+    h.model_type = (uint32_t)model->model_type;
+    h.position_width = (model->n_feature <= 65536) ? 2 : 4;
+    h.state_width = (model->n_state <= 0xFF) ? 1 : (model->n_state <= 0xFFFF) ? 2 : 4;
+
+    for (uint64_t i = 0; i < n_clauses; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        h.n_literal += clause->n_pos_literal + clause->n_neg_literal;
+    }
+    if (h.n_literal > UINT32_MAX) {
+        LOGE(TAG, "Too many literals for the flat format");
+        return -1;
+    }
+
+    h.class_offset = align_up(sizeof(h));
+    h.clause_offset = align_up(h.class_offset + (h.n_class + 1) * sizeof(uint32_t));
+    h.position_offset = align_up(h.clause_offset + n_clauses * sizeof(tsetlin_flat_clause_t));
+    h.state_offset = align_up(h.position_offset + h.n_literal * h.position_width);
+    h.size = align_up(h.state_offset + h.n_literal * h.state_width);
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    uint64_t offset = sizeof(h);
+    int ret = (fwrite(&h, sizeof(h), 1, f) == 1) ? 0 : -1;
+
+    // Class table
+    ret |= write_padding(f, &offset, h.class_offset);
+    uint32_t literal = 0;
+    for (uint32_t c = 0; c <= h.n_class && ret == 0; c++) {
+        ret |= (fwrite(&literal, sizeof(uint32_t), 1, f) == 1) ? 0 : -1;
+        for (uint32_t j = 0; c < h.n_class && j < h.n_clause; j++) {
+            const ClauseCompressed* clause = model->clauses_compressed[c * h.n_clause + j];
+            literal += clause->n_pos_literal + clause->n_neg_literal;
+        }
+    }
+    offset += (h.n_class + 1) * sizeof(uint32_t);
+
+    // Clause table
+    ret |= write_padding(f, &offset, h.clause_offset);
+    literal = 0;
+    for (uint64_t i = 0; i < n_clauses && ret == 0; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        tsetlin_flat_clause_t entry = { literal, clause->n_pos_literal, clause->n_neg_literal };
+        ret |= (fwrite(&entry, sizeof(entry), 1, f) == 1) ? 0 : -1;
+        literal += clause->n_pos_literal + clause->n_neg_literal;
+    }
+    offset += n_clauses * sizeof(tsetlin_flat_clause_t);
+
+    // Positions, then states
+    ret |= write_padding(f, &offset, h.position_offset);
+    for (uint64_t i = 0; i < n_clauses && ret == 0; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        ret |= write_values(f, clause->position, clause->n_pos_literal + clause->n_neg_literal, h.position_width);
+    }
+    offset += h.n_literal * h.position_width;
+
+    ret |= write_padding(f, &offset, h.state_offset);
+    for (uint64_t i = 0; i < n_clauses && ret == 0; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        ret |= write_values(f, clause->data, clause->n_pos_literal + clause->n_neg_literal, h.state_width);
+    }
+    offset += h.n_literal * h.state_width;
+
+    ret |= write_padding(f, &offset, h.size);
+
+    if (fclose(f) != 0 || ret != 0) {
+        LOGE(TAG, "Failed to write file %s", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+Tsetlin* tsetlin_flat_to_model(const tsetlin_flat_t* flat) {
+    size_t n_clauses = (size_t)flat->n_class * flat->n_clause;
+    size_t n_literal = (size_t)flat->header->n_literal;
+
+    // One arena sized for the whole model, released by tsetlin_free() like
+    // every other model. The model must be its first allocation.
+    size_t capacity = sizeof(Tsetlin) + n_clauses * (sizeof(ClauseCompressed*) + sizeof(ClauseCompressed) + 2 * TSETLIN_ARENA_ALIGN) +
+                      2 * n_literal * sizeof(uint32_t);
+    tsetlin_arena_t* arena = tsetlin_arena_create(capacity);
+    if (!arena) {
+        LOGE(TAG, "Failed to allocate %lu bytes for model", (unsigned long)capacity);
+        return NULL;
+    }
+
+    Tsetlin* model = (Tsetlin*)tsetlin_arena_alloc(arena, sizeof(Tsetlin));
+    ClauseCompressed** clauses = (ClauseCompressed**)tsetlin_arena_alloc(arena, n_clauses * sizeof(ClauseCompressed*));
+    if (!model || !clauses) {
+        LOGE(TAG, "Failed to allocate memory for clauses");
+        tsetlin_arena_destroy(arena);
+        return NULL;
+    }
+    tsetlin__init(model);
+
+    model->n_class = flat->n_class;
+    model->n_feature = flat->n_feature;
+    model->n_clause = flat->n_clause;
+    model->n_state = flat->n_state;
+    model->model_type = (ModelType)flat->header->model_type;
+    model->n_clauses_compressed = n_clauses;
+    model->clauses_compressed = clauses;
+
+    for (size_t i = 0; i < n_clauses; i++) {
+        const tsetlin_flat_clause_t* entry = &flat->clauses[i];
+        size_t n = entry->n_pos_literal + entry->n_neg_literal;
+
+        ClauseCompressed* clause = (ClauseCompressed*)tsetlin_arena_alloc(arena, sizeof(ClauseCompressed));
+        uint32_t* position = n ? (uint32_t*)tsetlin_arena_alloc(arena, sizeof(uint32_t) * n) : NULL;
+        uint32_t* data = n ? (uint32_t*)tsetlin_arena_alloc(arena, sizeof(uint32_t) * n) : NULL;
+        if (!clause || (n && (!position || !data))) {
+            LOGE(TAG, "Failed to allocate memory for clause %lu", (unsigned long)i);
+            tsetlin_arena_destroy(arena);
+            return NULL;
+        }
+        clause_compressed__init(clause);
+        clauses[i] = clause;
+
+        clause->n_pos_literal = entry->n_pos_literal;
+        clause->n_neg_literal = entry->n_neg_literal;
+        clause->n_state = flat->n_state;
+        clause->n_position = n;
+        clause->position = position;
+        clause->n_data = n;
+        clause->data = data;
+
+        for (size_t k = 0; k < n; k++) {
+            position[k] = read_value(flat->position, flat->header->position_width, entry->offset + k);
+            data[k] = read_value(flat->state, flat->header->state_width, entry->offset + k);
+        }
+    }
+
+    return model;
+}
@@ -0,0 +1,93 @@
+#ifndef _TSETLIN_FLAT_H_
+#define _TSETLIN_FLAT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+#include <logging.h>
+
+#include "tsetlin_arena.h"
+
+#define TSETLIN_FLAT_MAGIC   0x464D544C  // "LTMF"
+#define TSETLIN_FLAT_VERSION 1
+#define TSETLIN_FLAT_ALIGN   64
+
+// Flat, memory-mappable model image (little-endian):
+//
+//   header
+//   class table    (n_class + 1) x uint32   first literal of each class
+//   clause table   n_class * n_clause x tsetlin_flat_clause_t
+//   positions      n_literal x uint16/uint32
+//   states         n_literal x uint8/uint16/uint32
+//
+// Every section starts on a TSETLIN_FLAT_ALIGN boundary. Clauses keep
+// the ClauseCompressed layout: positive literals first, then negative.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+
+    uint32_t n_class;
+    uint32_t n_feature;
+    uint32_t n_clause;
+    uint32_t n_state;
+    uint32_t model_type;
+
+    uint8_t position_width;
+    uint8_t state_width;
+    uint16_t reserved;
+
+    uint64_t n_literal;
+
+    uint64_t class_offset;
+    uint64_t clause_offset;
+    uint64_t position_offset;
+    uint64_t state_offset;
+    uint64_t size;
+} tsetlin_flat_header_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t n_pos_literal;
+    uint32_t n_neg_literal;
+} tsetlin_flat_clause_t;
+
+typedef struct {
+    const tsetlin_flat_header_t* header;
+    const uint32_t* class_offset;
+    const tsetlin_flat_clause_t* clauses;
+    const void* position;
+    const void* state;
+
+    uint32_t n_class;
+    uint32_t n_feature;
+    uint32_t n_clause;
+    uint32_t n_state;
+
+    // Backing storage when opened from a file
+    void* base;
+    size_t size;
+    uint8_t mapped;
+} tsetlin_flat_t;
+
+// Use an image in place, e.g. from flash. buf must stay valid and be
+// at least 8-byte aligned.
+int tsetlin_flat_from_buffer(tsetlin_flat_t* flat, const void* buf, size_t size);
+
+// mmap the file where available, read it into memory otherwise
+int tsetlin_flat_open(tsetlin_flat_t* flat, const char* path);
+void tsetlin_flat_close(tsetlin_flat_t* flat);
+
+int tsetlin_flat_evaluate(const tsetlin_flat_t* flat, const uint8_t* input, int32_t* out_votes, uint8_t* out_class);
+
+// Votes of class c. Returns INT32_MIN as soon as the class can no longer
+// reach bound; pass INT32_MIN to always evaluate it fully.
+int32_t tsetlin_flat_class_votes(const tsetlin_flat_t* flat, uint32_t c, const uint8_t* input, int32_t bound);
+
+// Converters to and from the protobuf interchange model. The model
+// returned by tsetlin_flat_to_model() is freed with tsetlin_free().
+int tsetlin_flat_write(const Tsetlin* model, const char* path);
+Tsetlin* tsetlin_flat_to_model(const tsetlin_flat_t* flat);
+
+#endif // _TSETLIN_FLAT_H_
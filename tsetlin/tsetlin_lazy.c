@@ -0,0 +1,262 @@
+#include "tsetlin_lazy.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memstat.h>
+#include <file64.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_lazy);
+#endif
+
+static const char* TAG = "tsetlin_lazy";
+
+#define LAZY_ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+static size_t max_class_literals(const tsetlin_lazy_t* lazy) {
+    size_t max = 0;
+    for (uint32_t c = 0; c < lazy->header.n_class; c++) {
+        size_t n = lazy->class_offset[c + 1] - lazy->class_offset[c];
+        if (n > max)
+            max = n;
+    }
+    return max;
+}
+
+size_t tsetlin_lazy_slot_size(const tsetlin_lazy_t* lazy) {
+    size_t n_literal = max_class_literals(lazy);
+    return LAZY_ALIGN(lazy->header.n_clause * sizeof(tsetlin_flat_clause_t)) +
+           LAZY_ALIGN(n_literal * lazy->header.position_width) +
+           LAZY_ALIGN(n_literal * lazy->header.state_width + 1);
+}
+
+static int read_at(FILE* f, uint64_t offset, void* buf, size_t size) {
+    if (offset > (uint64_t)INT64_MAX || file_seek64(f, (int64_t)offset, SEEK_SET) != 0)
+        return -1;
+    return fread(buf, 1, size, f) == size ? 0 : -1;
+}
+
+int tsetlin_lazy_open(tsetlin_lazy_t* lazy, const char* path, size_t budget) {
+    memset(lazy, 0, sizeof(tsetlin_lazy_t));
+
+    lazy->f = fopen(path, "rb");
+    if (!lazy->f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    tsetlin_flat_header_t* h = &lazy->header;
+    if (fread(h, sizeof(tsetlin_flat_header_t), 1, lazy->f) != 1 ||
+        h->magic != TSETLIN_FLAT_MAGIC || h->version != TSETLIN_FLAT_VERSION ||
+        h->n_class == 0 ||
+        (h->position_width != 2 && h->position_width != 4) ||
+        (h->state_width != 1 && h->state_width != 2 && h->state_width != 4)) {
+        LOGE(TAG, "Invalid flat model %s", path);
+        tsetlin_lazy_close(lazy);
+        return -1;
+    }
+
+    // The class table is the page index
+    lazy->class_offset = (uint32_t*)perf_malloc((h->n_class + 1) * sizeof(uint32_t), PERF_MEM_MODEL);
+    lazy->slot_of_class = (int32_t*)perf_malloc(h->n_class * sizeof(int32_t), PERF_MEM_MODEL);
+    lazy->order = (uint32_t*)perf_malloc(h->n_class * sizeof(uint32_t), PERF_MEM_MODEL);
+    if (!lazy->class_offset || !lazy->slot_of_class || !lazy->order ||
+        read_at(lazy->f, h->class_offset, lazy->class_offset, (h->n_class + 1) * sizeof(uint32_t)) != 0) {
+        LOGE(TAG, "Failed to read class table of %s", path);
+        tsetlin_lazy_close(lazy);
+        return -1;
+    }
+
+    for (uint32_t c = 0; c < h->n_class; c++) {
+        if (lazy->class_offset[c + 1] < lazy->class_offset[c]) {
+            LOGE(TAG, "Corrupted class table in %s", path);
+            tsetlin_lazy_close(lazy);
+            return -1;
+        }
+        lazy->slot_of_class[c] = -1;
+    }
+    if (lazy->class_offset[h->n_class] != h->n_literal) {
+        LOGE(TAG, "Corrupted class table in %s", path);
+        tsetlin_lazy_close(lazy);
+        return -1;
+    }
+
+    size_t slot_size = tsetlin_lazy_slot_size(lazy);
+    size_t n_slot = budget / slot_size;
+    if (n_slot < 1)
+        n_slot = 1;
+    if (n_slot > h->n_class)
+        n_slot = h->n_class;
+    lazy->n_slot = (uint32_t)n_slot;
+
+    lazy->slots = (tsetlin_lazy_slot_t*)perf_calloc(n_slot, sizeof(tsetlin_lazy_slot_t), PERF_MEM_MODEL);
+    uint8_t* buf = (uint8_t*)perf_malloc(n_slot * slot_size, PERF_MEM_MODEL);
+    if (!lazy->slots || !buf) {
+        LOGE(TAG, "Failed to allocate %lu bytes for %lu classes", (unsigned long)(n_slot * slot_size), (unsigned long)n_slot);
+        perf_free(buf);
+        tsetlin_lazy_close(lazy);
+        return -1;
+    }
+
+    size_t clause_bytes = LAZY_ALIGN(h->n_clause * sizeof(tsetlin_flat_clause_t));
+    size_t position_bytes = LAZY_ALIGN(max_class_literals(lazy) * h->position_width);
+    for (size_t i = 0; i < n_slot; i++) {
+        tsetlin_lazy_slot_t* slot = &lazy->slots[i];
+        slot->buf = buf + i * slot_size;
+        slot->clauses = (tsetlin_flat_clause_t*)slot->buf;
+        slot->position = slot->buf + clause_bytes;
+        slot->state = slot->buf + clause_bytes + position_bytes;
+        slot->class_id = UINT32_MAX;
+    }
+
+    return 0;
+}
+
+void tsetlin_lazy_close(tsetlin_lazy_t* lazy) {
+    if (lazy->f)
+        fclose(lazy->f);
+    if (lazy->slots)
+        perf_free(lazy->slots[0].buf);
+
+    perf_free(lazy->slots);
+    perf_free(lazy->class_offset);
+    perf_free(lazy->slot_of_class);
+    perf_free(lazy->order);
+    memset(lazy, 0, sizeof(tsetlin_lazy_t));
+}
+
+// Page class c in, evicting the least recently used class if needed
+static tsetlin_lazy_slot_t* load_class(tsetlin_lazy_t* lazy, uint32_t c) {
+    lazy->tick++;
+
+    if (lazy->slot_of_class[c] >= 0) {
+        tsetlin_lazy_slot_t* slot = &lazy->slots[lazy->slot_of_class[c]];
+        slot->last_used = lazy->tick;
+        lazy->n_hit++;
+        return slot;
+    }
+    lazy->n_miss++;
+
+    uint32_t victim = 0;
+    for (uint32_t i = 0; i < lazy->n_slot; i++) {
+        if (lazy->slots[i].class_id == UINT32_MAX) {
+            victim = i;
+            break;
+        }
+        if (lazy->slots[i].last_used < lazy->slots[victim].last_used)
+            victim = i;
+    }
+
+    tsetlin_lazy_slot_t* slot = &lazy->slots[victim];
+    if (slot->class_id != UINT32_MAX)
+        lazy->slot_of_class[slot->class_id] = -1;
+    slot->class_id = UINT32_MAX;
+
+    const tsetlin_flat_header_t* h = &lazy->header;
+    uint32_t first = lazy->class_offset[c];
+    uint32_t n_literal = lazy->class_offset[c + 1] - first;
+
+    if (read_at(lazy->f, h->clause_offset + (uint64_t)c * h->n_clause * sizeof(tsetlin_flat_clause_t),
+                slot->clauses, h->n_clause * sizeof(tsetlin_flat_clause_t)) != 0 ||
+        read_at(lazy->f, h->position_offset + (uint64_t)first * h->position_width,
+                slot->position, (size_t)n_literal * h->position_width) != 0 ||
+        read_at(lazy->f, h->state_offset + (uint64_t)first * h->state_width,
+                slot->state, (size_t)n_literal * h->state_width) != 0) {
+        LOGE(TAG, "Failed to read class %lu", (unsigned long)c);
+        return NULL;
+    }
+
+    // Literal offsets become relative to the slot
+    for (uint32_t j = 0; j < h->n_clause; j++) {
+        tsetlin_flat_clause_t* clause = &slot->clauses[j];
+        clause->offset -= first;
+        if ((uint64_t)clause->offset + clause->n_pos_literal + clause->n_neg_literal > n_literal) {
+            LOGE(TAG, "Corrupted clause table in class %lu", (unsigned long)c);
+            return NULL;
+        }
+    }
+    for (uint32_t k = 0; k < n_literal; k++) {
+        uint32_t position = (h->position_width == 2) ? ((const uint16_t*)slot->position)[k] : ((const uint32_t*)slot->position)[k];
+        if (position >= h->n_feature) {
+            LOGE(TAG, "Corrupted positions in class %lu", (unsigned long)c);
+            return NULL;
+        }
+    }
+
+    slot->class_id = c;
+    slot->last_used = lazy->tick;
+    lazy->slot_of_class[c] = (int32_t)victim;
+
+    return slot;
+}
+
+int tsetlin_lazy_class_votes(tsetlin_lazy_t* lazy, uint32_t c, const uint8_t* input, int32_t bound, int32_t* out_votes) {
+    tsetlin_lazy_slot_t* slot = load_class(lazy, c);
+    if (!slot)
+        return -1;
+
+    // A one-class flat view over the slot
+    tsetlin_flat_t view;
+    memset(&view, 0, sizeof(view));
+    view.header = &lazy->header;
+    view.clauses = slot->clauses;
+    view.position = slot->position;
+    view.state = slot->state;
+    view.n_class = 1;
+    view.n_feature = lazy->header.n_feature;
+    view.n_clause = lazy->header.n_clause;
+    view.n_state = lazy->header.n_state;
+
+    *out_votes = tsetlin_flat_class_votes(&view, 0, input, bound);
+    return 0;
+}
+
+int tsetlin_lazy_evaluate_classes(tsetlin_lazy_t* lazy, const uint8_t* input, const uint32_t* classes, uint32_t n,
+                                  int32_t* out_votes, uint32_t* out_class) {
+    for (uint32_t c = 0; c < lazy->header.n_class; c++)
+        out_votes[c] = INT32_MIN;
+
+    int32_t best = INT32_MIN;
+    uint32_t best_class = UINT32_MAX;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t c = classes[i];
+        if (c >= lazy->header.n_class)
+            continue;
+
+        // Beat the best so far, or tie it from a lower class index
+        int32_t bound = (best_class == UINT32_MAX) ? INT32_MIN : best + (c < best_class ? 0 : 1);
+
+        int32_t votes;
+        if (tsetlin_lazy_class_votes(lazy, c, input, bound, &votes) != 0)
+            return -1;
+        if (votes == INT32_MIN)
+            continue;
+
+        out_votes[c] = votes;
+        best = votes;
+        best_class = c;
+    }
+
+    if (best_class == UINT32_MAX)
+        return -1;
+
+    *out_class = best_class;
+    return 0;
+}
+
+int tsetlin_lazy_evaluate(tsetlin_lazy_t* lazy, const uint8_t* input, int32_t* out_votes, uint32_t* out_class) {
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < lazy->n_slot; i++) {
+        if (lazy->slots[i].class_id != UINT32_MAX)
+            lazy->order[n++] = lazy->slots[i].class_id;
+    }
+    for (uint32_t c = 0; c < lazy->header.n_class; c++) {
+        if (lazy->slot_of_class[c] < 0)
+            lazy->order[n++] = c;
+    }
+
+    return tsetlin_lazy_evaluate_classes(lazy, input, lazy->order, n, out_votes, out_class);
+}
@@ -0,0 +1,67 @@
+#ifndef _TSETLIN_LAZY_H_
+#define _TSETLIN_LAZY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tsetlin_flat.h"
+
+// Lazy per-class loading of a flat model file (see tsetlin_flat.h).
+//
+// Only the header and the class table stay resident. A class is read
+// into one of a fixed number of slots the first time it is visited, and
+// the least recently used class is evicted when every slot is taken.
+// Slots are sized for the largest class and allocated once, so memory
+// use is bounded by the budget and never fragments.
+typedef struct {
+    uint8_t* buf;
+    tsetlin_flat_clause_t* clauses;
+    void* position;
+    void* state;
+
+    uint32_t class_id;   // UINT32_MAX when empty
+    uint32_t last_used;
+} tsetlin_lazy_slot_t;
+
+typedef struct {
+    FILE* f;
+    tsetlin_flat_header_t header;
+    uint32_t* class_offset;
+
+    tsetlin_lazy_slot_t* slots;
+    uint32_t n_slot;
+    int32_t* slot_of_class;   // -1 when not resident
+    uint32_t tick;
+    uint32_t* order;
+
+    uint32_t n_hit;
+    uint32_t n_miss;
+} tsetlin_lazy_t;
+
+// Keep as many classes resident as fit in budget bytes, at least one
+int tsetlin_lazy_open(tsetlin_lazy_t* lazy, const char* path, size_t budget);
+void tsetlin_lazy_close(tsetlin_lazy_t* lazy);
+
+// Bytes one resident class takes
+size_t tsetlin_lazy_slot_size(const tsetlin_lazy_t* lazy);
+
+// Votes of class c, paging it in if needed. out_votes is INT32_MIN once
+// the class can no longer reach bound, see tsetlin_flat_class_votes().
+// Returns -1 if the class cannot be read.
+int tsetlin_lazy_class_votes(tsetlin_lazy_t* lazy, uint32_t c, const uint8_t* input, int32_t bound, int32_t* out_votes);
+
+// Visit only the n given classes, most likely first, and pick the
+// winner among them with the tie-breaking of tsetlin_evaluate(). A class
+// that cannot beat the best so far is abandoned early; it and every
+// class not visited report INT32_MIN in out_votes. The class is a
+// uint32_t here, these models go well past 256 classes. Returns -1 if a
+// class cannot be read.
+int tsetlin_lazy_evaluate_classes(tsetlin_lazy_t* lazy, const uint8_t* input, const uint32_t* classes, uint32_t n,
+                                  int32_t* out_votes, uint32_t* out_class);
+
+// Every class, resident ones first so that a pass pages in as few as
+// possible. Same winner as tsetlin_flat_evaluate().
+int tsetlin_lazy_evaluate(tsetlin_lazy_t* lazy, const uint8_t* input, int32_t* out_votes, uint32_t* out_class);
+
+#endif // _TSETLIN_LAZY_H_
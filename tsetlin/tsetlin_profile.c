@@ -0,0 +1,183 @@
+#include "tsetlin_profile.h"
+#include "clause.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+#include <memstat.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_profile);
+#endif
+
+static const char* TAG = "tsetlin_profile";
+
+static void count_includes(tsetlin_profile_t* profile, const Tsetlin* model) {
+    size_t n_clauses = (size_t)model->n_class * model->n_clause;
+
+    for (size_t i = 0; i < n_clauses; i++) {
+        const ClauseCompressed* clause = model->clauses_compressed[i];
+        size_t n = clause->n_pos_literal + clause->n_neg_literal;
+
+        for (size_t k = 0; k < n; k++) {
+            if (clause->data[k] <= model->n_state / 2 || clause->position[k] >= model->n_feature)
+                continue;
+            profile->n_include[clause->position[k] * 2 + (k >= clause->n_pos_literal)]++;
+        }
+    }
+}
+
+int tsetlin_profile_init(tsetlin_profile_t* profile, const Tsetlin* model, uint32_t T) {
+    memset(profile, 0, sizeof(tsetlin_profile_t));
+    if (model->n_class == 0 || model->n_class > TSETLIN_PROFILE_MAX_CLASS) {
+        LOGE(TAG, "Cannot profile a model of %lu classes", (unsigned long)model->n_class);
+        return -1;
+    }
+
+    profile->n_class = model->n_class;
+    profile->n_clause = model->n_clause;
+    profile->n_feature = model->n_feature;
+    profile->T = T;
+
+    size_t n_class = model->n_class;
+    profile->n_fire = (uint64_t*)perf_calloc(n_class * model->n_clause, sizeof(uint64_t), PERF_MEM_SCRATCH);
+    profile->n_include = (uint32_t*)perf_calloc((size_t)model->n_feature * 2, sizeof(uint32_t), PERF_MEM_SCRATCH);
+    profile->n_labelled = (uint64_t*)perf_calloc(n_class, sizeof(uint64_t), PERF_MEM_SCRATCH);
+    profile->margin_sum = (int64_t*)perf_calloc(n_class, sizeof(int64_t), PERF_MEM_SCRATCH);
+    profile->margin_min = (int32_t*)perf_calloc(n_class, sizeof(int32_t), PERF_MEM_SCRATCH);
+    profile->margin_max = (int32_t*)perf_calloc(n_class, sizeof(int32_t), PERF_MEM_SCRATCH);
+    profile->vote_max = (int32_t*)perf_calloc(n_class, sizeof(int32_t), PERF_MEM_SCRATCH);
+    profile->n_saturated = (uint64_t*)perf_calloc(n_class, sizeof(uint64_t), PERF_MEM_SCRATCH);
+
+    if (!profile->n_fire || !profile->n_include || !profile->n_labelled || !profile->margin_sum ||
+        !profile->margin_min || !profile->margin_max || !profile->vote_max || !profile->n_saturated) {
+        LOGE(TAG, "Failed to allocate memory for the profile");
+        tsetlin_profile_free(profile);
+        return -1;
+    }
+
+    count_includes(profile, model);
+    return 0;
+}
+
+void tsetlin_profile_free(tsetlin_profile_t* profile) {
+    perf_free(profile->n_fire);
+    perf_free(profile->n_include);
+    perf_free(profile->n_labelled);
+    perf_free(profile->margin_sum);
+    perf_free(profile->margin_min);
+    perf_free(profile->margin_max);
+    perf_free(profile->vote_max);
+    perf_free(profile->n_saturated);
+    memset(profile, 0, sizeof(tsetlin_profile_t));
+}
+
+uint8_t tsetlin_profile_sample(tsetlin_profile_t* profile, const Tsetlin* model, uint8_t* input, uint32_t y) {
+    int32_t votes[TSETLIN_PROFILE_MAX_CLASS] = { 0 };
+    uint32_t n_class = model->n_class;
+
+    // Clauses come in pairs, an odd one out is never evaluated
+    for (uint32_t c = 0; c < n_class; c++) {
+        for (uint32_t j = 0; j < model->n_clause / 2 * 2; j++) {
+            size_t i = (size_t)c * model->n_clause + j;
+            if (!clause_evaluate(model->clauses_compressed[i], input, model->n_state, model->n_feature))
+                continue;
+
+            profile->n_fire[i]++;
+            // Even clauses vote for the class, odd ones against
+            votes[c] += (j % 2 == 0) ? 1 : -1;
+        }
+    }
+
+    // Same tie-break as tsetlin_evaluate(): the lowest class wins
+    uint8_t predicted = 0;
+    for (uint32_t c = 1; c < n_class; c++) {
+        if (votes[c] > votes[predicted])
+            predicted = (uint8_t)c;
+    }
+
+    for (uint32_t c = 0; c < n_class; c++) {
+        int32_t v = votes[c] < 0 ? -votes[c] : votes[c];
+        if (v > profile->vote_max[c])
+            profile->vote_max[c] = v;
+        if (profile->T && (uint32_t)v >= profile->T)
+            profile->n_saturated[c]++;
+    }
+
+    if (y < n_class && n_class > 1) {
+        int32_t best_other = INT32_MIN;
+        for (uint32_t c = 0; c < n_class; c++) {
+            if (c != y && votes[c] > best_other)
+                best_other = votes[c];
+        }
+
+        int32_t margin = votes[y] - best_other;
+        if (profile->n_labelled[y] == 0 || margin < profile->margin_min[y])
+            profile->margin_min[y] = margin;
+        if (profile->n_labelled[y] == 0 || margin > profile->margin_max[y])
+            profile->margin_max[y] = margin;
+        profile->margin_sum[y] += margin;
+        profile->n_labelled[y]++;
+    }
+
+    profile->n_sample++;
+    profile->n_correct += (predicted == y);
+    return predicted;
+}
+
+int tsetlin_profile_save(const tsetlin_profile_t* profile, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", path);
+        return -1;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"n_class\": %lu,\n", (unsigned long)profile->n_class);
+    fprintf(f, "  \"n_clause\": %lu,\n", (unsigned long)profile->n_clause);
+    fprintf(f, "  \"n_feature\": %lu,\n", (unsigned long)profile->n_feature);
+    fprintf(f, "  \"T\": %lu,\n", (unsigned long)profile->T);
+    fprintf(f, "  \"n_sample\": %llu,\n", (unsigned long long)profile->n_sample);
+    fprintf(f, "  \"n_correct\": %llu,\n", (unsigned long long)profile->n_correct);
+
+    fprintf(f, "  \"classes\": [\n");
+    for (uint32_t c = 0; c < profile->n_class; c++) {
+        uint64_t n = profile->n_labelled[c];
+        fprintf(f, "    { \"n_labelled\": %llu, \"margin_mean\": %.3f, \"margin_min\": %ld, \"margin_max\": %ld, \"vote_max\": %ld, \"n_saturated\": %llu }%s\n",
+                (unsigned long long)n, n ? (double)profile->margin_sum[c] / (double)n : 0.0,
+                (long)profile->margin_min[c], (long)profile->margin_max[c],
+                (long)profile->vote_max[c], (unsigned long long)profile->n_saturated[c],
+                c + 1 < profile->n_class ? "," : "");
+    }
+    fprintf(f, "  ],\n");
+
+    // One row per class, clauses in model order
+    fprintf(f, "  \"n_fire\": [\n");
+    for (uint32_t c = 0; c < profile->n_class; c++) {
+        fprintf(f, "    [");
+        for (uint32_t j = 0; j < profile->n_clause; j++)
+            fprintf(f, "%s%llu", j ? "," : "", (unsigned long long)profile->n_fire[(size_t)c * profile->n_clause + j]);
+        fprintf(f, "]%s\n", c + 1 < profile->n_class ? "," : "");
+    }
+    fprintf(f, "  ],\n");
+
+    fprintf(f, "  \"n_include_pos\": [");
+    for (uint32_t k = 0; k < profile->n_feature; k++)
+        fprintf(f, "%s%lu", k ? "," : "", (unsigned long)profile->n_include[k * 2]);
+    fprintf(f, "],\n");
+
+    fprintf(f, "  \"n_include_neg\": [");
+    for (uint32_t k = 0; k < profile->n_feature; k++)
+        fprintf(f, "%s%lu", k ? "," : "", (unsigned long)profile->n_include[k * 2 + 1]);
+    fprintf(f, "]\n");
+
+    fprintf(f, "}\n");
+
+    if (fclose(f) != 0) {
+        LOGE(TAG, "Failed to write file %s", path);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef _TSETLIN_PROFILE_H_
+#define _TSETLIN_PROFILE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+
+// Classes fit the uint8_t of tsetlin_evaluate()
+#define TSETLIN_PROFILE_MAX_CLASS 256
+
+// Clause activity over a dataset, for pruning and sizing models.
+//
+// Every sample is evaluated clause by clause, with the same votes and
+// class as tsetlin_evaluate(), while counting how often each clause fires
+// and how far the votes land from each other and from the threshold T.
+// How many clauses include each literal is taken from the model itself.
+//
+// Clauses that never fire are dead weight, features with neither literal
+// included in any clause can be dropped from the booleanizer, and votes
+// that rarely come near T leave room for fewer clauses.
+typedef struct {
+    uint32_t n_class;
+    uint32_t n_clause;
+    uint32_t n_feature;
+    uint32_t T;
+
+    uint64_t n_sample;
+    uint64_t n_correct;
+
+    uint64_t* n_fire;         // [n_class * n_clause] samples each clause fired on
+    uint32_t* n_include;      // [2 * n_feature] clauses including x_k at 2k, not x_k at 2k + 1
+
+    // Per class. The margin is the votes of the labelled class minus the
+    // best other class, over the samples with that label.
+    uint64_t* n_labelled;
+    int64_t* margin_sum;
+    int32_t* margin_min;
+    int32_t* margin_max;
+
+    // Per class, over all samples: the largest |votes| seen and how often
+    // |votes| reached T, where training would have clamped it
+    int32_t* vote_max;
+    uint64_t* n_saturated;
+} tsetlin_profile_t;
+
+int tsetlin_profile_init(tsetlin_profile_t* profile, const Tsetlin* model, uint32_t T);
+void tsetlin_profile_free(tsetlin_profile_t* profile);
+
+// Evaluate one sample labelled y and add it to the profile. Returns the
+// predicted class, as tsetlin_evaluate() would.
+uint8_t tsetlin_profile_sample(tsetlin_profile_t* profile, const Tsetlin* model, uint8_t* input, uint32_t y);
+
+// Summary and the per-clause and per-literal counts as JSON
+int tsetlin_profile_save(const tsetlin_profile_t* profile, const char* path);
+
+#endif // _TSETLIN_PROFILE_H_
@@ -0,0 +1,255 @@
+#include "tsetlin_prune.h"
+#include "tsetlin_arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+#include <memstat.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_prune);
+#endif
+
+static const char* TAG = "tsetlin_prune";
+
+#define FNV_OFFSET 0x811C9DC5u
+#define FNV_PRIME  0x01000193u
+
+static size_t n_literal(const ClauseCompressed* clause) {
+    return clause->n_pos_literal + clause->n_neg_literal;
+}
+
+// Keep the literals above threshold, positive ones first as before
+static void drop_literals(ClauseCompressed* clause, uint32_t threshold) {
+    size_t n = n_literal(clause);
+    size_t out = 0;
+    uint32_t n_pos = 0;
+
+    for (size_t k = 0; k < n; k++) {
+        if (clause->data[k] <= threshold)
+            continue;
+
+        clause->position[out] = clause->position[k];
+        clause->data[out] = clause->data[k];
+        if (k < clause->n_pos_literal)
+            n_pos++;
+        out++;
+    }
+
+    clause->n_pos_literal = n_pos;
+    clause->n_neg_literal = (uint32_t)(out - n_pos);
+    clause->n_position = out;
+    clause->n_data = out;
+}
+
+// Includes both x and not x for some feature, so it never fires
+static int never_fires(const ClauseCompressed* clause, uint32_t n_state, uint8_t* marks) {
+    int dead = 0;
+
+    for (size_t k = 0; k < clause->n_pos_literal; k++) {
+        if (clause->data[k] > n_state / 2)
+            marks[clause->position[k]] = 1;
+    }
+    for (size_t k = clause->n_pos_literal; k < n_literal(clause); k++) {
+        if (clause->data[k] > n_state / 2 && marks[clause->position[k]])
+            dead = 1;
+    }
+    for (size_t k = 0; k < clause->n_pos_literal; k++)
+        marks[clause->position[k]] = 0;
+
+    return dead;
+}
+
+// Hash of the included literals, positive then negative. Equal sets
+// stored in a different order hash differently, which only means that
+// such a pair is not cancelled.
+static uint32_t included_hash(const ClauseCompressed* clause, uint32_t n_state) {
+    uint32_t h = FNV_OFFSET;
+    for (size_t k = 0; k < n_literal(clause); k++) {
+        if (clause->data[k] <= n_state / 2)
+            continue;
+
+        uint32_t v = clause->position[k] * 2 + (k >= clause->n_pos_literal);
+        for (int b = 0; b < 4; b++) {
+            h ^= (uint8_t)(v >> (8 * b));
+            h *= FNV_PRIME;
+        }
+    }
+    return h;
+}
+
+static int same_included(const ClauseCompressed* a, const ClauseCompressed* b, uint32_t n_state) {
+    size_t i = 0, j = 0;
+    size_t na = n_literal(a), nb = n_literal(b);
+
+    for (;;) {
+        while (i < na && a->data[i] <= n_state / 2)
+            i++;
+        while (j < nb && b->data[j] <= n_state / 2)
+            j++;
+
+        if (i == na || j == nb)
+            return i == na && j == nb;
+
+        if (a->position[i] != b->position[j] || (i < a->n_pos_literal) != (j < b->n_pos_literal))
+            return 0;
+        i++;
+        j++;
+    }
+}
+
+// Turn a removed clause into a stub that includes x0 and not x0
+static int make_stub(ClauseCompressed* clause, size_t capacity, uint32_t n_state, tsetlin_arena_t* arena) {
+    if (capacity < 2) {
+        clause->position = (uint32_t*)tsetlin_arena_alloc(arena, 2 * sizeof(uint32_t));
+        clause->data = (uint32_t*)tsetlin_arena_alloc(arena, 2 * sizeof(uint32_t));
+        if (!clause->position || !clause->data)
+            return -1;
+    }
+
+    clause->n_pos_literal = 1;
+    clause->n_neg_literal = 1;
+    clause->n_position = 2;
+    clause->n_data = 2;
+    clause->position[0] = 0;
+    clause->position[1] = 0;
+    clause->data[0] = n_state > 0 ? n_state : 1;
+    clause->data[1] = clause->data[0];
+
+    return 0;
+}
+
+int tsetlin_prune(Tsetlin* model, uint32_t threshold, tsetlin_prune_stats_t* stats) {
+    memset(stats, 0, sizeof(tsetlin_prune_stats_t));
+
+    size_t n_pair = model->n_clause / 2;
+    size_t n_total = model->n_clauses_compressed;
+    if (n_pair == 0 || n_total < (size_t)model->n_class * model->n_clause) {
+        LOGE(TAG, "Model has no clause pairs to prune");
+        return -1;
+    }
+
+    // Per clause: original capacity, liveness, hash
+    size_t* capacity = (size_t*)perf_malloc(n_total * sizeof(size_t), PERF_MEM_SCRATCH);
+    uint8_t* live = (uint8_t*)perf_malloc(n_total, PERF_MEM_SCRATCH);
+    uint32_t* hash = (uint32_t*)perf_malloc(n_total * sizeof(uint32_t), PERF_MEM_SCRATCH);
+    uint8_t* marks = (uint8_t*)perf_calloc(model->n_feature + 1, 1, PERF_MEM_SCRATCH);
+    ClauseCompressed** packed = (ClauseCompressed**)perf_malloc(n_total * sizeof(ClauseCompressed*), PERF_MEM_SCRATCH);
+    if (!capacity || !live || !hash || !marks || !packed) {
+        LOGE(TAG, "Failed to allocate memory");
+        perf_free(capacity); perf_free(live); perf_free(hash); perf_free(marks); perf_free(packed);
+        return -1;
+    }
+
+    int ret = 0;
+    for (size_t i = 0; i < n_total && ret == 0; i++) {
+        ClauseCompressed* clause = model->clauses_compressed[i];
+        capacity[i] = n_literal(clause);
+        stats->n_literal_before += capacity[i];
+
+        if (clause->n_position != capacity[i] || clause->n_data != capacity[i]) {
+            LOGE(TAG, "Clause %lu has inconsistent literal counts", (unsigned long)i);
+            ret = -1;
+            break;
+        }
+        for (size_t k = 0; k < capacity[i]; k++) {
+            if (clause->position[k] >= model->n_feature)
+                ret = -1;
+        }
+        if (ret != 0) {
+            LOGE(TAG, "Clause %lu has a literal out of range", (unsigned long)i);
+            break;
+        }
+
+        drop_literals(clause, threshold);
+        live[i] = !never_fires(clause, model->n_state, marks);
+        stats->n_dead += !live[i];
+        hash[i] = included_hash(clause, model->n_state);
+    }
+
+    // Cancel positive/negative pairs with the same literals, per class
+    for (size_t c = 0; c < model->n_class && ret == 0; c++) {
+        size_t base = c * model->n_clause;
+        for (size_t p = 0; p < n_pair; p++) {
+            size_t ip = base + p * 2;
+            if (!live[ip])
+                continue;
+
+            for (size_t q = 0; q < n_pair; q++) {
+                size_t in = base + q * 2 + 1;
+                if (live[in] && hash[in] == hash[ip] &&
+                    same_included(model->clauses_compressed[ip], model->clauses_compressed[in], model->n_state)) {
+                    live[ip] = 0;
+                    live[in] = 0;
+                    stats->n_cancelled += 2;
+                    break;
+                }
+            }
+        }
+    }
+
+    // The widest class of either polarity sets the new n_clause
+    size_t new_pair = 1;
+    for (size_t c = 0; c < model->n_class; c++) {
+        size_t n_pos = 0, n_neg = 0;
+        for (size_t j = 0; j < n_pair * 2; j++) {
+            if (live[c * model->n_clause + j])
+                (j % 2 == 0) ? n_pos++ : n_neg++;
+        }
+        if (n_pos > new_pair)
+            new_pair = n_pos;
+        if (n_neg > new_pair)
+            new_pair = n_neg;
+    }
+
+    tsetlin_arena_t* arena = tsetlin_arena_from_first(model);
+    for (size_t c = 0; c < model->n_class && ret == 0; c++) {
+        size_t base = c * model->n_clause;
+        size_t next_pos = 0, next_neg = 0, next_removed = 0;
+
+        for (size_t j = 0; j < new_pair * 2 && ret == 0; j++) {
+            size_t polarity = j % 2;
+            size_t* next = polarity ? &next_neg : &next_pos;
+
+            // Next live clause of this polarity, or else any removed one
+            // becomes a stub. A class never needs more stubs than it has
+            // removed clauses, since new_pair <= n_pair.
+            while (*next < n_pair && live[base + *next * 2 + polarity] != 1)
+                (*next)++;
+
+            size_t src;
+            if (*next < n_pair) {
+                src = base + (*next)++ * 2 + polarity;
+            } else {
+                while (live[base + next_removed])
+                    next_removed++;
+                src = base + next_removed;
+                live[src] = 2;  // taken as a stub
+                ret = make_stub(model->clauses_compressed[src], capacity[src], model->n_state, arena);
+                stats->n_stub++;
+            }
+
+            packed[c * new_pair * 2 + j] = model->clauses_compressed[src];
+        }
+    }
+
+    if (ret == 0) {
+        model->n_clause = (uint32_t)(new_pair * 2);
+        model->n_clauses_compressed = (size_t)model->n_class * model->n_clause;
+        memcpy(model->clauses_compressed, packed, model->n_clauses_compressed * sizeof(ClauseCompressed*));
+
+        stats->n_clause_before = n_total;
+        stats->n_clause_after = model->n_clauses_compressed;
+        for (size_t i = 0; i < model->n_clauses_compressed; i++)
+            stats->n_literal_after += n_literal(model->clauses_compressed[i]);
+    }
+
+    perf_free(capacity);
+    perf_free(live);
+    perf_free(hash);
+    perf_free(marks);
+    perf_free(packed);
+
+    return ret;
+}
@@ -0,0 +1,39 @@
+#ifndef _TSETLIN_PRUNE_H_
+#define _TSETLIN_PRUNE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+
+typedef struct {
+    size_t n_literal_before;
+    size_t n_literal_after;
+
+    size_t n_clause_before;
+    size_t n_clause_after;
+
+    size_t n_dead;       // include some x and not x, never fire
+    size_t n_cancelled;  // positive/negative pairs with the same literals
+    size_t n_stub;       // never-firing fillers keeping the pair layout
+} tsetlin_prune_stats_t;
+
+// Post-training compaction, in place.
+//
+// Literals with a state at or below threshold are dropped. Only states
+// above n_state / 2 take part in inference, so any threshold up to that
+// keeps predictions identical; higher values trade accuracy for size.
+//
+// Clauses that can never fire are removed, as are positive and negative
+// clauses of the same class with identical literals, since their votes
+// cancel. Clauses left on each class are packed to the front, n_clause
+// shrinks to twice the largest per-class count of either polarity, and
+// gaps are filled with a two-literal never-firing stub so that the
+// evaluate loop keeps its pairs.
+//
+// The pruned model is meant for inference: excluded literals are gone.
+// model must come from tsetlin_load() or tsetlin_unpack(), stubs are
+// allocated from its arena.
+int tsetlin_prune(Tsetlin* model, uint32_t threshold, tsetlin_prune_stats_t* stats);
+
+#endif // _TSETLIN_PRUNE_H_
@@ -0,0 +1,341 @@
+#include "tsetlin_ref.h"
+#include "clause.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+#include <memstat.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_ref);
+#endif
+
+static const char* TAG = "tsetlin_ref";
+
+// Copied from clause.c and tsetlin.c without the hot-path counters.
+// Change this file only when the behaviour of the library is meant to
+// change, never to make it faster.
+
+static float ref_random_float_01(void) {
+#if defined(__ZEPHYR__)
+    // uint32_t r = sys_rand32_get();
+    uint32_t r = pcg32_fast();
+#elif defined(ESP_PLATFORM)
+    uint32_t r = esp_random();
+#elif defined(__RTTHREAD__)
+    rt_uint32_t r = pcg32_fast();
+#else
+    uint32_t r = pcg32_fast();
+#endif
+
+    return (float)r / ((float)UINT32_MAX + 1.0f);
+}
+
+uint8_t tsetlin_ref_clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t clause_output, uint32_t n_state, uint32_t n_feature, float s) {
+    (void)n_feature;
+    // Want clause_output to be 1
+    float s1 = 1 / s;
+    float s2 = (s - 1) / s;
+    uint8_t changed = 0;
+
+    // Erase Pattern
+    // Reduce the number of included literals
+    if (clause_output == 0) {
+        // Update positive literals
+        for (size_t k = 0; k < clause->n_pos_literal; k++)
+        {
+            // uint32_t idx_literal = clause->position[k];
+            if ( clause->data[k] > 1 && ref_random_float_01() <= s1)
+            {
+                // Decrease state for included positive literal
+                clause->data[k]--;
+                changed = 1;
+            }
+        }
+
+        // Update negative literals
+        for (size_t k = 0; k < clause->n_neg_literal; k++)
+        {
+            // uint32_t idx_literal = clause->position[clause->n_pos_literal + k];
+            if (clause->data[clause->n_pos_literal + k] > 1 && ref_random_float_01() <= s1)
+            {
+                // Decrease state for included negative literal
+                clause->data[clause->n_pos_literal + k]--;
+                changed = 1;
+            }
+        }
+    }
+
+    // Recognize Pattern
+    // Increase the number of included literals
+    if (clause_output == 1) {
+        // Update positive literals
+        for (size_t k = 0; k < clause->n_pos_literal; k++)
+        {
+            uint32_t idx_literal = clause->position[k];
+            if (input[idx_literal] == 1 && clause->data[k] < n_state && ref_random_float_01() <= s2)
+            {
+                // Increase state for included positive literal
+                clause->data[k]++;
+                changed = 1;
+            }
+            else if (input[idx_literal] == 0 && clause->data[k] > 1 && ref_random_float_01() <= s1)
+            {
+                // Decrease state for excluded positive literal
+                clause->data[k]--;
+                changed = 1;
+            }
+        }
+
+        // Update negative literals
+        for (size_t k = 0; k < clause->n_neg_literal; k++)
+        {
+            uint32_t idx_literal = clause->position[clause->n_pos_literal + k];
+            if (input[idx_literal] == 1 && clause->data[clause->n_pos_literal + k] > 1 && ref_random_float_01() <= s1)
+            {
+                // Decrease state for included negative literal
+                clause->data[clause->n_pos_literal + k]--;
+                changed = 1;
+            }
+            else if (input[idx_literal] == 0 && clause->data[clause->n_pos_literal + k] < n_state && ref_random_float_01() <= s2)
+            {
+                // Increase state for excluded negative literal
+                clause->data[clause->n_pos_literal + k]++;
+                changed = 1;
+            }
+        }
+    }
+
+    return changed;
+}
+
+uint8_t tsetlin_ref_clause_update_type_II(ClauseCompressed* clause, uint8_t* input, uint32_t n_state, uint32_t n_feature) {
+    (void)n_feature;
+    uint8_t changed = 0;
+
+    // Update positive literals
+    for (size_t k = 0; k < clause->n_pos_literal; k++)
+    {
+        uint32_t idx_literal = clause->position[k];
+        if (input[idx_literal] == 0 && clause->data[k] <= n_state / 2)
+        {
+            // Increase state for included positive literal
+            if (clause->data[k] < n_state) {
+                clause->data[k]++;
+                changed = 1;
+            }
+        }
+    }
+
+    // Update negative literals
+    for (size_t k = 0; k < clause->n_neg_literal; k++)
+    {
+        uint32_t idx_literal = clause->position[clause->n_pos_literal + k];
+        if (input[idx_literal] == 1 && clause->data[clause->n_pos_literal + k] <= n_state / 2)
+        {
+            // Increase state for included negative literal
+            if (clause->data[clause->n_pos_literal + k] < n_state) {
+                clause->data[clause->n_pos_literal + k]++;
+                changed = 1;
+            }
+        }
+    }
+
+    return changed;
+}
+
+uint8_t tsetlin_ref_clause_evaluate(ClauseCompressed* clause, uint8_t* input, uint32_t n_state, uint32_t n_feature) {
+    (void)n_feature;
+    for (size_t k = 0; k < clause->n_pos_literal; k++)
+    {
+        uint32_t idx_literal = clause->position[k];
+        if (clause->data[k] > n_state / 2)
+        {
+            // positive literal is included
+            if (input[idx_literal] == 0)
+            {
+                return 0; // Clause evaluates to false
+            }
+        }
+    }
+
+    for (size_t k = 0; k < clause->n_neg_literal; k++)
+    {
+        uint32_t idx_literal = clause->position[clause->n_pos_literal + k];
+        if (clause->data[clause->n_pos_literal + k] > n_state / 2)
+        {
+            // negative literal is included
+            if (input[idx_literal] == 1)
+            {
+                return 0; // Clause evaluates to false
+            }
+        }
+    }
+
+    return 1; // Clause evaluates to true
+}
+
+static void mark_dirty(uint8_t* dirty, size_t index) {
+    if (dirty)
+        dirty[index >> 3] |= (uint8_t)(1 << (index & 7));
+}
+
+void tsetlin_ref_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s) {
+    tsetlin_ref_step_tracked(model, X_img, y_target, T, s, NULL);
+}
+
+void tsetlin_ref_step_tracked(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s, uint8_t* dirty) {
+    // Pair 1: Target class
+    int32_t class_sum = 0;
+    
+    //int8_t pos_clauses_eval[model->n_clause / 2];
+    int8_t* pos_clauses_eval = (int8_t*)perf_malloc(sizeof(int8_t) * model->n_clause / 2, PERF_MEM_SCRATCH);
+    if (!pos_clauses_eval) {
+       LOGE(TAG, "Failed to allocate memory for pos clauses!");
+       return;
+    }
+    memset(pos_clauses_eval, 0, sizeof(int8_t) * model->n_clause / 2);
+
+    //int8_t neg_clauses_eval[model->n_clause / 2];
+    int8_t* neg_clauses_eval = (int8_t*)perf_malloc(sizeof(int8_t) * model->n_clause / 2, PERF_MEM_SCRATCH);
+    if (!neg_clauses_eval) {
+        LOGE(TAG, "Failed to allocate memory for neg clauses!");
+        perf_free(pos_clauses_eval);
+        return;
+    }
+    memset(neg_clauses_eval, 0, sizeof(int8_t) * model->n_clause / 2);
+
+    for (size_t i = 0; i <(size_t) model->n_clause / 2; i++)
+    {
+        ClauseCompressed* p_clause = model->clauses_compressed[y_target * model->n_clause + i * 2];
+        ClauseCompressed* n_clause = model->clauses_compressed[y_target * model->n_clause + i * 2 + 1];
+
+        pos_clauses_eval[i] = tsetlin_ref_clause_evaluate(p_clause, X_img, model->n_state, model->n_feature);
+        neg_clauses_eval[i] = tsetlin_ref_clause_evaluate(n_clause, X_img, model->n_state, model->n_feature);
+
+        class_sum += pos_clauses_eval[i];
+        class_sum -= neg_clauses_eval[i];
+    }
+
+    // Clamp class_sum to [-T, T]
+    if (class_sum > (int32_t)T) {
+        class_sum = T;
+    } else if (class_sum < -(int32_t)T) {
+        class_sum = -T;
+    }
+
+    // Calculate probabilities. The arithmetic is unsigned integer, as in
+    // tsetlin.c, and stays that way here until both change together.
+    float c1 = (T - class_sum) / (2 * T);
+
+    // Update clauses for the target class
+    for (size_t i = 0; i <(size_t) model->n_clause / 2; i++) {
+        ClauseCompressed* p_clause = model->clauses_compressed[y_target * model->n_clause + i * 2];
+        ClauseCompressed* n_clause = model->clauses_compressed[y_target * model->n_clause + i * 2 + 1];
+
+        // Positive Clause: Type I Feedback
+        if (ref_random_float_01() <= c1) {
+            if (tsetlin_ref_clause_update_type_I(p_clause, X_img, pos_clauses_eval[i], model->n_state, model->n_feature, s))
+                mark_dirty(dirty, y_target * model->n_clause + i * 2);
+        }
+
+        // Negative Clause: Type II Feedback
+        if (neg_clauses_eval[i] == 1 && (ref_random_float_01() <= c1)) {
+            if (tsetlin_ref_clause_update_type_II(n_clause, X_img, model->n_state, model->n_feature))
+                mark_dirty(dirty, y_target * model->n_clause + i * 2 + 1);
+        }
+    }
+
+    // Pair 2: Non-target classes
+    uint8_t other_class = y_target;
+    while (other_class == y_target) {
+        #if defined(__ZEPHYR__)
+            /* Zephyr RTOS */
+            other_class = fast_rand() % model->n_class;
+        #elif defined(ESP_PLATFORM)
+            /* ESP-IDF */
+            other_class = esp_random() % model->n_class;
+        #elif defined(__RTTHREAD__)
+            /* RT-Thread RTOS */
+            other_class = fast_rand() % model->n_class;
+        #else
+            other_class = fast_rand() % model->n_class;
+        #endif
+    }
+
+    class_sum = 0;
+    memset(pos_clauses_eval, 0, sizeof(int8_t) * model->n_clause / 2);
+    memset(neg_clauses_eval, 0, sizeof(int8_t) * model->n_clause / 2);
+    for (size_t i = 0; i <(size_t) model->n_clause / 2; i++)
+    {
+        ClauseCompressed* p_clause = model->clauses_compressed[other_class * model->n_clause + i * 2];
+        ClauseCompressed* n_clause = model->clauses_compressed[other_class * model->n_clause + i * 2 + 1];
+
+        pos_clauses_eval[i] = tsetlin_ref_clause_evaluate(p_clause, X_img, model->n_state, model->n_feature);
+        neg_clauses_eval[i] = tsetlin_ref_clause_evaluate(n_clause, X_img, model->n_state, model->n_feature);
+
+        class_sum += pos_clauses_eval[i];
+        class_sum -= neg_clauses_eval[i];
+    }
+
+    // Clamp class_sum to [-T, T]
+    if (class_sum > (int32_t)T) {
+        class_sum = T;
+    } else if (class_sum < -(int32_t)T) {
+        class_sum = -T;
+    }
+
+    float c2 = (T + class_sum) / (2 * T);
+    for( size_t i = 0; i <(size_t) model->n_clause / 2; i++) {
+        ClauseCompressed* p_clause = model->clauses_compressed[other_class * model->n_clause + i * 2];
+        ClauseCompressed* n_clause = model->clauses_compressed[other_class * model->n_clause + i * 2 + 1];
+
+        // Positive Clause: Type II Feedback
+        if (pos_clauses_eval[i] == 1 && (ref_random_float_01() <= c2)) {
+            if (tsetlin_ref_clause_update_type_II(p_clause, X_img, model->n_state, model->n_feature))
+                mark_dirty(dirty, other_class * model->n_clause + i * 2);
+        }
+
+        // Negative Clause: Type I Feedback
+        if (neg_clauses_eval[i] == 1 && (ref_random_float_01() <= c2)) {
+            if (tsetlin_ref_clause_update_type_I(n_clause, X_img, neg_clauses_eval[i], model->n_state, model->n_feature, s))
+                mark_dirty(dirty, other_class * model->n_clause + i * 2 + 1);
+        }
+    }
+
+    perf_free(pos_clauses_eval);
+    perf_free(neg_clauses_eval);
+}
+
+int tsetlin_ref_evaluate(Tsetlin* model, uint8_t* input, int32_t *out_votes, uint8_t* out_class) {
+    memset(out_votes, 0, model->n_class * sizeof(int32_t));
+
+    for (size_t c = 0; c < model->n_class; c++)
+    {
+        for (uint32_t j = 0; j <(size_t) model->n_clause / 2; j++)
+        {
+            ClauseCompressed* p_clause = model->clauses_compressed[c * model->n_clause + j * 2];
+            ClauseCompressed* n_clause = model->clauses_compressed[c * model->n_clause + j * 2 + 1];
+
+            out_votes[c] += tsetlin_ref_clause_evaluate(p_clause, input, model->n_state, model->n_feature);
+            out_votes[c] -= tsetlin_ref_clause_evaluate(n_clause, input, model->n_state, model->n_feature);
+        }
+    }
+
+    // Find class with maximum votes
+    uint8_t max_class = 0;
+    int32_t max_votes = out_votes[0];
+    for (size_t c = 1; c < model->n_class; c++)
+    {
+        if (out_votes[c] > max_votes)
+        {
+            max_votes = out_votes[c];
+            max_class = c;
+        }
+    }
+
+    *out_class = max_class;
+
+    return 0;
+}
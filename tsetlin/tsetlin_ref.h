@@ -0,0 +1,26 @@
+#ifndef _TSETLIN_REF_H_
+#define _TSETLIN_REF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+
+// Reference implementation: the plain scalar evaluate and training code
+// of clause.c and tsetlin.c, kept as it is so that faster kernels have
+// something to be checked against (see lime-tm-conform).
+//
+// Any other path must give the same votes and class as
+// tsetlin_ref_evaluate(). Training must leave every state as
+// tsetlin_ref_step() does when both start from the same model and the
+// same fast_rand() stream, drawing from it in the same order.
+uint8_t tsetlin_ref_clause_evaluate(ClauseCompressed* clause, uint8_t* input, uint32_t n_state, uint32_t n_feature);
+uint8_t tsetlin_ref_clause_update_type_I(ClauseCompressed* clause, uint8_t* input, int8_t clause_output, uint32_t n_state, uint32_t n_feature, float s);
+uint8_t tsetlin_ref_clause_update_type_II(ClauseCompressed* clause, uint8_t* input, uint32_t n_state, uint32_t n_feature);
+
+int tsetlin_ref_evaluate(Tsetlin* model, uint8_t* input, int32_t* out_votes, uint8_t* out_class);
+
+void tsetlin_ref_step(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s);
+void tsetlin_ref_step_tracked(Tsetlin* model, uint8_t* X_img, int8_t y_target, uint32_t T, float s, uint8_t* dirty);
+
+#endif // _TSETLIN_REF_H_
@@ -0,0 +1,207 @@
+#include "tsetlin_save.h"
+#include "tsetlin_compact.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+#include <memstat.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_save);
+#endif
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif !defined(__ZEPHYR__) && !defined(ESP_PLATFORM) && !defined(__RTTHREAD__)
+    #define TSETLIN_SAVE_HAS_FSYNC 1
+    #include <unistd.h>
+#endif
+
+static const char* TAG = "tsetlin_save";
+
+static void file_buffer_append(ProtobufCBuffer* buffer, size_t len, const uint8_t* data) {
+    tsetlin_file_buffer_t* buf = (tsetlin_file_buffer_t*)buffer;
+    if (buf->error)
+        return;
+
+    if (fwrite(data, 1, len, buf->f) != len)
+        buf->error = 1;
+    buf->written += len;
+}
+
+void tsetlin_file_buffer_init(tsetlin_file_buffer_t* buf, FILE* f) {
+    memset(buf, 0, sizeof(tsetlin_file_buffer_t));
+    buf->base.append = file_buffer_append;
+    buf->f = f;
+}
+
+static void append_varint(tsetlin_file_buffer_t* buf, uint64_t v) {
+    uint8_t bytes[10];
+    size_t n = 0;
+    do {
+        bytes[n] = (uint8_t)(v & 0x7F);
+        v >>= 7;
+        if (v)
+            bytes[n] |= 0x80;
+        n++;
+    } while (v);
+
+    buf->base.append(&buf->base, n, bytes);
+}
+
+// Replace path with tmp_path. FAT cannot rename over an existing file,
+// so embedded targets remove it first: if power is lost in between,
+// tmp_path still holds the complete new model.
+static int replace_file(const char* tmp_path, const char* path) {
+#if defined(_WIN32)
+    if (!MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+        return -1;
+    return 0;
+#else
+#if !defined(TSETLIN_SAVE_HAS_FSYNC)
+    remove(path);
+#endif
+    return rename(tmp_path, path);
+#endif
+}
+
+static int checkpoint_begin(tsetlin_checkpoint_t* ckpt, const Tsetlin* model, const char* path, uint8_t compact) {
+    memset(ckpt, 0, sizeof(tsetlin_checkpoint_t));
+
+    const ProtobufCFieldDescriptor* field = protobuf_c_message_descriptor_get_field_by_name(&tsetlin__descriptor, "clauses_compressed");
+    if (!field)
+        return -1;
+
+    size_t len = strlen(path);
+    ckpt->path = (char*)perf_malloc(len + 1, PERF_MEM_SCRATCH);
+    ckpt->tmp_path = (char*)perf_malloc(len + 5, PERF_MEM_SCRATCH);
+    if (!ckpt->path || !ckpt->tmp_path) {
+        LOGE(TAG, "Failed to allocate memory");
+        tsetlin_checkpoint_abort(ckpt);
+        return -1;
+    }
+    memcpy(ckpt->path, path, len + 1);
+    memcpy(ckpt->tmp_path, path, len);
+    memcpy(ckpt->tmp_path + len, ".tmp", 5);
+
+    FILE* f = fopen(ckpt->tmp_path, "wb");
+    if (!f) {
+        LOGE(TAG, "Failed to open file %s", ckpt->tmp_path);
+        tsetlin_checkpoint_abort(ckpt);
+        return -1;
+    }
+
+    ckpt->model = model;
+    ckpt->clause_tag = (field->id << 3) | PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED;
+    ckpt->compact = compact;
+    ckpt->active = 1;
+    tsetlin_file_buffer_init(&ckpt->out, f);
+
+    // Everything but the clauses goes out in one go, so the version
+    // is known before the first clause when loading
+    Tsetlin header = *model;
+    header.n_clauses_compressed = 0;
+    header.clauses_compressed = NULL;
+    header.version = compact ? TSETLIN_VERSION_COMPACT : 0;
+    tsetlin__pack_to_buffer(&header, &ckpt->out.base);
+
+    return 0;
+}
+
+int tsetlin_checkpoint_begin(tsetlin_checkpoint_t* ckpt, const Tsetlin* model, const char* path) {
+    return checkpoint_begin(ckpt, model, path, 0);
+}
+
+int tsetlin_checkpoint_begin_compact(tsetlin_checkpoint_t* ckpt, const Tsetlin* model, const char* path) {
+    return checkpoint_begin(ckpt, model, path, 1);
+}
+
+int tsetlin_checkpoint_step(tsetlin_checkpoint_t* ckpt, size_t max_clauses) {
+    if (!ckpt->active)
+        return -1;
+
+    const Tsetlin* model = ckpt->model;
+    for (size_t n = 0; n < max_clauses && ckpt->next_clause < model->n_clauses_compressed; n++) {
+        const ClauseCompressed* clause = model->clauses_compressed[ckpt->next_clause++];
+
+        ClauseCompressed compact;
+        if (ckpt->compact) {
+            size_t bound = tsetlin_compact_bound(clause, model->n_feature);
+            if (bound > ckpt->scratch_size) {
+                uint8_t* scratch = (uint8_t*)perf_realloc(ckpt->scratch, bound, PERF_MEM_SCRATCH);
+                if (!scratch) {
+                    ckpt->out.error = 1;
+                    break;
+                }
+                ckpt->scratch = scratch;
+                ckpt->scratch_size = bound;
+            }
+
+            tsetlin_compact_encode(clause, model->n_feature, ckpt->scratch, &compact);
+            clause = &compact;
+        }
+
+        append_varint(&ckpt->out, ckpt->clause_tag);
+        append_varint(&ckpt->out, clause_compressed__get_packed_size(clause));
+        clause_compressed__pack_to_buffer(clause, &ckpt->out.base);
+    }
+
+    if (ckpt->out.error) {
+        LOGE(TAG, "Failed to write file %s", ckpt->tmp_path);
+        tsetlin_checkpoint_abort(ckpt);
+        return -1;
+    }
+
+    if (ckpt->next_clause < model->n_clauses_compressed)
+        return 1;
+
+    // Complete: flush to the medium, then swap it in
+    FILE* f = ckpt->out.f;
+    ckpt->out.f = NULL;
+
+    int ret = (fflush(f) == 0) ? 0 : -1;
+#if defined(TSETLIN_SAVE_HAS_FSYNC)
+    if (ret == 0)
+        ret = fsync(fileno(f));
+#endif
+    if (fclose(f) != 0)
+        ret = -1;
+
+    if (ret == 0)
+        ret = replace_file(ckpt->tmp_path, ckpt->path);
+
+    if (ret != 0)
+        LOGE(TAG, "Failed to commit %s", ckpt->path);
+
+    tsetlin_checkpoint_abort(ckpt);
+    return ret;
+}
+
+void tsetlin_checkpoint_abort(tsetlin_checkpoint_t* ckpt) {
+    if (ckpt->out.f) {
+        fclose(ckpt->out.f);
+        remove(ckpt->tmp_path);
+    }
+
+    perf_free(ckpt->path);
+    perf_free(ckpt->tmp_path);
+    perf_free(ckpt->scratch);
+    memset(ckpt, 0, sizeof(tsetlin_checkpoint_t));
+}
+
+int tsetlin_save(const Tsetlin* model, const char* path) {
+    tsetlin_checkpoint_t ckpt;
+    if (tsetlin_checkpoint_begin(&ckpt, model, path) != 0)
+        return -1;
+
+    return tsetlin_checkpoint_step(&ckpt, SIZE_MAX);
+}
+
+int tsetlin_save_compact(const Tsetlin* model, const char* path) {
+    tsetlin_checkpoint_t ckpt;
+    if (tsetlin_checkpoint_begin_compact(&ckpt, model, path) != 0)
+        return -1;
+
+    return tsetlin_checkpoint_step(&ckpt, SIZE_MAX);
+}
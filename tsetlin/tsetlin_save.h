@@ -0,0 +1,54 @@
+#ifndef _TSETLIN_SAVE_H_
+#define _TSETLIN_SAVE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+
+// ProtobufCBuffer that appends straight to a FILE, so packing never
+// holds a serialized copy of the model in memory
+typedef struct {
+    ProtobufCBuffer base;
+    FILE* f;
+    size_t written;
+    int error;
+} tsetlin_file_buffer_t;
+
+void tsetlin_file_buffer_init(tsetlin_file_buffer_t* buf, FILE* f);
+
+// Incremental checkpoint. The model is written to <path>.tmp a few
+// clauses per tsetlin_checkpoint_step() call, so training can interleave
+// with it, and renamed over <path> once complete. Each clause is packed
+// whole, but clauses written early may predate later training steps.
+typedef struct {
+    const Tsetlin* model;
+    char* path;
+    char* tmp_path;
+
+    tsetlin_file_buffer_t out;
+    uint32_t clause_tag;
+    size_t next_clause;
+
+    // Compact encoding scratch, see tsetlin_compact.h
+    uint8_t* scratch;
+    size_t scratch_size;
+
+    uint8_t compact;
+    uint8_t active;
+} tsetlin_checkpoint_t;
+
+int tsetlin_checkpoint_begin(tsetlin_checkpoint_t* ckpt, const Tsetlin* model, const char* path);
+int tsetlin_checkpoint_begin_compact(tsetlin_checkpoint_t* ckpt, const Tsetlin* model, const char* path);
+
+// Writes up to max_clauses clauses. Returns 1 while more remain, 0 once
+// the checkpoint has been committed, -1 on error (the target is untouched).
+int tsetlin_checkpoint_step(tsetlin_checkpoint_t* ckpt, size_t max_clauses);
+void tsetlin_checkpoint_abort(tsetlin_checkpoint_t* ckpt);
+
+// Full save with the same write-then-rename update
+int tsetlin_save(const Tsetlin* model, const char* path);
+int tsetlin_save_compact(const Tsetlin* model, const char* path);
+
+#endif // _TSETLIN_SAVE_H_
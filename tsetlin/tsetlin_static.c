@@ -0,0 +1,52 @@
+#include "tsetlin_static.h"
+
+// A clause fires when every included literal is true: input[position]
+// is 1 for a plain literal and 0 for a negated one.
+#define TSETLIN_STATIC_CLASS_VOTES(NAME, LIT_T)                                        \
+static int32_t NAME(const tsetlin_static_t* model, uint32_t c, const uint8_t* input) { \
+    const LIT_T* literal = (const LIT_T*)model->literal;                               \
+    const uint32_t* offset = model->clause_offset + c * model->n_clause;               \
+    const uint32_t n_clause = model->n_clause & ~1u;                                   \
+    int32_t votes = 0;                                                                 \
+    for (uint32_t j = 0; j < n_clause; j++) {                                          \
+        int32_t output = 1;                                                            \
+        for (uint32_t k = offset[j]; k < offset[j + 1]; k++) {                         \
+            LIT_T l = literal[k];                                                      \
+            if (input[l >> 1] == (l & 1)) {                                            \
+                output = 0;                                                            \
+                break;                                                                 \
+            }                                                                          \
+        }                                                                              \
+        votes += (j & 1) ? -output : output;                                           \
+    }                                                                                  \
+    return votes;                                                                      \
+}
+
+TSETLIN_STATIC_CLASS_VOTES(class_votes_16, uint16_t)
+TSETLIN_STATIC_CLASS_VOTES(class_votes_32, uint32_t)
+
+int32_t tsetlin_static_class_votes(const tsetlin_static_t* model, uint32_t c, const uint8_t* input) {
+    if (model->class_votes)
+        return model->class_votes[c](input);
+
+    return (model->literal_width == 2) ? class_votes_16(model, c, input) : class_votes_32(model, c, input);
+}
+
+int tsetlin_static_evaluate(const tsetlin_static_t* model, const uint8_t* input, int32_t* out_votes, uint8_t* out_class) {
+    for (uint32_t c = 0; c < model->n_class; c++) {
+        out_votes[c] = tsetlin_static_class_votes(model, c, input);
+    }
+
+    // Find class with maximum votes
+    uint8_t max_class = 0;
+    int32_t max_votes = out_votes[0];
+    for (uint32_t c = 1; c < model->n_class; c++) {
+        if (out_votes[c] > max_votes) {
+            max_votes = out_votes[c];
+            max_class = (uint8_t)c;
+        }
+    }
+
+    *out_class = max_class;
+    return 0;
+}
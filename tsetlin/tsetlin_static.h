@@ -0,0 +1,35 @@
+#ifndef _TSETLIN_STATIC_H_
+#define _TSETLIN_STATIC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Model compiled into the firmware as const tables, see lime-tm-codegen.
+//
+// Only included literals are kept. Literal k of the model is
+// literal[k] = position * 2 + negated, and clause i (class * n_clause + j)
+// owns literals clause_offset[i] .. clause_offset[i + 1]. Everything is
+// const, so the tables stay in flash and run in place; no protobuf
+// decoding and no heap is needed at boot.
+typedef int32_t (*tsetlin_static_class_fn)(const uint8_t* input);
+
+typedef struct {
+    uint32_t n_class;
+    uint32_t n_feature;
+    uint32_t n_clause;
+    uint8_t literal_width;      // 2 or 4 bytes
+
+    const uint32_t* clause_offset;
+    const void* literal;
+
+    // One generated function per class when built with --specialize,
+    // NULL otherwise
+    const tsetlin_static_class_fn* class_votes;
+} tsetlin_static_t;
+
+int32_t tsetlin_static_class_votes(const tsetlin_static_t* model, uint32_t c, const uint8_t* input);
+
+// Same result as tsetlin_evaluate() on the model it was generated from
+int tsetlin_static_evaluate(const tsetlin_static_t* model, const uint8_t* input, int32_t* out_votes, uint8_t* out_class);
+
+#endif // _TSETLIN_STATIC_H_
@@ -0,0 +1,330 @@
+#include "tsetlin_stream.h"
+#include "tsetlin_arena.h"
+#include "tsetlin_compact.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <logging.h>
+#include <memstat.h>
+
+#if defined(__ZEPHYR__)
+    LOG_MODULE_REGISTER(tsetlin_stream);
+#endif
+
+static const char* TAG = "tsetlin_stream";
+
+// Repeated message fields tracked per model
+#define STREAM_MAX_FIELDS 32
+
+typedef struct {
+    tsetlin_read_cb read;
+    void* ctx;
+
+    uint8_t* buf;
+    size_t cap;
+    size_t pos;
+    size_t fill;
+    uint8_t eof;
+} stream_t;
+
+// Make up to n contiguous bytes available at buf + pos, returns how many are
+static size_t stream_avail(stream_t* s, size_t n) {
+    if (s->fill - s->pos >= n)
+        return n;
+
+    memmove(s->buf, s->buf + s->pos, s->fill - s->pos);
+    s->fill -= s->pos;
+    s->pos = 0;
+
+    if (n > s->cap) {
+        uint8_t* buf = (uint8_t*)perf_realloc(s->buf, n, PERF_MEM_SCRATCH);
+        if (!buf) {
+            LOGE(TAG, "Failed to grow read buffer to %lu bytes", (unsigned long)n);
+            return 0;
+        }
+        s->buf = buf;
+        s->cap = n;
+    }
+
+    while (s->fill < n && !s->eof) {
+        size_t r = s->read(s->ctx, s->buf + s->fill, s->cap - s->fill);
+        if (r == 0)
+            s->eof = 1;
+        s->fill += r;
+    }
+
+    return s->fill < n ? s->fill : n;
+}
+
+static int stream_varint(stream_t* s, uint64_t* out) {
+    size_t avail = stream_avail(s, 10);
+    const uint8_t* p = s->buf + s->pos;
+
+    uint64_t v = 0;
+    for (size_t i = 0; i < avail; i++) {
+        v |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+        if ((p[i] & 0x80) == 0) {
+            s->pos += i + 1;
+            *out = v;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static int stream_skip(stream_t* s, uint64_t n) {
+    while (n > 0) {
+        size_t step = n < s->cap ? (size_t)n : s->cap;
+        size_t avail = stream_avail(s, step);
+        if (avail == 0)
+            return -1;
+        s->pos += avail;
+        n -= avail;
+    }
+    return 0;
+}
+
+static size_t file_read(void* ctx, uint8_t* buf, size_t size) {
+    return fread(buf, 1, size, (FILE*)ctx);
+}
+
+// Store a scalar field straight into the message struct
+static int set_scalar(void* message, const ProtobufCFieldDescriptor* field, uint8_t wire_type, uint64_t v, const uint8_t* raw) {
+    void* member = (uint8_t*)message + field->offset;
+
+    switch (field->type) {
+        case PROTOBUF_C_TYPE_INT32:
+        case PROTOBUF_C_TYPE_UINT32:
+        case PROTOBUF_C_TYPE_ENUM:
+            *(uint32_t*)member = (uint32_t)v;
+            break;
+        case PROTOBUF_C_TYPE_SINT32:
+            *(int32_t*)member = (int32_t)((uint32_t)v >> 1) ^ -(int32_t)(v & 1);
+            break;
+        case PROTOBUF_C_TYPE_BOOL:
+            *(protobuf_c_boolean*)member = v != 0;
+            break;
+        case PROTOBUF_C_TYPE_INT64:
+        case PROTOBUF_C_TYPE_UINT64:
+            *(uint64_t*)member = v;
+            break;
+        case PROTOBUF_C_TYPE_SINT64:
+            *(int64_t*)member = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+            break;
+        case PROTOBUF_C_TYPE_FIXED32:
+        case PROTOBUF_C_TYPE_SFIXED32:
+        case PROTOBUF_C_TYPE_FLOAT:
+            if (wire_type != PROTOBUF_C_WIRE_TYPE_32BIT)
+                return -1;
+            memcpy(member, raw, 4);
+            break;
+        case PROTOBUF_C_TYPE_FIXED64:
+        case PROTOBUF_C_TYPE_SFIXED64:
+        case PROTOBUF_C_TYPE_DOUBLE:
+            if (wire_type != PROTOBUF_C_WIRE_TYPE_64BIT)
+                return -1;
+            memcpy(member, raw, 8);
+            break;
+        default:
+            return -1;
+    }
+
+    if (field->flags & PROTOBUF_C_FIELD_FLAG_ONEOF)
+        *(uint32_t*)((uint8_t*)message + field->quantifier_offset) = field->id;
+    else if (field->label == PROTOBUF_C_LABEL_OPTIONAL && field->quantifier_offset)
+        *(protobuf_c_boolean*)((uint8_t*)message + field->quantifier_offset) = 1;
+
+    return 0;
+}
+
+// Append a sub-message to a repeated field, growing its pointer array.
+// The first array is sized from n_class * n_clause when those fields
+// came first, which is how every writer we know of orders them.
+static int push_message(tsetlin_arena_t* arena, Tsetlin* model, const ProtobufCFieldDescriptor* field, size_t* cap, ProtobufCMessage* sub) {
+    size_t* n = (size_t*)((uint8_t*)model + field->quantifier_offset);
+    void*** array = (void***)((uint8_t*)model + field->offset);
+
+    if (*n == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : (size_t)model->n_class * model->n_clause;
+        if (new_cap <= *n)
+            new_cap = 64;
+
+        void** grown = (void**)tsetlin_arena_alloc(arena, new_cap * sizeof(void*));
+        if (!grown)
+            return -1;
+        if (*n)
+            memcpy(grown, *array, *n * sizeof(void*));
+
+        *array = grown;
+        *cap = new_cap;
+    }
+
+    (*array)[(*n)++] = sub;
+    return 0;
+}
+
+// Compact clauses are decoded straight from the read buffer, so the
+// compact bytes never stay resident. That needs the version before the
+// clauses, as tsetlin_save() writes it; otherwise, and for clauses that
+// fall back to the packed fields, the clause is expanded in place.
+static ProtobufCMessage* unpack_clause(tsetlin_arena_t* arena, Tsetlin* model, const uint8_t* payload, size_t len) {
+    ClauseCompressed* clause = NULL;
+    if (model->version >= TSETLIN_VERSION_COMPACT) {
+        int ret = tsetlin_compact_unpack(payload, len, model->n_feature, arena, &clause);
+        if (ret <= 0)
+            return (ProtobufCMessage*)clause;
+    }
+
+    clause = clause_compressed__unpack(&arena->allocator, len, payload);
+    if (clause && tsetlin_compact_is_compact(clause) &&
+        tsetlin_compact_expand(clause, clause, model->n_feature, arena) != 0)
+        return NULL;
+
+    return (ProtobufCMessage*)clause;
+}
+
+static int decode_field(stream_t* s, tsetlin_arena_t* arena, Tsetlin* model, size_t* caps) {
+    const ProtobufCMessageDescriptor* desc = &tsetlin__descriptor;
+
+    uint64_t key;
+    if (stream_varint(s, &key) != 0)
+        return -1;
+
+    uint32_t tag = (uint32_t)(key >> 3);
+    uint8_t wire_type = (uint8_t)(key & 7);
+    const ProtobufCFieldDescriptor* field = protobuf_c_message_descriptor_get_field(desc, tag);
+
+    uint64_t v = 0;
+    const uint8_t* raw = NULL;
+    switch (wire_type) {
+        case PROTOBUF_C_WIRE_TYPE_VARINT:
+            if (stream_varint(s, &v) != 0)
+                return -1;
+            break;
+        case PROTOBUF_C_WIRE_TYPE_32BIT:
+        case PROTOBUF_C_WIRE_TYPE_64BIT: {
+            size_t len = (wire_type == PROTOBUF_C_WIRE_TYPE_32BIT) ? 4 : 8;
+            if (stream_avail(s, len) != len)
+                return -1;
+            raw = s->buf + s->pos;
+            s->pos += len;
+            break;
+        }
+        case PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED: {
+            if (stream_varint(s, &v) != 0)
+                return -1;
+
+            if (!field || (field->type != PROTOBUF_C_TYPE_MESSAGE &&
+                           field->type != PROTOBUF_C_TYPE_STRING &&
+                           field->type != PROTOBUF_C_TYPE_BYTES)) {
+                if (field)
+                    LOGW(TAG, "Skipping packed field %s", field->name);
+                return stream_skip(s, v);
+            }
+
+            size_t len = (size_t)v;
+            if (stream_avail(s, len) != len)
+                return -1;
+            const uint8_t* payload = s->buf + s->pos;
+            s->pos += len;
+
+            if (field->type == PROTOBUF_C_TYPE_MESSAGE) {
+                ProtobufCMessage* sub;
+                if (field->descriptor == &clause_compressed__descriptor)
+                    sub = unpack_clause(arena, model, payload, len);
+                else
+                    sub = protobuf_c_message_unpack(
+                        (const ProtobufCMessageDescriptor*)field->descriptor, &arena->allocator, len, payload);
+                if (!sub)
+                    return -1;
+
+                if (field->label == PROTOBUF_C_LABEL_REPEATED)
+                    return push_message(arena, model, field, &caps[field - desc->fields], sub);
+
+                *(ProtobufCMessage**)((uint8_t*)model + field->offset) = sub;
+                return 0;
+            }
+
+            // Strings and bytes are copied into the arena
+            uint8_t* copy = (uint8_t*)tsetlin_arena_alloc(arena, len + 1);
+            if (!copy)
+                return -1;
+            memcpy(copy, payload, len);
+            copy[len] = 0;
+
+            if (field->type == PROTOBUF_C_TYPE_STRING) {
+                *(char**)((uint8_t*)model + field->offset) = (char*)copy;
+            } else {
+                ProtobufCBinaryData* bd = (ProtobufCBinaryData*)((uint8_t*)model + field->offset);
+                bd->len = len;
+                bd->data = copy;
+            }
+            return 0;
+        }
+        default:
+            return -1;
+    }
+
+    if (!field)
+        return 0;
+
+    if (field->label == PROTOBUF_C_LABEL_REPEATED) {
+        LOGW(TAG, "Skipping repeated field %s", field->name);
+        return 0;
+    }
+
+    return set_scalar(model, field, wire_type, v, raw);
+}
+
+Tsetlin* tsetlin_load_stream(tsetlin_read_cb read, void* ctx) {
+    stream_t s;
+    memset(&s, 0, sizeof(s));
+    s.read = read;
+    s.ctx = ctx;
+    s.cap = TSETLIN_STREAM_BUFFER_SIZE;
+    s.buf = (uint8_t*)perf_malloc(s.cap, PERF_MEM_SCRATCH);
+    if (!s.buf) {
+        LOGE(TAG, "Failed to allocate read buffer");
+        return NULL;
+    }
+
+    // Unpack temporaries of the clauses count as scratch
+    protobuf_c_set_scratch_allocator(&tsetlin_scratch_allocator);
+
+    // The model must be the first allocation, see tsetlin_free()
+    tsetlin_arena_t* arena = tsetlin_arena_create(sizeof(Tsetlin) + TSETLIN_STREAM_ARENA_CHUNK);
+    if (!arena) {
+        LOGE(TAG, "Failed to allocate memory for model");
+        perf_free(s.buf);
+        return NULL;
+    }
+    arena->chunk_size = TSETLIN_STREAM_ARENA_CHUNK;
+
+    Tsetlin* model = (Tsetlin*)tsetlin_arena_alloc(arena, sizeof(Tsetlin));
+    tsetlin__init(model);
+
+    size_t caps[STREAM_MAX_FIELDS] = { 0 };
+    if (tsetlin__descriptor.n_fields > STREAM_MAX_FIELDS) {
+        LOGE(TAG, "Too many fields in Tsetlin message");
+        model = NULL;
+    }
+
+    while (model && stream_avail(&s, 1) > 0) {
+        if (decode_field(&s, arena, model, caps) != 0) {
+            LOGE(TAG, "Failed to decode model");
+            model = NULL;
+        }
+    }
+
+    perf_free(s.buf);
+    if (!model)
+        tsetlin_arena_destroy(arena);
+
+    return model;
+}
+
+Tsetlin* tsetlin_load_fp(FILE* f) {
+    return tsetlin_load_stream(file_read, f);
+}
@@ -0,0 +1,27 @@
+#ifndef _TSETLIN_STREAM_H_
+#define _TSETLIN_STREAM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tsetlin.pb-c.h>
+
+// Read buffer for the streaming decoder. It only grows past this if a
+// single clause message is larger.
+#define TSETLIN_STREAM_BUFFER_SIZE 1024
+
+// Arena growth step while streaming, the final size is not known up front
+#define TSETLIN_STREAM_ARENA_CHUNK (16 * 1024)
+
+// Returns the number of bytes read into buf, 0 at end of stream
+typedef size_t (*tsetlin_read_cb)(void* ctx, uint8_t* buf, size_t size);
+
+// Decode a Tsetlin message chunk by chunk. Each clause is unpacked
+// straight into the model's arena as soon as its bytes arrive, so peak
+// memory is the model plus one read buffer. Unknown fields are skipped.
+// Release the model with tsetlin_free().
+Tsetlin* tsetlin_load_stream(tsetlin_read_cb read, void* ctx);
+Tsetlin* tsetlin_load_fp(FILE* f);
+
+#endif // _TSETLIN_STREAM_H_
@@ -0,0 +1,50 @@
+#ifndef UTILS_FILE64_H
+#define UTILS_FILE64_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+
+// fseek()/ftell() take a long, which is 32 bits on Windows and 32-bit
+// targets. These use the 64-bit variants where the C library has them and
+// fail, instead of wrapping, on offsets the target cannot reach.
+
+#if defined(_WIN32)
+    /* ================= Windows ================= */
+    static inline int file_seek64(FILE* f, int64_t offset, int whence) {
+        return _fseeki64(f, offset, whence);
+    }
+
+    static inline int64_t file_tell64(FILE* f) {
+        return _ftelli64(f);
+    }
+
+#elif defined(__ZEPHYR__) || defined(ESP_PLATFORM) || defined(__RTTHREAD__)
+    /* ================= RTOS ================= */
+    static inline int file_seek64(FILE* f, int64_t offset, int whence) {
+        if (offset > LONG_MAX || offset < LONG_MIN)
+            return -1;
+        return fseek(f, (long)offset, whence);
+    }
+
+    static inline int64_t file_tell64(FILE* f) {
+        return ftell(f);
+    }
+
+#else
+    /* ================= POSIX ================= */
+    #include <sys/types.h>
+
+    // off_t is 64 bits with _FILE_OFFSET_BITS=64, set by the host build
+    static inline int file_seek64(FILE* f, int64_t offset, int whence) {
+        if ((int64_t)(off_t)offset != offset)
+            return -1;
+        return fseeko(f, (off_t)offset, whence);
+    }
+
+    static inline int64_t file_tell64(FILE* f) {
+        return (int64_t)ftello(f);
+    }
+#endif
+
+#endif /* UTILS_FILE64_H */